@@ -91,7 +91,8 @@ class Setup:
 
         self.include_dirs += self.check_valid_path([join(loc, "include")])
         self.library_dirs += self.check_valid_path([join(loc, "lib")])
-        self.extra_compile_args = ["-O3", "-ffast-math", "-DUSE_OPENBLAS"]
+        self.extra_compile_args = ["-O3", "-ffast-math", "-DUSE_OPENBLAS", "-fopenmp"]
+        self.extra_link_args += ["-fopenmp"]
         self.libraries += ["fftw3", "openblas"]
 
     def on_exit_message(self, blas_lib, fftw_lib):
@@ -169,8 +170,9 @@ class LinuxSetup(Setup):
             # "-mavx",
             "-g",
             "-DUSE_OPENBLAS",
+            "-fopenmp",
         ]
-        self.extra_link_args += ["-lm"]
+        self.extra_link_args += ["-lm", "-fopenmp"]
         self.include_dirs += [
             "/usr/include/",
             "/usr/include/openblas",
@@ -347,6 +349,7 @@ print(extra_link_args)
 source = [
     "src/c_lib/lib/angular_momentum/wigner_element.c",
     "src/c_lib/lib/angular_momentum/wigner_matrix.c",
+    "src/c_lib/lib/czjzek.c",
     "src/c_lib/lib/interpolation.c",
     "src/c_lib/lib/method.c",
     "src/c_lib/lib/mrsimulator.c",
@@ -354,6 +357,7 @@ source = [
     "src/c_lib/lib/frequency_averaging.c",
     "src/c_lib/lib/schemes.c",
     "src/c_lib/lib/simulation.c",
+    "src/c_lib/lib/transition_pathway.c",
 ]
 
 ext = ".pyx" if USE_CYTHON else ".c"
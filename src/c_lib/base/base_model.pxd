@@ -7,6 +7,7 @@
 #  Contact email = srivastava.89@osu.edu
 #
 from libcpp cimport bool as bool_t
+from libc.stdint cimport uint64_t
 
 
 cdef extern from "angular_momentum/wigner_element.h":
@@ -24,21 +25,40 @@ cdef extern from "angular_momentum/wigner_matrix.h":
 
 
 cdef extern from "schemes.h":
-    ctypedef struct MRS_averaging_scheme:
+    ctypedef struct MRS_orientation_tables:
         unsigned int total_orientations
 
+    ctypedef struct MRS_workspace:
+        pass
+
+    ctypedef struct MRS_spatial_basis:
+        pass
+
     ctypedef struct MRS_fftw_scheme:
         pass
 
-    MRS_averaging_scheme *MRS_create_averaging_scheme(
+    MRS_orientation_tables *MRS_create_orientation_tables(
                             unsigned int integration_density,
                             bool_t allow_4th_rank,
                             unsigned int n_gamma,
                             unsigned int integration_volume)
-    void MRS_free_averaging_scheme(MRS_averaging_scheme *scheme)
+    void MRS_free_orientation_tables(MRS_orientation_tables *scheme)
+    MRS_workspace *MRS_create_workspace(MRS_orientation_tables *scheme)
+    void MRS_free_workspace(MRS_workspace *workspace)
     MRS_fftw_scheme *create_fftw_scheme(unsigned int total_orientations,
                                     unsigned int number_of_sidebands)
     void MRS_free_fftw_scheme(MRS_fftw_scheme *fftw_scheme)
+    MRS_orientation_tables *MRS_acquire_orientation_tables(
+                            unsigned int integration_density,
+                            bool_t allow_4th_rank,
+                            unsigned int n_gamma,
+                            unsigned int integration_volume)
+    void MRS_release_orientation_tables(MRS_orientation_tables *scheme)
+    void MRS_clear_cache()
+    void MRS_set_fftw_plan_rigor(unsigned int rigor)
+    int MRS_import_fftw_wisdom(const char *filename)
+    int MRS_export_fftw_wisdom(const char *filename)
+    unsigned long MRS_fftw_tuned_plan_count()
 
 
 cdef extern from "mrsimulator.h":
@@ -47,7 +67,7 @@ cdef extern from "mrsimulator.h":
         double rotor_frequency_in_Hz
         double rotor_angle_in_rad
 
-    MRS_plan *MRS_create_plan(MRS_averaging_scheme *scheme, unsigned int number_of_sidebands,
+    MRS_plan *MRS_create_plan(MRS_orientation_tables *scheme, unsigned int number_of_sidebands,
                           double rotor_frequency_in_Hz,
                           double rotor_angle_in_rad, double increment,
                           bool_t allow_4th_rank)
@@ -96,7 +116,7 @@ cdef extern from "method.h":
         unsigned int n_events           # The number of events.
 
     MRS_dimension *MRS_create_dimensions(
-        MRS_averaging_scheme *scheme,
+        MRS_orientation_tables *scheme,
         int *count,
         double *coordinates_offset,
         double *increment,
@@ -112,6 +132,75 @@ cdef extern from "method.h":
 
 
 cdef extern from "simulation.h":
+    ctypedef struct MRS_simulation_plan:
+        pass
+
+    MRS_simulation_plan *MRS_create_simulation_plan(
+        int n_points,
+        int n_dimension,
+        int *count,
+        double *coordinates_offset,
+        double *increment,
+        double *fractions,
+        double *magnetic_flux_density_in_T,
+        double *rotor_frequency_in_Hz,
+        double *rotor_angle_in_rad,
+        int *n_events,
+        unsigned int *number_of_sidebands,
+        unsigned int integration_density,
+        unsigned int integration_volume,
+        unsigned int n_gamma,
+        bool_t allow_4th_rank,
+        bool_t interpolation,
+        unsigned int interpolate_type,
+        bool_t *freq_contrib,
+        double *affine_matrix,
+        int n_threads,
+        )
+
+    void MRS_free_simulation_plan(MRS_simulation_plan *plan)
+
+    void MRS_set_simulation_plan_isotropic_convolution(
+        MRS_simulation_plan *plan, bool_t enable)
+
+    void MRS_set_simulation_plan_amplitude_threshold(
+        MRS_simulation_plan *plan, double threshold)
+
+    void MRS_run_simulation_plan(
+        MRS_simulation_plan *plan,
+        double *spec,
+        bool_t decompose_spectrum,
+        int n_spin_systems,
+        site_struct *sites,
+        coupling_struct *couplings,
+        float **transition_pathways,
+        double **transition_pathway_weights,
+        int *pathway_count,
+        int *pathway_increment,
+        double *scale,
+        ) nogil
+
+    void MRS_run_simulation_plan_single_site(
+        MRS_simulation_plan *plan,
+        double *spec,
+        bool_t decompose_spectrum,
+        int n_spin_systems,
+        float spin,
+        double gyromagnetic_ratio,
+        double *isotropic_chemical_shift_in_ppm,
+        double *shielding_symmetric_zeta_in_ppm,
+        double *shielding_symmetric_eta,
+        double *shielding_orientation,
+        double *quadrupolar_Cq_in_Hz,
+        double *quadrupolar_eta,
+        double *quadrupolar_orientation,
+        float *transition_pathway,
+        double *transition_pathway_weight,
+        int pathway_count,
+        int pathway_increment,
+        double *scale,
+        ) nogil
+
     void mrsimulator_core(
         # spectrum information and related amplitude
         double *spec,
@@ -148,12 +237,74 @@ cdef extern from "simulation.h":
         coupling_struct *couplings,
         float *transition_pathway,    # Pointer to a list of transitions.
         double *transition_pathway_weight,  # The complex weight of transition pathway.
+        double weight,                # the scaling factor (abundance) of spectrum.
         int n_dimension,              # the number of dimensions.
         MRS_dimension *dimensions,    # the dimensions within method.
         MRS_fftw_scheme *fftw_scheme, # the fftw scheme
-        MRS_averaging_scheme *scheme, # the powder averaging scheme
+        MRS_orientation_tables *scheme, # the powder averaging scheme
+        MRS_workspace *workspace,     # the scheme workspace
+        MRS_spatial_basis *basis,     # the spatial basis of spin system, or NULL
         bool_t interpolation,
         unsigned int interpolate_type,
         bool_t *freq_contrib,
         double *affine_matrix,
         )
+
+    void mrsimulator_core_batch(
+        # spectrum information and related amplitude
+        double *spec,
+        int n_points,
+        bool_t decompose_spectrum,
+
+        # spin systems
+        int n_spin_systems,
+        site_struct *sites,
+        coupling_struct *couplings,
+        float **transition_pathways,
+        double **transition_pathway_weights,
+        int *pathway_count,
+        int *pathway_increment,
+        double *scale,
+
+        # method
+        int n_dimension,
+        int *count,
+        double *coordinates_offset,
+        double *increment,
+        double *fractions,
+        double *magnetic_flux_density_in_T,
+        double *rotor_frequency_in_Hz,
+        double *rotor_angle_in_rad,
+        int *n_events,
+        unsigned int *number_of_sidebands,
+
+        # powder orientation average
+        unsigned int integration_density,
+        unsigned int integration_volume,
+        unsigned int n_gamma,
+        bool_t allow_4th_rank,
+        bool_t interpolation,
+        unsigned int interpolate_type,
+        bool_t *freq_contrib,
+        double *affine_matrix,
+        int n_threads,
+        ) nogil
+
+
+cdef extern from "czjzek.h":
+    void MRS_czjzek_histogram(double *hist, unsigned int n_x, double x_min,
+                            double x_max, unsigned int n_y, double y_min,
+                            double y_max, const double *T0, double scale,
+                            unsigned long size, bool_t polar, uint64_t seed) nogil
+
+cdef extern from "transition_pathway.h":
+    void MRS_transition_pathways(unsigned int n_events, const unsigned int *counts,
+                            const float *segments, unsigned int n_sites,
+                            float *pathways) nogil
+
+    void MRS_transition_pathway_weights(unsigned int n_pathways, unsigned int n_events,
+                            unsigned int n_sites, const float *pathways,
+                            const float *spins, unsigned int event_1,
+                            unsigned int event_2, const double *alpha,
+                            const double *beta, const double *gamma,
+                            double *weights) nogil
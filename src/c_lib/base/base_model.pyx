@@ -1,6 +1,9 @@
 cimport base_model as clib
 from libcpp cimport bool as bool_t
+from libc.stdint cimport uint64_t
+from libc.stdlib cimport malloc, calloc, free
 from numpy cimport ndarray
+import os
 import numpy as np
 import cython
 
@@ -9,397 +12,554 @@ __email__ = "srivastava.89@osu.edu"
 
 clib.generate_tables()
 
-@cython.profile(False)
-@cython.boundscheck(False)
-@cython.wraparound(False)
-def core_simulator(method,
-       list spin_systems,
-       int verbose=0,  # for debug purpose only.
-       unsigned int number_of_sidebands=90,
-       unsigned int integration_density=72,
-       unsigned int decompose_spectrum=0,
-       unsigned int integration_volume=1,
-       unsigned int isotropic_interpolation=0,
-       unsigned int number_of_gamma_angles=1,
-       bool_t interpolation=True,
-       bool_t auto_switch=True):
-    """core simulator init"""
-
-# initialization and config
-    # observed spin is always channel at index 0_______________________________________
-    channel = method.channels[0].symbol
-    cdef double spin_quantum_number = method.channels[0].spin
-
-    # gyromagnetic ratio and reverse axis factor
-    cdef gyromagnetic_ratio = method.channels[0].gyromagnetic_ratio
-    cdef double factor = 1.0
-    if gyromagnetic_ratio > 0.0:
-        factor = -1.0
-
-    # config for spin I=0.5
-    cdef bool_t allow_4th_rank = 0
-    if spin_quantum_number > 0.5:
-        allow_4th_rank = 1
-
-    # transitions of the observed spin
-    cdef int transition_increment, number_of_transitions, i
-    cdef ndarray[float, ndim=1] transition_pathway_c
-    cdef ndarray[double, ndim=1] transition_pathway_weight_c
-
-# create averaging scheme _____________________________________________________
-    cdef clib.MRS_averaging_scheme *averaging_scheme
-    averaging_scheme = clib.MRS_create_averaging_scheme(
-        integration_density=integration_density, allow_4th_rank=allow_4th_rank,
-        n_gamma=number_of_gamma_angles, integration_volume=integration_volume
+# The fftw wisdom file. Plans tuned with the `measure` or `patient` rigor are
+# exported to this file and imported in the subsequent sessions.
+_fftw_wisdom_file = os.path.join(
+    os.path.expanduser("~"), ".mrsimulator", "fftw_wisdom"
+)
+_fftw_wisdom_imported = set()
+
+
+def set_fftw_wisdom_file(filename):
+    """Set the file for the persistence of the fftw wisdom. A None value disables
+    the import and export of the wisdom."""
+    global _fftw_wisdom_file
+    _fftw_wisdom_file = None if filename is None else os.fspath(filename)
+
+
+def _import_fftw_wisdom():
+    if _fftw_wisdom_file is None or _fftw_wisdom_file in _fftw_wisdom_imported:
+        return
+    _fftw_wisdom_imported.add(_fftw_wisdom_file)
+    if os.path.isfile(_fftw_wisdom_file):
+        clib.MRS_import_fftw_wisdom(os.fsencode(_fftw_wisdom_file))
+
+
+def _export_fftw_wisdom():
+    """Write the accumulated wisdom to a temporary file, which then replaces the
+    wisdom file, so that the concurrent processes never read a partial file."""
+    if _fftw_wisdom_file is None:
+        return
+    temp = f"{_fftw_wisdom_file}.{os.getpid()}.tmp"
+    try:
+        os.makedirs(os.path.dirname(_fftw_wisdom_file) or ".", exist_ok=True)
+        if clib.MRS_export_fftw_wisdom(os.fsencode(temp)):
+            os.replace(temp, _fftw_wisdom_file)
+    except OSError:
+        pass
+
+
+def _as_array(item, size, default=0.0):
+    """Return a contiguous float64 array of the given size from an item broadcast
+    to the size. A None item is replaced by the default."""
+    item = default if item is None else item
+    return np.ascontiguousarray(
+        np.broadcast_to(np.asarray(item, dtype=np.float64), size).ravel()
     )
 
-# create C spectral dimensions ________________________________________________
-    cdef int n_dimension = len(method.spectral_dimensions)
-
-    n_points = 1
-    cdef int n_ev
-    cdef ndarray[int] n_event
-    cdef ndarray[double] magnetic_flux_density_in_T, frac
-    cdef ndarray[double] srfiH
-    cdef ndarray[double] rair
-    cdef ndarray[int] cnt
-    cdef ndarray[double] coord_off
-    cdef ndarray[double] incre
-    cdef ndarray[unsigned int] n_dim_sidebands
-
-    freq_contrib = np.asarray([])
-
-    fr = []
-    Bo = []
-    vr = []
-    th = []
-    event_i = []
-    count = []
-    increment = []
-    coordinates_offset = []
-    dim_sidebands = []
-
-    for i, dim in enumerate(method.spectral_dimensions):
-        n_ev = 0
-        track = []
-        for event in dim.events:
-            if event.__class__.__name__ != "MixingEvent":
-                freq_contrib = np.append(freq_contrib, event._freq_contrib_flags())
-
-                if event.rotor_frequency < 1.0e-3:
-                    rotor_frequency_in_Hz = 1.0e-6
-                    rotor_angle_in_rad = event.rotor_angle
-                else:
-                    rotor_frequency_in_Hz = event.rotor_frequency
-                    rotor_angle_in_rad = event.rotor_angle
-
-                track.append(event.rotor_frequency < 1e12 and event.rotor_frequency != 0)
-
-                fr.append(event.fraction) # fraction
-                Bo.append(event.magnetic_flux_density)  # in T
-                vr.append(rotor_frequency_in_Hz) # in Hz
-                th.append(rotor_angle_in_rad) # in rad
-                n_ev +=1
-
-        n_points *= dim.count
-
-        count.append(dim.count)
-        offset = dim.spectral_width / 2.0
-        coordinates_offset.append(-dim.reference_offset * factor - offset)
-        increment.append(dim.spectral_width / dim.count)
-        event_i.append(n_ev)
-
-        dim_sidebands.append(number_of_sidebands if np.any(track) else 1)
-
-        if dim.origin_offset is None:
-            dim.origin_offset = np.abs(Bo[0] * gyromagnetic_ratio * 1e6)
-
-    frac = np.asarray(fr, dtype=np.float64)
-    magnetic_flux_density_in_T = np.asarray(Bo, dtype=np.float64)
-    srfiH = np.asarray(vr, dtype=np.float64)
-    rair = np.asarray(th, dtype=np.float64)
-    cnt = np.asarray(count, dtype=np.int32)
-    incre = np.asarray(increment, dtype=np.float64)
-    coord_off = np.asarray(coordinates_offset, dtype=np.float64)
-    n_event = np.asarray(event_i, dtype=np.int32)
-    n_dim_sidebands = np.asarray(dim_sidebands, dtype=np.uint32)
-
-    # # special 1D case with 1 event.
-    # if np.all(srfiH == 1e-3) and np.all(rair - rair[0] == 0):
-    #     # rair[:] = 0.0
-    #     n_dim_sidebands[0] = 1
-    # if np.all(srfiH == 1e12):
-    #     n_dim_sidebands[0] = 1
-
-    if srfiH.size == 1 and srfiH[0] == 1e-6 and auto_switch:
-        rair[0] = 0.0
-        n_dim_sidebands[0] = 1
-
-    # create spectral_dimensions
-    dimensions = clib.MRS_create_dimensions(averaging_scheme, &cnt[0],
-        &coord_off[0], &incre[0], &frac[0], &magnetic_flux_density_in_T[0],
-        &srfiH[0], &rair[0], &n_event[0], n_dimension, &n_dim_sidebands[0])
-
-# normalization factor for the spectrum
-    norm = np.abs(np.prod(incre))
-
-# create fftw scheme __________________________________________________________
-    cdef unsigned int max_sidebands = n_dim_sidebands.max()
-    cdef clib.MRS_fftw_scheme *fftw_scheme
-    fftw_scheme = clib.create_fftw_scheme(averaging_scheme.total_orientations, max_sidebands)
-# _____________________________________________________________________________
-
-# frequency contrib
-    cdef ndarray[bool_t] f_contrib = np.asarray(freq_contrib, dtype=bool)
-
-# affine transformation
-    cdef ndarray[double] affine_matrix_c
-    if method.affine_matrix is None:
-        affine_matrix_c = np.asarray([1, 0, 0, 1], dtype=np.float64)
-    else:
-        increment_fraction = [incre/item for item in incre]
-        matrix = np.asarray(method.affine_matrix).ravel() * np.asarray(increment_fraction).ravel()
-        affine_matrix_c = np.asarray(matrix, dtype=np.float64)
-        if affine_matrix_c[2] != 0:
-            affine_matrix_c[2] /= affine_matrix_c[0]
-            affine_matrix_c[3] -=  affine_matrix_c[1]*affine_matrix_c[2]
-
-# sites _______________________________________________________________________________
-    p_isotopes = None
-
-    cdef int number_of_sites, number_of_couplings, p_number_of_sites=0
-    cdef ndarray[int] spin_index_ij
-    cdef ndarray[float] spin_i
-    cdef ndarray[double] gyromagnetic_ratio_i
-
-    # CSA
-    cdef ndarray[double] iso_n
-    cdef ndarray[double] zeta_n
-    cdef ndarray[double] eta_n
-    cdef ndarray[double] ori_n
-
-    # quad
-    cdef ndarray[double] Cq_e
-    cdef ndarray[double] eta_e
-    cdef ndarray[double] ori_e
-
-    # J-coupling
-    cdef ndarray[double] iso_j
-    cdef ndarray[double] zeta_j
-    cdef ndarray[double] eta_j
-    cdef ndarray[double] ori_j
-
-    # quad
-    cdef ndarray[double] D_d
-    cdef ndarray[double] eta_d
-    cdef ndarray[double] ori_d
-
-    cdef int trans__, pathway_increment, pathway_count, transition_count_per_pathway
-    cdef ndarray[double, ndim=1] amp = np.zeros(2 * n_points, dtype=np.float64)
-    amp1 = np.zeros(n_points, dtype=np.complex128)
-    amp_individual = []
-
-    cdef clib.site_struct sites_c
-    cdef clib.coupling_struct couplings_c
-
-    # index_ = []
-
-    # -------------------------------------------------------------------------
-    # sample __________________________________________________________________
-    for spin_sys in spin_systems:
-        abundance = spin_sys.abundance
-        isotopes = [site.isotope.symbol for site in spin_sys.sites]
-        if channel not in isotopes:
-            if decompose_spectrum == 1:
-                amp_individual.append(np.zeros(method.shape()))
-            continue
 
-        # sub_sites = [site for site in spin_sys.sites if site.isotope.symbol == isotope]
-        # index_.append(index)
-        number_of_sites = len(spin_sys.sites)
+cdef class CompiledMethod:
+    """A method compiled for the repeated simulation of spectra.
+
+    The compiled method holds the spectral dimensions, the powder orientation tables,
+    the fftw plans, and the thread workspaces of the C simulation plan, along with the
+    transition pathways evaluated for the spin systems. Subsequent calls to the
+    `simulate` method, for example, from a least-squares fit where only the tensor
+    parameters change, therefore, only evaluate the spin systems.
+
+    The method is compiled at the time of creation. Changes to the method attributes
+    afterwards are not reflected in the compiled method.
+
+    Args:
+        method: The Method object.
+        int number_of_sidebands: The number of sidebands.
+        int integration_density: The integration density.
+        int decompose_spectrum: If 1, return a list of spectra, one per spin system.
+        int integration_volume: 0-octant, 1-hemisphere, 2-sphere.
+        int isotropic_interpolation: 0-linear, 1-Gaussian.
+        int number_of_gamma_angles: The number of gamma angles.
+        bool interpolation: If true, perform a 1D interpolation.
+        bool auto_switch: If true, simulate static spectra without sidebands.
+        int number_of_threads: The number of threads.
+        int fftw_plan_rigor: 0-estimate, 1-measure, 2-patient.
+        float amplitude_threshold: The fraction of the largest amplitude below which
+            the octants of a sideband are skipped.
+
+    Example:
+        >>> compiled = CompiledMethod(method, **sim.config.get_int_dict()) # doctest:+SKIP
+        >>> spectrum = compiled.simulate(sim.spin_systems) # doctest:+SKIP
+    """
+    cdef clib.MRS_simulation_plan *plan
+    cdef object method
+    cdef str channel
+    cdef double spin_quantum_number
+    cdef double gyromagnetic_ratio
+    cdef int n_points
+    cdef double norm
+    cdef unsigned int decompose_spectrum
+    cdef dict pathways
+
+    def __cinit__(self, method,
+           int verbose=0,  # for debug purpose only.
+           unsigned int number_of_sidebands=90,
+           unsigned int integration_density=72,
+           unsigned int decompose_spectrum=0,
+           unsigned int integration_volume=1,
+           unsigned int isotropic_interpolation=0,
+           unsigned int number_of_gamma_angles=1,
+           bool_t interpolation=True,
+           bool_t auto_switch=True,
+           int number_of_threads=1,
+           unsigned int fftw_plan_rigor=0,
+           bool_t isotropic_shift_convolution=False,
+           double amplitude_threshold=0.0):
+        self.plan = NULL
+
+# initialization and config
+        # observed spin is always channel at index 0_______________________________________
+        channel = method.channels[0].symbol
+        cdef double spin_quantum_number = method.channels[0].spin
+
+        # gyromagnetic ratio and reverse axis factor
+        cdef gyromagnetic_ratio = method.channels[0].gyromagnetic_ratio
+        cdef double factor = 1.0
+        if gyromagnetic_ratio > 0.0:
+            factor = -1.0
+
+        # config for spin I=0.5
+        cdef bool_t allow_4th_rank = 0
+        if spin_quantum_number > 0.5:
+            allow_4th_rank = 1
+
+        cdef int i
+
+    # create C spectral dimensions ________________________________________________
+        cdef int n_dimension = len(method.spectral_dimensions)
+
+        n_points = 1
+        cdef int n_ev
+        cdef ndarray[int] n_event
+        cdef ndarray[double] magnetic_flux_density_in_T, frac
+        cdef ndarray[double] srfiH
+        cdef ndarray[double] rair
+        cdef ndarray[int] cnt
+        cdef ndarray[double] coord_off
+        cdef ndarray[double] incre
+        cdef ndarray[unsigned int] n_dim_sidebands
+
+        freq_contrib = np.asarray([])
+
+        fr = []
+        Bo = []
+        vr = []
+        th = []
+        event_i = []
+        count = []
+        increment = []
+        coordinates_offset = []
+        dim_sidebands = []
+
+        for i, dim in enumerate(method.spectral_dimensions):
+            n_ev = 0
+            track = []
+            for event in dim.events:
+                if event.__class__.__name__ != "MixingEvent":
+                    freq_contrib = np.append(freq_contrib, event._freq_contrib_flags())
+
+                    if event.rotor_frequency < 1.0e-3:
+                        rotor_frequency_in_Hz = 1.0e-6
+                        rotor_angle_in_rad = event.rotor_angle
+                    else:
+                        rotor_frequency_in_Hz = event.rotor_frequency
+                        rotor_angle_in_rad = event.rotor_angle
+
+                    track.append(event.rotor_frequency < 1e12 and event.rotor_frequency != 0)
+
+                    fr.append(event.fraction) # fraction
+                    Bo.append(event.magnetic_flux_density)  # in T
+                    vr.append(rotor_frequency_in_Hz) # in Hz
+                    th.append(rotor_angle_in_rad) # in rad
+                    n_ev +=1
+
+            n_points *= dim.count
+
+            count.append(dim.count)
+            offset = dim.spectral_width / 2.0
+            coordinates_offset.append(-dim.reference_offset * factor - offset)
+            increment.append(dim.spectral_width / dim.count)
+            event_i.append(n_ev)
+
+            dim_sidebands.append(number_of_sidebands if np.any(track) else 1)
+
+            if dim.origin_offset is None:
+                dim.origin_offset = np.abs(Bo[0] * gyromagnetic_ratio * 1e6)
+
+        frac = np.asarray(fr, dtype=np.float64)
+        magnetic_flux_density_in_T = np.asarray(Bo, dtype=np.float64)
+        srfiH = np.asarray(vr, dtype=np.float64)
+        rair = np.asarray(th, dtype=np.float64)
+        cnt = np.asarray(count, dtype=np.int32)
+        incre = np.asarray(increment, dtype=np.float64)
+        coord_off = np.asarray(coordinates_offset, dtype=np.float64)
+        n_event = np.asarray(event_i, dtype=np.int32)
+        n_dim_sidebands = np.asarray(dim_sidebands, dtype=np.uint32)
+
+        # # special 1D case with 1 event.
+        # if np.all(srfiH == 1e-3) and np.all(rair - rair[0] == 0):
+        #     # rair[:] = 0.0
+        #     n_dim_sidebands[0] = 1
+        # if np.all(srfiH == 1e12):
+        #     n_dim_sidebands[0] = 1
+
+        if srfiH.size == 1 and srfiH[0] == 1e-6 and auto_switch:
+            rair[0] = 0.0
+            n_dim_sidebands[0] = 1
+
+    # normalization factor for the spectrum
+        norm = np.abs(np.prod(incre))
+
+    # frequency contrib
+        cdef ndarray[bool_t] f_contrib = np.asarray(freq_contrib, dtype=bool)
+
+    # affine transformation
+        cdef ndarray[double] affine_matrix_c
+        if method.affine_matrix is None:
+            affine_matrix_c = np.asarray([1, 0, 0, 1], dtype=np.float64)
+        else:
+            increment_fraction = [incre/item for item in incre]
+            matrix = np.asarray(method.affine_matrix).ravel() * np.asarray(increment_fraction).ravel()
+            affine_matrix_c = np.asarray(matrix, dtype=np.float64)
+            if affine_matrix_c[2] != 0:
+                affine_matrix_c[2] /= affine_matrix_c[0]
+                affine_matrix_c[3] -=  affine_matrix_c[1]*affine_matrix_c[2]
+
+    # the C simulation plan. The plan copies the arrays.
+        clib.MRS_set_fftw_plan_rigor(fftw_plan_rigor)
+        if fftw_plan_rigor > 0:
+            _import_fftw_wisdom()
+        cdef unsigned long tuned_plans = clib.MRS_fftw_tuned_plan_count()
+        self.plan = clib.MRS_create_simulation_plan(
+            n_points,
+            n_dimension,      # The total number of spectroscopic dimensions.
+            &cnt[0],
+            &coord_off[0],
+            &incre[0],
+            &frac[0],
+            &magnetic_flux_density_in_T[0],
+            &srfiH[0],
+            &rair[0],
+            &n_event[0],
+            &n_dim_sidebands[0],
+            integration_density,
+            integration_volume,
+            number_of_gamma_angles,
+            allow_4th_rank,
+            interpolation,
+            isotropic_interpolation,
+            &f_contrib[0],
+            &affine_matrix_c[0],
+            number_of_threads,
+        )
+        if clib.MRS_fftw_tuned_plan_count() != tuned_plans:
+            _export_fftw_wisdom()
+        clib.MRS_set_simulation_plan_isotropic_convolution(
+            self.plan, isotropic_shift_convolution
+        )
+        clib.MRS_set_simulation_plan_amplitude_threshold(self.plan, amplitude_threshold)
+
+        self.method = method
+        self.channel = channel
+        self.spin_quantum_number = spin_quantum_number
+        self.gyromagnetic_ratio = gyromagnetic_ratio
+        self.n_points = n_points
+        self.norm = norm
+        self.decompose_spectrum = decompose_spectrum
+        self.pathways = {}
+
+    def __dealloc__(self):
+        if self.plan != NULL:
+            clib.MRS_free_simulation_plan(self.plan)
+
+    @cython.profile(False)
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def simulate(self, list spin_systems):
+        """Simulate the spectrum from a list of spin systems.
+
+        Args:
+            list spin_systems: A list of SpinSystem objects.
+
+        Returns:
+            A numpy array of the spectrum, or a list of arrays, one per spin system,
+            when `decompose_spectrum` is 1.
+        """
+        # sites ___________________________________________________________________
+        cdef int i, number_of_sites, number_of_couplings
+        cdef int n_points = self.n_points
+        cdef unsigned int decompose_spectrum = self.decompose_spectrum
+        channel = self.channel
+        method = self.method
+        from mrsimulator.method.utils import coupled_site_pairs
+
+        cdef ndarray[int] spin_index_ij
+        cdef ndarray[float] spin_i
+        cdef ndarray[double] gyromagnetic_ratio_i
 
-        # ------------------------------------------------------------------------
-        #                          Site specification
-        # ------------------------------------------------------------------------
         # CSA
-        spin_i = np.empty(number_of_sites, dtype=np.float32)
-        gyromagnetic_ratio_i = np.empty(number_of_sites, dtype=np.float64)
-
-        iso_n = np.zeros(number_of_sites, dtype=np.float64)
-        zeta_n = np.zeros(number_of_sites, dtype=np.float64)
-        eta_n = np.zeros(number_of_sites, dtype=np.float64)
-        ori_n = np.zeros(3*number_of_sites, dtype=np.float64)
-
-        # Quad
-        Cq_e = np.zeros(number_of_sites, dtype=np.float64)
-        eta_e = np.zeros(number_of_sites, dtype=np.float64)
-        ori_e = np.zeros(3*number_of_sites, dtype=np.float64)
-
-        # Extract and assign site information from Site objects to C structure
-        # ---------------------------------------------------------------------
-        for i in range(number_of_sites):
-            site = spin_sys.sites[i]
-            spin_i[i] = site.isotope.spin
-            gyromagnetic_ratio_i[i] = site.isotope.gyromagnetic_ratio
-            i3 = 3*i
-
-            # CSA tensor
-            if site.isotropic_chemical_shift is not None:
-                iso_n[i] = site.isotropic_chemical_shift
-
-            shielding = site.shielding_symmetric
-            if shielding is not None:
-                if shielding.zeta is not None:
-                    zeta_n[i] = shielding.zeta
-                if shielding.eta is not None:
-                    eta_n[i] = shielding.eta
-                if shielding.alpha is not None:
-                    ori_n[i3] = shielding.alpha
-                if shielding.beta is not None:
-                    ori_n[i3+1] = shielding.beta
-                if shielding.gamma is not None:
-                    ori_n[i3+2] = shielding.gamma
-
-            # if verbose in [1, 11]:
-            #     text = ((
-            #         f"\n{isotope} site {i} from spin system {index} "
-            #         f"@ {abundance}% abundance"
-            #     ))
-            #     len_ = len(text)
-            #     print(text)
-            #     print(f"{'-'*(len_-1)}")
-            #     print(f'Isotropic chemical shift (δ) = {str(1e6*iso/larmor_frequency)} ppm')
-            #     print(f'Shielding anisotropy (ζ) = {str(1e6*zeta/larmor_frequency)} ppm')
-            #     print(f'Shielding asymmetry (η) = {eta}')
-            #     print(f'Shielding orientation = [alpha = {alpha}, beta = {beta}, gamma = {gamma}]')
-
-            # quad tensor
-            if spin_quantum_number > 0.5:
-                quad = site.quadrupolar
-                if quad is not None:
-                    if quad.Cq is not None:
-                        Cq_e[i] = quad.Cq
-                    if quad.eta is not None:
-                        eta_e[i] = quad.eta
-                    if quad.alpha is not None:
-                        ori_e[i3] = quad.alpha
-                    if quad.beta is not None:
-                        ori_e[i3+1] = quad.beta
-                    if quad.gamma is not None:
-                        ori_e[i3+2] = quad.gamma
+        cdef ndarray[double] iso_n
+        cdef ndarray[double] zeta_n
+        cdef ndarray[double] eta_n
+        cdef ndarray[double] ori_n
+
+        # quad
+        cdef ndarray[double] Cq_e
+        cdef ndarray[double] eta_e
+        cdef ndarray[double] ori_e
 
-                # if verbose in [1, 11]:
-                #     print(f'Quadrupolar coupling constant (Cq) = {Cq_e[i]/1e6} MHz')
-                #     print(f'Quadrupolar asymmetry (η) = {eta}')
-                #     print(f'Quadrupolar orientation = [alpha = {alpha}, beta = {beta}, gamma = {gamma}]')
-
-        # sites packed as c struct
-        sites_c.number_of_sites = number_of_sites
-        sites_c.spin = &spin_i[0]
-        sites_c.gyromagnetic_ratio = &gyromagnetic_ratio_i[0]
-
-        sites_c.isotropic_chemical_shift_in_ppm = &iso_n[0]
-        sites_c.shielding_symmetric_zeta_in_ppm = &zeta_n[0]
-        sites_c.shielding_symmetric_eta = &eta_n[0]
-        sites_c.shielding_orientation = &ori_n[0]
-
-        sites_c.quadrupolar_Cq_in_Hz = &Cq_e[0]
-        sites_c.quadrupolar_eta = &eta_e[0]
-        sites_c.quadrupolar_orientation = &ori_e[0]
-        # ------------------------------------------------------------------------
-        #                           Coupling specification
-        # ------------------------------------------------------------------------
         # J-coupling
-        couplings_c.number_of_couplings = 0
-        if spin_sys.couplings is not None:
-            number_of_couplings = len(spin_sys.couplings)
-            spin_index_ij = np.zeros(2*number_of_couplings, dtype=np.int32)
-
-            iso_j = np.zeros(number_of_couplings, dtype=np.float64)
-            zeta_j = np.zeros(number_of_couplings, dtype=np.float64)
-            eta_j = np.zeros(number_of_couplings, dtype=np.float64)
-            ori_j = np.zeros(3*number_of_couplings, dtype=np.float64)
-
-            # Dipolar
-            D_d = np.zeros(number_of_couplings, dtype=np.float64)
-            eta_d = np.zeros(number_of_couplings, dtype=np.float64)
-            ori_d = np.zeros(3*number_of_couplings, dtype=np.float64)
-
-            # Extract and assign coupling information from Site objects to C structure
-            for i in range(number_of_couplings):
-                coupling = spin_sys.couplings[i]
-                spin_index_ij[2*i: 2*i+2] = coupling.site_index
+        cdef ndarray[double] iso_j
+        cdef ndarray[double] zeta_j
+        cdef ndarray[double] eta_j
+        cdef ndarray[double] ori_j
+
+        # quad
+        cdef ndarray[double] D_d
+        cdef ndarray[double] eta_d
+        cdef ndarray[double] ori_d
+
+        cdef int pathway_increment, pathway_count, transition_count_per_pathway
+        cdef ndarray[float, ndim=1] transition_pathway_c
+        cdef ndarray[double, ndim=1] transition_pathway_weight_c
+        cdef ndarray[double, ndim=1] amp
+        amp_individual = []
+
+        # Per spin system C structures and pointers, packed before releasing the GIL.
+        # The numpy arrays referenced by these pointers are held in `keep_alive`.
+        cdef int n_sys = 0, total_sys = len(spin_systems)
+        cdef clib.site_struct *sites_c = <clib.site_struct *>calloc(
+            total_sys, sizeof(clib.site_struct))
+        cdef clib.coupling_struct *couplings_c = <clib.coupling_struct *>calloc(
+            total_sys, sizeof(clib.coupling_struct))
+        cdef float **pathways_c = <float **>malloc(total_sys * sizeof(float *))
+        cdef double **weights_c = <double **>malloc(total_sys * sizeof(double *))
+        cdef ndarray[int] pathway_count_c = np.zeros(total_sys, dtype=np.int32)
+        cdef ndarray[int] pathway_increment_c = np.zeros(total_sys, dtype=np.int32)
+        cdef ndarray[double] scale_c = np.zeros(total_sys, dtype=np.float64)
+        keep_alive = []
+
+        # index_ = []
+
+        # -------------------------------------------------------------------------
+        # sample __________________________________________________________________
+        for spin_sys in spin_systems:
+            abundance = spin_sys.abundance
+            isotopes = [site.isotope.symbol for site in spin_sys.sites]
+            if channel not in isotopes:
+                if decompose_spectrum == 1:
+                    amp_individual.append(np.zeros(method.shape()))
+                continue
+
+            if decompose_spectrum == 1:
+                amp_individual.append(n_sys)
+
+            # sub_sites = [site for site in spin_sys.sites if site.isotope.symbol == isotope]
+            # index_.append(index)
+            number_of_sites = len(spin_sys.sites)
+
+            # ------------------------------------------------------------------------
+            #                          Site specification
+            # ------------------------------------------------------------------------
+            # CSA
+            spin_i = np.empty(number_of_sites, dtype=np.float32)
+            gyromagnetic_ratio_i = np.empty(number_of_sites, dtype=np.float64)
+
+            iso_n = np.zeros(number_of_sites, dtype=np.float64)
+            zeta_n = np.zeros(number_of_sites, dtype=np.float64)
+            eta_n = np.zeros(number_of_sites, dtype=np.float64)
+            ori_n = np.zeros(3*number_of_sites, dtype=np.float64)
+
+            # Quad
+            Cq_e = np.zeros(number_of_sites, dtype=np.float64)
+            eta_e = np.zeros(number_of_sites, dtype=np.float64)
+            ori_e = np.zeros(3*number_of_sites, dtype=np.float64)
+
+            # Extract and assign site information from Site objects to C structure
+            # ---------------------------------------------------------------------
+            for i in range(number_of_sites):
+                site = spin_sys.sites[i]
+                spin_i[i] = site.isotope.spin
+                gyromagnetic_ratio_i[i] = site.isotope.gyromagnetic_ratio
                 i3 = 3*i
 
-                # J tensor
-                if coupling.isotropic_j is not None:
-                    iso_j[i] = coupling.isotropic_j
-
-                J_sym = coupling.j_symmetric
-                if J_sym is not None:
-                    if J_sym.zeta is not None:
-                        zeta_j[i] = J_sym.zeta
-                    if J_sym.eta is not None:
-                        eta_j[i] = J_sym.eta
-                    if J_sym.alpha is not None:
-                        ori_j[i3] = J_sym.alpha
-                    if J_sym.beta is not None:
-                        ori_j[i3+1] = J_sym.beta
-                    if J_sym.gamma is not None:
-                        ori_j[i3+2] = J_sym.gamma
-
-                # dipolar tensor
-                dipolar = coupling.dipolar
-                if dipolar is not None:
-                    if dipolar.D is not None:
-                        D_d[i] = dipolar.D
-                    if dipolar.eta is not None:
-                        eta_d[i] = dipolar.eta
-                    if dipolar.alpha is not None:
-                        ori_d[i3] = dipolar.alpha
-                    if dipolar.beta is not None:
-                        ori_d[i3+1] = dipolar.beta
-                    if dipolar.gamma is not None:
-                        ori_d[i3+2] = dipolar.gamma
-
-            # if verbose in [1, 11]:
-            #     print(f'N couplings = {number_of_couplings}')
-            #     print(f'site index J = {spin_index_ij}')
-            #     print(f'Isotropic J = {iso_j} Hz')
-            #     print(f'J anisotropy = {zeta_j} Hz')
-            #     print(f'J asymmetry = {eta_j}')
-            #     print(f'J orientation = {ori_j}')
-
-            #     print(f'Dipolar coupling constant = {D_d} Hz')
-            #     print(f'Dipolar asymmetry = {eta_d}')
-            #     print(f'Dipolar orientation = {ori_d}')
-
-            # couplings packed as c struct
-            couplings_c.number_of_couplings = number_of_couplings
-            couplings_c.site_index = &spin_index_ij[0]
-
-            couplings_c.isotropic_j_in_Hz = &iso_j[0]
-            couplings_c.j_symmetric_zeta_in_Hz = &zeta_j[0]
-            couplings_c.j_symmetric_eta = &eta_j[0]
-            couplings_c.j_orientation = &ori_j[0]
-
-            couplings_c.dipolar_coupling_in_Hz = &D_d[0]
-            couplings_c.dipolar_eta = &eta_d[0]
-            couplings_c.dipolar_orientation = &ori_d[0]
-
-
-        # if number_of_sites == 0:
-        #     if decompose_spectrum == 1:
-        #         amp_individual.append([])
-        #     continue
-
-        if number_of_sites != p_number_of_sites and isotopes != p_isotopes:
+                # CSA tensor
+                if site.isotropic_chemical_shift is not None:
+                    iso_n[i] = site.isotropic_chemical_shift
+
+                shielding = site.shielding_symmetric
+                if shielding is not None:
+                    if shielding.zeta is not None:
+                        zeta_n[i] = shielding.zeta
+                    if shielding.eta is not None:
+                        eta_n[i] = shielding.eta
+                    if shielding.alpha is not None:
+                        ori_n[i3] = shielding.alpha
+                    if shielding.beta is not None:
+                        ori_n[i3+1] = shielding.beta
+                    if shielding.gamma is not None:
+                        ori_n[i3+2] = shielding.gamma
+
+                # if verbose in [1, 11]:
+                #     text = ((
+                #         f"\n{isotope} site {i} from spin system {index} "
+                #         f"@ {abundance}% abundance"
+                #     ))
+                #     len_ = len(text)
+                #     print(text)
+                #     print(f"{'-'*(len_-1)}")
+                #     print(f'Isotropic chemical shift (δ) = {str(1e6*iso/larmor_frequency)} ppm')
+                #     print(f'Shielding anisotropy (ζ) = {str(1e6*zeta/larmor_frequency)} ppm')
+                #     print(f'Shielding asymmetry (η) = {eta}')
+                #     print(f'Shielding orientation = [alpha = {alpha}, beta = {beta}, gamma = {gamma}]')
+
+                # quad tensor
+                if self.spin_quantum_number > 0.5:
+                    quad = site.quadrupolar
+                    if quad is not None:
+                        if quad.Cq is not None:
+                            Cq_e[i] = quad.Cq
+                        if quad.eta is not None:
+                            eta_e[i] = quad.eta
+                        if quad.alpha is not None:
+                            ori_e[i3] = quad.alpha
+                        if quad.beta is not None:
+                            ori_e[i3+1] = quad.beta
+                        if quad.gamma is not None:
+                            ori_e[i3+2] = quad.gamma
+
+                    # if verbose in [1, 11]:
+                    #     print(f'Quadrupolar coupling constant (Cq) = {Cq_e[i]/1e6} MHz')
+                    #     print(f'Quadrupolar asymmetry (η) = {eta}')
+                    #     print(f'Quadrupolar orientation = [alpha = {alpha}, beta = {beta}, gamma = {gamma}]')
+
+            # sites packed as c struct
+            sites_c[n_sys].number_of_sites = number_of_sites
+            sites_c[n_sys].spin = &spin_i[0]
+            sites_c[n_sys].gyromagnetic_ratio = &gyromagnetic_ratio_i[0]
+
+            sites_c[n_sys].isotropic_chemical_shift_in_ppm = &iso_n[0]
+            sites_c[n_sys].shielding_symmetric_zeta_in_ppm = &zeta_n[0]
+            sites_c[n_sys].shielding_symmetric_eta = &eta_n[0]
+            sites_c[n_sys].shielding_orientation = &ori_n[0]
+
+            sites_c[n_sys].quadrupolar_Cq_in_Hz = &Cq_e[0]
+            sites_c[n_sys].quadrupolar_eta = &eta_e[0]
+            sites_c[n_sys].quadrupolar_orientation = &ori_e[0]
+            keep_alive.append((spin_i, gyromagnetic_ratio_i, iso_n, zeta_n, eta_n, ori_n,
+                               Cq_e, eta_e, ori_e))
+            # ------------------------------------------------------------------------
+            #                           Coupling specification
+            # ------------------------------------------------------------------------
+            # J-coupling
+            couplings_c[n_sys].number_of_couplings = 0
+            if spin_sys.couplings is not None:
+                number_of_couplings = len(spin_sys.couplings)
+                spin_index_ij = np.zeros(2*number_of_couplings, dtype=np.int32)
+
+                iso_j = np.zeros(number_of_couplings, dtype=np.float64)
+                zeta_j = np.zeros(number_of_couplings, dtype=np.float64)
+                eta_j = np.zeros(number_of_couplings, dtype=np.float64)
+                ori_j = np.zeros(3*number_of_couplings, dtype=np.float64)
+
+                # Dipolar
+                D_d = np.zeros(number_of_couplings, dtype=np.float64)
+                eta_d = np.zeros(number_of_couplings, dtype=np.float64)
+                ori_d = np.zeros(3*number_of_couplings, dtype=np.float64)
+
+                # Extract and assign coupling information from Site objects to C structure
+                for i in range(number_of_couplings):
+                    coupling = spin_sys.couplings[i]
+                    spin_index_ij[2*i: 2*i+2] = coupling.site_index
+                    i3 = 3*i
+
+                    # J tensor
+                    if coupling.isotropic_j is not None:
+                        iso_j[i] = coupling.isotropic_j
+
+                    J_sym = coupling.j_symmetric
+                    if J_sym is not None:
+                        if J_sym.zeta is not None:
+                            zeta_j[i] = J_sym.zeta
+                        if J_sym.eta is not None:
+                            eta_j[i] = J_sym.eta
+                        if J_sym.alpha is not None:
+                            ori_j[i3] = J_sym.alpha
+                        if J_sym.beta is not None:
+                            ori_j[i3+1] = J_sym.beta
+                        if J_sym.gamma is not None:
+                            ori_j[i3+2] = J_sym.gamma
+
+                    # dipolar tensor
+                    dipolar = coupling.dipolar
+                    if dipolar is not None:
+                        if dipolar.D is not None:
+                            D_d[i] = dipolar.D
+                        if dipolar.eta is not None:
+                            eta_d[i] = dipolar.eta
+                        if dipolar.alpha is not None:
+                            ori_d[i3] = dipolar.alpha
+                        if dipolar.beta is not None:
+                            ori_d[i3+1] = dipolar.beta
+                        if dipolar.gamma is not None:
+                            ori_d[i3+2] = dipolar.gamma
+
+                # if verbose in [1, 11]:
+                #     print(f'N couplings = {number_of_couplings}')
+                #     print(f'site index J = {spin_index_ij}')
+                #     print(f'Isotropic J = {iso_j} Hz')
+                #     print(f'J anisotropy = {zeta_j} Hz')
+                #     print(f'J asymmetry = {eta_j}')
+                #     print(f'J orientation = {ori_j}')
+
+                #     print(f'Dipolar coupling constant = {D_d} Hz')
+                #     print(f'Dipolar asymmetry = {eta_d}')
+                #     print(f'Dipolar orientation = {ori_d}')
+
+                # couplings packed as c struct
+                couplings_c[n_sys].number_of_couplings = number_of_couplings
+                couplings_c[n_sys].site_index = &spin_index_ij[0]
+
+                couplings_c[n_sys].isotropic_j_in_Hz = &iso_j[0]
+                couplings_c[n_sys].j_symmetric_zeta_in_Hz = &zeta_j[0]
+                couplings_c[n_sys].j_symmetric_eta = &eta_j[0]
+                couplings_c[n_sys].j_orientation = &ori_j[0]
+
+                couplings_c[n_sys].dipolar_coupling_in_Hz = &D_d[0]
+                couplings_c[n_sys].dipolar_eta = &eta_d[0]
+                couplings_c[n_sys].dipolar_orientation = &ori_d[0]
+                keep_alive.append((spin_index_ij, iso_j, zeta_j, eta_j, ori_j,
+                                   D_d, eta_d, ori_d))
+
+            # if number_of_sites == 0:
+            #     if decompose_spectrum == 1:
+            #         amp_individual.append([])
+            #     continue
+
             transition_pathway = spin_sys.transition_pathways
             if transition_pathway is None:
-                segments, weights = method._get_transition_pathway_and_weights_np(spin_sys)
-                transition_pathway = np.asarray(segments, dtype=np.float32)
-                transition_pathway_c = transition_pathway.ravel()
-                transition_pathway_weight_c = weights.view(dtype=np.float64)
+                # The reduced pathways only depend on the isotopes of the sites and the
+                # coupled site pairs.
+                key = (tuple(isotopes), coupled_site_pairs(spin_sys))
+                if key not in self.pathways:
+                    segments, weights = method._get_transition_pathway_and_weights_np(
+                        spin_sys, reduced=True
+                    )
+                    transition_pathway = np.array(segments, dtype=np.float32)
+                    self.pathways[key] = (
+                        transition_pathway.ravel(),
+                        weights.view(dtype=np.float64).copy(),
+                        transition_pathway.shape[:2],
+                    )
+                transition_pathway_c, transition_pathway_weight_c, shape = self.pathways[key]
             else:
                 # convert transition objects to list
                 weights = [(item.weight.real, item.weight.imag) for item in transition_pathway]
@@ -409,69 +569,351 @@ def core_simulator(method,
                 transition_pathway = np.asarray(transition_pathway)
                 lst = [item.tolist() for item in transition_pathway.ravel()]
                 transition_pathway_c = np.asarray(lst, dtype=np.float32).ravel()
+                shape = transition_pathway.shape[:2]
 
-            pathway_count, transition_count_per_pathway = transition_pathway.shape[:2]
+            pathway_count, transition_count_per_pathway = shape
             pathway_increment = 2*number_of_sites*transition_count_per_pathway
 
-            p_number_of_sites = number_of_sites
-            p_isotopes = isotopes
-
-        # if spin_sys.transitions is not None:
-        #     transition_pathway_c = np.asarray(
-        #         spin_sys.transitions, dtype=np.float32
-        #     ).ravel()
-        # else:
-        #     transition_pathway_c = np.asarray([0.5, -0.5], dtype=np.float32)
-
-        # the number 2 is because of single site transition [mi, mf]
-        # it dose not work for coupled sites.
-        # transition_increment = 2*number_of_sites
-        # number_of_transitions = int((transition_pathway_c.size)/transition_increment)
-
-        # print('pathway', transition_pathway_c)
-        # print('weight', transition_pathway_weight)
-        # print('pathway_count, inc', pathway_count, pathway_increment)
-        for trans__ in range(pathway_count):
-            clib.__mrsimulator_core(
-                &amp[0],  # as complex array
-                &sites_c,
-                &couplings_c,
-                &transition_pathway_c[pathway_increment*trans__],
-                &transition_pathway_weight_c[2*trans__],
-                n_dimension,      # The total number of spectroscopic dimensions.
-                dimensions,       # Pointer to MRS_dimension structure
-                fftw_scheme,      # Pointer to the fftw scheme.
-                averaging_scheme, # Pointer to the powder averaging scheme.
-                interpolation,
-                isotropic_interpolation,
-                &f_contrib[0],
-                &affine_matrix_c[0],
-            )
+            # if spin_sys.transitions is not None:
+            #     transition_pathway_c = np.asarray(
+            #         spin_sys.transitions, dtype=np.float32
+            #     ).ravel()
+            # else:
+            #     transition_pathway_c = np.asarray([0.5, -0.5], dtype=np.float32)
+
+            # the number 2 is because of single site transition [mi, mf]
+            # it dose not work for coupled sites.
+            # transition_increment = 2*number_of_sites
+            # number_of_transitions = int((transition_pathway_c.size)/transition_increment)
+
+            keep_alive.append((transition_pathway_c, transition_pathway_weight_c))
+            pathways_c[n_sys] = &transition_pathway_c[0]
+            weights_c[n_sys] = &transition_pathway_weight_c[0]
+            pathway_count_c[n_sys] = pathway_count
+            pathway_increment_c[n_sys] = pathway_increment
+            scale_c[n_sys] = abundance/self.norm
+            n_sys += 1
+
+        # evaluate the spectra from all spin systems with the GIL released.
+        if decompose_spectrum == 1:
+            amp = np.zeros(2 * n_points * n_sys, dtype=np.float64)
+        else:
+            amp = np.zeros(2 * n_points, dtype=np.float64)
+
+        if n_sys > 0:
+            with nogil:
+                clib.MRS_run_simulation_plan(
+                    self.plan,
+                    &amp[0],  # as complex array
+                    decompose_spectrum == 1,
+                    n_sys,
+                    sites_c,
+                    couplings_c,
+                    pathways_c,
+                    weights_c,
+                    &pathway_count_c[0],
+                    &pathway_increment_c[0],
+                    &scale_c[0],
+                )
+
+        free(sites_c)
+        free(couplings_c)
+        free(pathways_c)
+        free(weights_c)
+        keep_alive = None
+
+        return self._unpack(amp, n_sys, amp_individual)
+
+    cdef _unpack(self, ndarray amp, int n_sys, list amp_individual):
+        """Return the spectrum, or the list of spectra from every spin system, from the
+        C output array. The entries of `amp_individual` are either the index of the
+        spin system in the output array or a precomputed spectrum."""
+        cdef int n_points = self.n_points
+        cdef unsigned int decompose_spectrum = self.decompose_spectrum
+        method = self.method
 
         temp = amp.view(dtype=np.complex128)
-        temp *= abundance/norm
-
         if decompose_spectrum == 1:
-            amp_individual.append(temp.copy().reshape(method.shape()))
+            temp.shape = (n_sys,) + tuple(method.shape())
+            amp_individual = [
+                item if not isinstance(item, int) else temp[item].copy()
+                for item in amp_individual
+            ]
+            amp1 = np.zeros(n_points, dtype=np.complex128)
         else:
-            amp1 += temp
-        amp[:] = 0
+            amp1 = temp
+
+        # reverse the spectrum if gyromagnetic ratio is positive.
+        if decompose_spectrum == 1 and len(amp_individual) != 0:
+            if self.gyromagnetic_ratio < 0:
+                amp1 = [np.fft.fftn(np.fft.ifftn(item).conj()) for item in amp_individual]
+            else:
+                amp1 = amp_individual
+        else:
+            amp1.shape = method.shape()
+            if self.gyromagnetic_ratio < 0:
+                amp1 = np.fft.fftn(np.fft.ifftn(amp1).conj())
+
+        return amp1
+
+    @cython.profile(False)
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def simulate_sites(self, isotropic_chemical_shift,
+            shielding_zeta=None,
+            shielding_eta=None,
+            shielding_orientation=None,
+            quadrupolar_Cq=None,
+            quadrupolar_eta=None,
+            quadrupolar_orientation=None,
+            abundance=None):
+        """Simulate the spectrum from a batch of single-site spin systems given as
+        arrays of site parameters. The sites are of the isotope of the observed
+        channel. Unlike the `simulate` method, the site parameters are passed to C
+        directly, without creating the SpinSystem objects.
+
+        Args:
+            isotropic_chemical_shift: An array of N isotropic chemical shifts in ppm.
+            shielding_zeta: An array of N shielding anisotropies in ppm.
+            shielding_eta: An array of N shielding asymmetries.
+            shielding_orientation: An array of shape (N, 3) of the shielding Euler
+                angles in radians.
+            quadrupolar_Cq: An array of N quadrupolar coupling constants in Hz.
+            quadrupolar_eta: An array of N quadrupolar asymmetries.
+            quadrupolar_orientation: An array of shape (N, 3) of the quadrupolar Euler
+                angles in radians.
+            abundance: An array of N abundances in %. The default is 100.
+
+        The missing parameters default to zero. Scalar parameters are broadcast to all
+        N spin systems.
+
+        Returns:
+            A numpy array of the spectrum, or a list of arrays, one per spin system,
+            when `decompose_spectrum` is 1.
+        """
+        cdef ndarray[double] iso_n = np.array(
+            isotropic_chemical_shift, dtype=np.float64, ndmin=1).ravel()
+        cdef int n_sys = iso_n.size
+        cdef ndarray[double] zeta_n = _as_array(shielding_zeta, n_sys)
+        cdef ndarray[double] eta_n = _as_array(shielding_eta, n_sys)
+        cdef ndarray[double] ori_n = _as_array(shielding_orientation, (n_sys, 3))
+        cdef ndarray[double] Cq_e = _as_array(quadrupolar_Cq, n_sys)
+        cdef ndarray[double] eta_e = _as_array(quadrupolar_eta, n_sys)
+        cdef ndarray[double] ori_e = _as_array(quadrupolar_orientation, (n_sys, 3))
+        cdef ndarray[double] scale_c = _as_array(abundance, n_sys, 100.0) / self.norm
+
+        # The quadrupolar tensor is only evaluated for spin I > 1/2.
+        if self.spin_quantum_number <= 0.5:
+            Cq_e = np.zeros(n_sys, dtype=np.float64)
+            eta_e = np.zeros(n_sys, dtype=np.float64)
+            ori_e = np.zeros(3 * n_sys, dtype=np.float64)
+
+        # single-site transition pathways of the observed isotope.
+        cdef ndarray[float, ndim=1] transition_pathway_c
+        cdef ndarray[double, ndim=1] transition_pathway_weight_c
+        cdef int pathway_count, transition_count_per_pathway
+        key = (self.channel,)
+        if key not in self.pathways:
+            from mrsimulator.spin_system import SpinSystem
+
+            spin_sys = SpinSystem(sites=[{"isotope": self.channel}])
+            segments, weights = self.method._get_transition_pathway_and_weights_np(
+                spin_sys, reduced=True
+            )
+            transition_pathway = np.array(segments, dtype=np.float32)
+            self.pathways[key] = (
+                transition_pathway.ravel(),
+                weights.view(dtype=np.float64).copy(),
+                transition_pathway.shape[:2],
+            )
+        transition_pathway_c, transition_pathway_weight_c, shape = self.pathways[key]
+        pathway_count, transition_count_per_pathway = shape
 
-    # reverse the spectrum if gyromagnetic ratio is positive.
-    if decompose_spectrum == 1 and len(amp_individual) != 0:
-        if gyromagnetic_ratio < 0:
-            amp1 = [np.fft.fftn(np.fft.ifftn(item).conj()) for item in amp_individual]
+        cdef ndarray[double, ndim=1] amp
+        if self.decompose_spectrum == 1:
+            amp = np.zeros(2 * self.n_points * n_sys, dtype=np.float64)
         else:
-            amp1 = amp_individual
-    else:
-        amp1.shape = method.shape()
-        if gyromagnetic_ratio < 0:
-            amp1 = np.fft.fftn(np.fft.ifftn(amp1).conj())
-
-    clib.MRS_free_dimension(dimensions, n_dimension)
-    clib.MRS_free_averaging_scheme(averaging_scheme)
-    clib.MRS_free_fftw_scheme(fftw_scheme)
-    return amp1
+            amp = np.zeros(2 * self.n_points, dtype=np.float64)
+
+        cdef float spin = self.spin_quantum_number
+        cdef double gyromagnetic_ratio = self.gyromagnetic_ratio
+        if n_sys > 0:
+            with nogil:
+                clib.MRS_run_simulation_plan_single_site(
+                    self.plan,
+                    &amp[0],  # as complex array
+                    self.decompose_spectrum == 1,
+                    n_sys,
+                    spin,
+                    gyromagnetic_ratio,
+                    &iso_n[0],
+                    &zeta_n[0],
+                    &eta_n[0],
+                    &ori_n[0],
+                    &Cq_e[0],
+                    &eta_e[0],
+                    &ori_e[0],
+                    &transition_pathway_c[0],
+                    &transition_pathway_weight_c[0],
+                    pathway_count,
+                    2*transition_count_per_pathway,
+                    &scale_c[0],
+                )
+
+        return self._unpack(amp, n_sys, list(range(n_sys)))
+
+def core_simulator(method,
+       list spin_systems,
+       int verbose=0,  # for debug purpose only.
+       unsigned int number_of_sidebands=90,
+       unsigned int integration_density=72,
+       unsigned int decompose_spectrum=0,
+       unsigned int integration_volume=1,
+       unsigned int isotropic_interpolation=0,
+       unsigned int number_of_gamma_angles=1,
+       bool_t interpolation=True,
+       bool_t auto_switch=True,
+       int number_of_threads=1,
+       unsigned int fftw_plan_rigor=0,
+       bool_t isotropic_shift_convolution=False,
+       double amplitude_threshold=0.0):
+    """core simulator init"""
+    compiled = CompiledMethod(
+        method,
+        verbose=verbose,
+        number_of_sidebands=number_of_sidebands,
+        integration_density=integration_density,
+        decompose_spectrum=decompose_spectrum,
+        integration_volume=integration_volume,
+        isotropic_interpolation=isotropic_interpolation,
+        number_of_gamma_angles=number_of_gamma_angles,
+        interpolation=interpolation,
+        auto_switch=auto_switch,
+        number_of_threads=number_of_threads,
+        fftw_plan_rigor=fftw_plan_rigor,
+        isotropic_shift_convolution=isotropic_shift_convolution,
+        amplitude_threshold=amplitude_threshold,
+    )
+    return compiled.simulate(spin_systems)
+
+
+def clear_cache():
+    """Release the orientation tables and fftw plans cached by the previous
+    simulations. The cache is re-populated by the next simulation."""
+    clib.MRS_clear_cache()
+
+
+def czjzek_histogram(x_range, unsigned int x_size, y_range, unsigned int y_size, T0,
+                     double scale, unsigned long size, bool_t polar=False):
+    """Draw random tensors from the extended Czjzek model, diag(T0) + scale * S_C(1),
+    and return the histogram of the Haeberlen (zeta, eta), or the polar (x, y),
+    parameters of the tensors. The tensors are drawn and binned in C, without storing
+    the tensors. The random number generator is seeded from `numpy.random`.
+
+    Args:
+        x_range: The [min, max] range of the zeta (x) dimension.
+        int x_size: The number of bins along the zeta (x) dimension.
+        y_range: The [min, max] range of the eta (y) dimension.
+        int y_size: The number of bins along the eta (y) dimension.
+        T0: The three principal components of the dominant tensor.
+        float scale: The size of the random perturbation.
+        int size: The number of random tensors.
+        bool polar: If true, bin the polar x and y coordinates.
+
+    Returns:
+        A numpy array of shape (x_size, y_size) with the counts.
+    """
+    cdef ndarray[double, ndim=2] hist = np.zeros((x_size, y_size), dtype=np.float64)
+    cdef ndarray[double] T0_c = np.asarray(T0, dtype=np.float64).ravel()
+    cdef uint64_t seed = np.random.randint(0, 2**63, dtype=np.uint64)
+    cdef double x_min = x_range[0], x_max = x_range[1]
+    cdef double y_min = y_range[0], y_max = y_range[1]
+    with nogil:
+        clib.MRS_czjzek_histogram(
+            &hist[0, 0], x_size, x_min, x_max, y_size, y_min, y_max, &T0_c[0], scale,
+            size, polar, seed
+        )
+    return hist
+
+
+@cython.profile(False)
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def transition_pathways(segments):
+    """Return the transition pathways as the cartesian product of the transitions
+    selected at each event, with the transition index of the last event varying the
+    fastest.
+
+    Args:
+        segments: A list of arrays of shape (n_i, 2, n_sites) with the transitions
+            selected at the i-th event.
+
+    Returns:
+        A float32 numpy array of shape (prod(n_i), n_events, 2, n_sites).
+    """
+    segments = [np.ascontiguousarray(item, dtype=np.float32) for item in segments]
+    cdef ndarray[unsigned int] counts = np.asarray(
+        [item.shape[0] for item in segments], dtype=np.uintc
+    )
+    cdef unsigned int n_events = counts.size, n_sites = segments[0].shape[2]
+    cdef int n_pathways = np.prod(counts, dtype=np.int64)
+    cdef ndarray[float, ndim=4] pathways = np.empty(
+        (n_pathways, n_events, 2, n_sites), dtype=np.float32
+    )
+    if n_pathways == 0:
+        return pathways
+
+    cdef ndarray[float] segments_c = np.concatenate([item.ravel() for item in segments])
+    with nogil:
+        clib.MRS_transition_pathways(
+            n_events, &counts[0], &segments_c[0], n_sites, &pathways[0, 0, 0, 0]
+        )
+    return pathways
+
+
+@cython.profile(False)
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def transition_pathway_weights(
+        ndarray[float, ndim=4, mode="c"] pathways,
+        spins,
+        unsigned int event_1,
+        unsigned int event_2,
+        alpha,
+        beta,
+        gamma,
+        ndarray weights,
+    ):
+    """Multiply, in place, the weights of the transition pathways with the connect
+    factor of the transitions at events `event_1` and `event_2`. The connecting rotation
+    of every site is given by the Euler angles alpha, beta, gamma in the ZYZ convention.
+
+    Args:
+        pathways: A C-contiguous float32 array of shape (n_pathways, n_events, 2,
+            n_sites) of the transition pathways.
+        spins: A list of the spin quantum numbers of the sites.
+        int event_1: The event index of the starting transitions.
+        int event_2: The event index of the connecting transitions.
+        alpha: A list of the first Euler angle of every site.
+        beta: A list of the second Euler angle of every site.
+        gamma: A list of the third Euler angle of every site.
+        weights: A complex128 array of the pathway weights, updated in place.
+    """
+    cdef unsigned int n_pathways = pathways.shape[0], n_events = pathways.shape[1]
+    cdef unsigned int n_sites = pathways.shape[3]
+    cdef ndarray[float] spins_c = np.ascontiguousarray(spins, dtype=np.float32)
+    cdef ndarray[double] alpha_c = np.ascontiguousarray(alpha, dtype=np.float64)
+    cdef ndarray[double] beta_c = np.ascontiguousarray(beta, dtype=np.float64)
+    cdef ndarray[double] gamma_c = np.ascontiguousarray(gamma, dtype=np.float64)
+    cdef ndarray[double] weights_c = weights.view(dtype=np.float64)
+    if n_pathways == 0:
+        return
+
+    with nogil:
+        clib.MRS_transition_pathway_weights(
+            n_pathways, n_events, n_sites, &pathways[0, 0, 0, 0], &spins_c[0], event_1,
+            event_2, &alpha_c[0], &beta_c[0], &gamma_c[0], &weights_c[0]
+        )
 
 
 @cython.profile(False)
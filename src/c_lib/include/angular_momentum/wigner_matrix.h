@@ -77,6 +77,73 @@ extern void __wigner_rotation_2(const int l, const int n, const double *wigner,
                                 const void *exp_Im_alpha, const void *R_in,
                                 void *R_out);
 
+/**
+ * @brief Convert a stack of half wigner-d matrices of rank @p l, as evaluated with
+ * wigner_d_matrices_from_exp_I_beta(), to the symmetric structure-of-arrays layout of
+ * __wigner_rotation_soa().
+ *
+ * Using the symmetry @f$R_{l,k} = (-1)^k R_{l,-k}^*@f$ of the tensor components, the
+ * rotation of row m is reduced to
+ *    Re(R_out[m]) = d[m, 0] Re(R[0]) + sum_{k=1}^l (d[m,-k] + (-1)^k d[m,k]) Re(R[-k]),
+ *    Im(R_out[m]) = d[m, 0] Im(R[0]) + sum_{k=1}^l (d[m,-k] - (-1)^k d[m,k]) Im(R[-k]).
+ * The output holds the `2l+1` coefficients @f$d[m, 0]@f$, @f$(d[m,-k] + (-1)^k
+ * d[m,k])@f$, and @f$(d[m,-k] - (-1)^k d[m,k])@f$, for k = 1 to l, of every row m of
+ * the half matrix, each as a contiguous array over the @p n orientations.
+ *
+ * @param l The rank of the wigner-d matrices.
+ * @param n The number of wigner-d matrices.
+ * @param wigner A pointer to `n x (l+1) x (2l+1)` half wigner-d matrices.
+ * @param wigner_soa A pointer to the `(l+1) x (2l+1) x n` output array.
+ */
+extern void wigner_d_matrices_to_symmetric_soa(const int l, const int n,
+                                               const double *wigner,
+                                               double *wigner_soa);
+
+/** The number of orientations per block of the structure-of-arrays rotation. */
+#define MRS_WIGNER_BLOCK 256
+
+/**
+ * @brief Same as __wigner_rotation_2(), except the wigner-d matrices are given in the
+ * symmetric structure-of-arrays layout from wigner_d_matrices_to_symmetric_soa().
+ *
+ * The orientations are processed in blocks, where the intermediate values are held as
+ * split real and imaginary arrays over the orientations of the block, so that the
+ * inner loops vectorize. The function is compiled for multiple instruction sets, see
+ * MRS_SIMD_CLONES.
+ *
+ * @param l The rank of the wigner-d matrices.
+ * @param n The number of orientations.
+ * @param wigner A pointer to the `(l+1) x (2l+1) x n` symmetric wigner-d coefficients.
+ * @param exp_Im_alpha A pointer to the `4 x n` array of @f$\exp(-im\alpha)@f$,
+ *      ordered as m=[-4,-3,-2,-1].
+ * @param R_in A pointer to a 1D-array of initial vector of length `2l+1`.
+ * @param R_out A pointer to the `n x (l+1)` array of vectors after rotation.
+ */
+extern void __wigner_rotation_soa(const int l, const int n, const double *wigner,
+                                  const void *exp_Im_alpha, const void *R_in,
+                                  void *R_out);
+
+/**
+ * @brief Rotate a block of orientations, `[start, start + size)`, with
+ * __wigner_rotation_soa(), writing the rotated components as split real and imaginary
+ * arrays. The m^th component of the i^th orientation of the block is stored at
+ * `R_out_re[m * MRS_WIGNER_BLOCK + i]`.
+ *
+ * @param l The rank of the wigner-d matrices.
+ * @param n The number of orientations in the tables.
+ * @param start The index of the first orientation of the block.
+ * @param size The number of orientations in the block, at most MRS_WIGNER_BLOCK.
+ * @param wigner A pointer to the `(l+1) x (2l+1) x n` symmetric wigner-d coefficients.
+ * @param exp_Im_alpha A pointer to the `4 x n` array of @f$\exp(-im\alpha)@f$.
+ * @param R_in A pointer to a 1D-array of initial vector of length `2l+1`.
+ * @param R_out_re A pointer to the `(l+1) x MRS_WIGNER_BLOCK` real components.
+ * @param R_out_im A pointer to the `(l+1) x MRS_WIGNER_BLOCK` imaginary components.
+ */
+extern void __wigner_rotation_soa_block(const int l, const int n, const int start,
+                                        const int size, const double *wigner,
+                                        const void *exp_Im_alpha, const void *R_in,
+                                        double *R_out_re, double *R_out_im);
+
 extern void wigner_dm0_vector(const int l, const double beta, double *R_out);
 
 /**
@@ -94,6 +161,19 @@ extern void wigner_dm0_vector(const int l, const double beta, double *R_out);
 extern void single_wigner_rotation(const int l, const double *euler_angles,
                                    const void *R_in, void *R_out);
 
+/**
+ * @brief Step the alpha phase of the tensor components by `k` x π/2. For m > 0, the
+ * R(-m) component is multiplied by (-i)^(mk) and the R(m) component by (i)^(mk), which
+ * is equivalent to multiplying the exp(-Im alpha) terms by the same phase factor.
+ *
+ * @param l The rank of the tensor.
+ * @param k The number of π/2 steps.
+ * @param R_in A pointer to the `2l+1` complex tensor components.
+ * @param R_out A pointer to the `2l+1` complex tensor components after the phase step.
+ */
+extern void __step_alpha_phase(const int l, const unsigned int k, const double *R_in,
+                               double *R_out);
+
 /**
  * ❌ Performs wigner rotations on a batch of wigner matrices and initial tensor
  * orientation. The wigner matrices corresponds to the beta orientations. The
@@ -108,12 +188,15 @@ extern void single_wigner_rotation(const int l, const double *euler_angles,
  *
  * @param octant_orientations Number of orientations on an octant.
  * @param n_octants Number of octants.
- * @param wigner_2j_matrices A pointer to a stack of 5x5 second rank wigner matrices.
+ * @param wigner_2j_matrices A pointer to the second rank wigner matrices in the
+ *      symmetric structure-of-arrays layout, see wigner_d_matrices_to_symmetric_soa().
  * @param R2 A pointer to the second rank tensor coefficients of length 5 to be rotated.
- * @param wigner_4j_matrices A pointer to a stack of 9x9 fourth rank wigner matrices.
+ * @param wigner_4j_matrices A pointer to the fourth rank wigner matrices in the
+ *      symmetric structure-of-arrays layout, see wigner_d_matrices_to_symmetric_soa().
  * @param R4 A pointer to the fourth rank tensor coefficients of length 9 to be rotated.
  * @param exp_Im_alpha A pointer to a `4 x octant_orientations` array with the exp(-Imα)
  *      with `octant_orientations` as the leading dimension, ordered as m=[-4,-3,-2,-1].
+ *      The array is not modified.
  * @param w2 A pointer to a stack of second rank tensor coefficients after rotation with
  *      second-rank wigner matrices. The length of w2 is `octant_orientations x
  *      n_octants x 5` with 5 as the leading dimension.
@@ -123,11 +206,64 @@ extern void single_wigner_rotation(const int l, const double *euler_angles,
  */
 extern void __batch_wigner_rotation(const unsigned int octant_orientations,
                                     const unsigned int n_octants,
-                                    double *wigner_2j_matrices, complex128 *R2,
-                                    double *wigner_4j_matrices, complex128 *R4,
-                                    complex128 *exp_Im_alpha, complex128 *w2,
+                                    const double *wigner_2j_matrices,
+                                    const complex128 *R2,
+                                    const double *wigner_4j_matrices,
+                                    const complex128 *R4,
+                                    const complex128 *exp_Im_alpha, complex128 *w2,
                                     complex128 *w4);
 
+/**
+ * @brief Tabulate the matrix for rotating the tensor components of many spin systems
+ * at once with a single GEMM, see __batch_wigner_rotation_gemm().
+ *
+ * Following __wigner_rotation_soa_block(), the rotated component m at the i^th
+ * orientation is a real linear combination of the `2l+2` values
+ *    [Re(R[0]), Im(R[0]), Re(R[-1]), ..., Re(R[-l]), Im(R[-1]), ..., Im(R[-l])],
+ * with coefficients from the wigner-d tables and exp(-Ik alpha). The output is a row
+ * major `2(l+1)n x (2l+2)` matrix, where the rows are ordered as the real part of the
+ * components m = [-l, ..., 0] over the `n` orientations, followed by the imaginary
+ * part.
+ *
+ * @param l The rank of the wigner-d matrices.
+ * @param n The number of orientations.
+ * @param wigner A pointer to the `(l+1) x (2l+1) x n` symmetric wigner-d coefficients.
+ * @param exp_Im_alpha A pointer to the `4 x n` array of @f$\exp(-im\alpha)@f$,
+ *      ordered as m=[-4,-3,-2,-1].
+ * @param matrix A pointer to the `2(l+1)n x (2l+2)` output matrix.
+ */
+extern void wigner_rotation_gemm_matrix(const int l, const int n, const double *wigner,
+                                        const void *exp_Im_alpha, double *matrix);
+
+/**
+ * @brief Rotate the tensor components of @p n_systems spin systems over all the
+ * orientations with one GEMM per octant.
+ *
+ * The components of the spin systems are stacked as the columns of a `(2l+2) x
+ * n_systems` matrix, after stepping the alpha phase of the octant, see
+ * __step_alpha_phase(). The product with the matrix from
+ * wigner_rotation_gemm_matrix() is the rotated components of every spin system.
+ *
+ * @param l The rank of the tensor.
+ * @param octant_orientations The number of orientations on an octant, `n`.
+ * @param n_octants The number of octants, 1, 4, or 8.
+ * @param matrix A pointer to the matrices from wigner_rotation_gemm_matrix(), one for
+ *      the upper hemisphere followed, when @p n_octants is 8, by one for the lower
+ *      hemisphere.
+ * @param n_systems The number of spin systems.
+ * @param R_in A pointer to the `n_systems x (2l+1)` complex tensor components.
+ * @param components A pointer to a buffer of size `(2l+2) x n_systems`.
+ * @param R_out A pointer to the `n_octants x 2 x (l+1) x n x n_systems` rotated
+ *      components, ordered as octants, real and imaginary parts, m = [-l, ..., 0],
+ *      and orientations, with the spin systems as the leading dimension.
+ */
+extern void __batch_wigner_rotation_gemm(const int l,
+                                         const unsigned int octant_orientations,
+                                         const unsigned int n_octants,
+                                         const double *matrix, const int n_systems,
+                                         const complex128 *R_in, double *components,
+                                         double *R_out);
+
 /**
  * ✅ Calculates exp(-Im alpha) where alpha is an array of size n.
  * The function accepts cos_alpha = cos(alpha).
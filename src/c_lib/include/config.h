@@ -36,6 +36,17 @@ typedef float complex64[2];
 #else  // not C99
 #define restrict __restrict
 #endif
+
+// Function multi-versioning. The functions marked with MRS_SIMD_CLONES are compiled
+// for the AVX-512, AVX2, and the baseline instruction sets, and the version matching
+// the host cpu is selected at load time. Other compilers use the baseline version.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && \
+    defined(__linux__)
+#define MRS_SIMD_CLONES \
+  __attribute__((target_clones("arch=skylake-avx512", "arch=haswell", "default")))
+#else
+#define MRS_SIMD_CLONES
+#endif
 // ---------------------------------------------------------------------------- //
 
 // Blas definitions ----------------------------------------------------------- //
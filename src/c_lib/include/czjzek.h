@@ -0,0 +1,51 @@
+// -*- coding: utf-8 -*-
+//
+//  czjzek.h
+//
+//  @copyright Deepansh J. Srivastava, 2019-2021.
+//  Created by Deepansh J. Srivastava, Oct 16, 2026.
+//  Contact email = srivastava.89@osu.edu
+//
+
+#ifndef czjzek_h
+#define czjzek_h
+#include <stdint.h>
+
+#include "config.h"
+
+// The number of random tensors drawn and diagonalized at a time.
+#define MRS_CZJZEK_BLOCK 256
+
+/**
+ * Draw `size` random traceless second-rank symmetric tensors from the extended Czjzek
+ * model,
+ *    S = diag(T0) + scale * S_C(sigma=1),
+ * and accumulate the tensor parameters into a two-dimensional histogram. With a zero
+ * `T0`, the model is the Czjzek model with sigma = `scale`.
+ *
+ * The parameters are the Haeberlen zeta and eta, or the polar x and y, when `polar`
+ * is true. The eigenvalues are evaluated analytically, and the tensors are drawn,
+ * diagonalized, and binned in blocks of MRS_CZJZEK_BLOCK, without storing the tensors.
+ *
+ * @param hist The row-major histogram of shape (n_x, n_y). The counts are added to the
+ *          existing values.
+ * @param n_x The number of bins along the zeta (x) dimension.
+ * @param x_min The lower edge of the zeta (x) range.
+ * @param x_max The upper edge of the zeta (x) range.
+ * @param n_y The number of bins along the eta (y) dimension.
+ * @param y_min The lower edge of the eta (y) range.
+ * @param y_max The upper edge of the eta (y) range.
+ * @param T0 The three principal components of the dominant tensor.
+ * @param scale The size of the random perturbation.
+ * @param size The number of random tensors.
+ * @param polar If true, bin the polar x and y coordinates.
+ * @param seed The seed of the random number generator.
+ */
+void MRS_czjzek_histogram(double *restrict hist, const unsigned int n_x,
+                          const double x_min, const double x_max,
+                          const unsigned int n_y, const double y_min,
+                          const double y_max, const double *T0, const double scale,
+                          const unsigned long size, const bool polar,
+                          const uint64_t seed);
+
+#endif /* czjzek_h */
@@ -9,10 +9,12 @@
 
 #include "simulation.h"
 
-void one_dimensional_averaging(MRS_dimension *dimensions, MRS_averaging_scheme *scheme,
-                               double *spec, double transition_pathway_weight,
+void one_dimensional_averaging(MRS_dimension *dimensions,
+                               MRS_orientation_tables *scheme, double *spec,
+                               double transition_pathway_weight,
                                unsigned int iso_intrp);
 
-void two_dimensional_averaging(MRS_dimension *dimensions, MRS_averaging_scheme *scheme,
+void two_dimensional_averaging(MRS_dimension *dimensions,
+                               MRS_orientation_tables *scheme, MRS_workspace *workspace,
                                double *spec, double transition_pathway_weight,
                                double *affine_matrix, unsigned int iso_intrp);
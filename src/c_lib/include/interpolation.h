@@ -51,6 +51,13 @@ extern void triangle_interpolation2D(double *f11, double *f12, double *f13, doub
                                      double *spec, int m0, int m1,
                                      unsigned int iso_intrp);
 
+/**
+ * The number of bins beyond the range of the interpolated frequencies which the
+ * interpolation may write to. The Gaussian interpolation of an isotropic frequency, f,
+ * spreads over the bins floor(f - 0.5) - 2 to floor(f - 0.5) + 2.
+ */
+#define MRS_INTERPOLATION_PAD 3
+
 /**
  * @brief Sum amplitudes from the triangles interpolations over the region of an octant.
  * The samplings over the octant is as per Alderman and Grand scheme.
@@ -67,9 +74,23 @@ void octahedronDeltaInterpolation(const unsigned int nt, double *freq, double *a
                                   int stride, int n_spec, double *spec,
                                   unsigned int iso_intrp);
 
+/**
+ * @brief Interpolate the triangles of an octant onto a 1D grid.
+ *
+ * @param spec A pointer to the starting index of a one-dimensional array.
+ * @param freq A pointer to the frequencies at the octant coordinates.
+ * @param nt Number of triangles along the edge of the octant.
+ * @param amp A pointer to the amplitudes at the octant coordinates.
+ * @param stride Stride step for the amplitudes (amp) array.
+ * @param m Number of points in the spectrum array (spec).
+ */
 extern void octahedronInterpolation(double *spec, double *freq, const unsigned int nt,
                                     double *amp, int stride, int m);
 
+/**
+ * @brief Interpolate the triangles of an octant onto a 2D grid of @p m0 rows and @p m1
+ * columns. The arguments follow octahedronInterpolation().
+ */
 extern void octahedronInterpolation2D(double *spec, double *freq1, double *freq2,
                                       int nt, double *amp, int stride, int m0, int m1,
                                       unsigned int iso_intrp);
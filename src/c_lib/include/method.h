@@ -35,7 +35,8 @@ typedef struct MRS_dimension {
   double *freq_offset;      // buffer for local + sideband frequencies.
   double normalize_offset;  // fixed value = 0.5 - coordinate_offset/increment
   double inverse_increment;
-  double *freq_amplitude;  // local frequency amplitude.
+  double *freq_amplitude;      // local frequency amplitude.
+  double amplitude_threshold;  // skip octants below this fraction of the peak.
 } MRS_dimension;
 
 /**
@@ -48,7 +49,7 @@ void MRS_free_event(MRS_event *the_event);
 /**
  * @brief Create plans for every event with the array of dimensions.
  *
- * @param scheme Pointer to the MRS_averaging_scheme.
+ * @param scheme Pointer to the MRS_orientation_tables.
  * @param count Pointer to number of points array along each dimension.
  * @param coordinates_offset Pointer to coordinates_offsets array along each dimension.
  * @param increment Pointer to increment array along each dimension.
@@ -61,7 +62,7 @@ void MRS_free_event(MRS_event *the_event);
  * @return MRS_dimension*
  */
 MRS_dimension *MRS_create_dimensions(
-    MRS_averaging_scheme *scheme, int *count, double *coordinates_offset,
+    MRS_orientation_tables *scheme, int *count, double *coordinates_offset,
     double *increment, double *fractions, double *magnetic_flux_density_in_T,
     double *rotor_frequency_in_Hz, double *rotor_angle_in_rad, int *n_events,
     unsigned int n_dim, unsigned int *number_of_sidebands);
@@ -18,7 +18,7 @@
 /**
  * @struct MRS_plan
  * A mrsimulator plan for computing spectra. The plan, MRS_plan includes,
- *    - a pre-calculated MRS_averaging_scheme,
+ *    - a pre-calculated MRS_orientation_tables,
  *    - pre-calculates stacked arrays of irreducible second-rank, wigner-2j(β), and
  *      fourth-rank, wigner-4j(β), matrices at every orientation angle β,
  *    - pre-calculates the exponent of the sideband order phase, @f$\exp(-im\alpha)@f$,
@@ -78,7 +78,7 @@ typedef struct MRS_plan MRS_plan;
 /**
  * @brief Create a new mrsimulator plan.
  *
- * @param scheme The MRS_averaging_scheme.
+ * @param scheme The MRS_orientation_tables.
  * @param number_of_sidebands The number of sidebands.
  * @param rotor_frequency_in_Hz The sample rotation frequency in Hz.
  * @param rotor_angle_in_rad The polar angle in radians with respect to the
@@ -88,7 +88,7 @@ typedef struct MRS_plan MRS_plan;
  *          processing the fourth-rank tensors.
  * @return A pointer to the MRS_plan.
  */
-MRS_plan *MRS_create_plan(MRS_averaging_scheme *scheme,
+MRS_plan *MRS_create_plan(MRS_orientation_tables *scheme,
                           unsigned int number_of_sidebands,
                           double rotor_frequency_in_Hz, double rotor_angle_in_rad,
                           double increment, bool allow_4th_rank);
@@ -131,15 +131,80 @@ MRS_plan *MRS_copy_plan(MRS_plan *plan);
  * https://doi.org/10.1006/jmre.1998.1427.
  *
  * @param scheme The pointer to the powder averaging scheme of type
- *            MRS_averaging_scheme.
+ *            MRS_orientation_tables.
+ * @param workspace The pointer to the workspace of type MRS_workspace holding the
+ *            rotated second and fourth-rank tensor components.
  * @param plan A pointer to the mrsimulator plan of type MRS_plan.
  * @param fftw_scheme A pointer to the fftw scheme of type MRS_fftw_scheme.
  * @param refresh If true, zero the output array before proceeding, else add to
  *            the existing array.
  */
-void MRS_get_amplitudes_from_plan(MRS_averaging_scheme *scheme, MRS_plan *plan,
+void MRS_get_amplitudes_from_plan(MRS_orientation_tables *scheme,
+                                  MRS_workspace *workspace, MRS_plan *plan,
                                   MRS_fftw_scheme *fftw_scheme, bool refresh);
 
+/**
+ * @brief Evaluate the sideband phase factors from the rotor-frame tensor components.
+ *
+ * The phase factor at the i^th orientation and the j^th sideband is
+ *    exp(I sum_m 2 Im(w2[i, m] pre_phase_2[m, j] + w4[i, m] pre_phase_4[m, j])),
+ * where m = [-2, -1] for the second-rank and m = [-4, ..., -1] for the fourth-rank
+ * components, and the factor two is included in the `pre_phase_2` and `pre_phase_4`
+ * arrays of the MRS_plan. The orientations are processed in cache-sized blocks with a
+ * kernel specialized for the two and six term sums.
+ *
+ * @param n_orientations The number of orientations.
+ * @param n_sidebands The number of sidebands.
+ * @param w2 A pointer to the `n_orientations x 3` rotor-frame second-rank components,
+ *      m = [-2, -1, 0].
+ * @param pre_phase_2 A pointer to the `2 x n_sidebands` second-rank sideband phase.
+ * @param w4 A pointer to the `n_orientations x 5` rotor-frame fourth-rank components,
+ *      m = [-4, ..., 0], or NULL.
+ * @param pre_phase_4 A pointer to the `4 x n_sidebands` fourth-rank sideband phase.
+ * @param vector A pointer to the `n_sidebands x n_orientations` complex output.
+ */
+void MRS_get_sideband_phase_factors(unsigned int n_orientations,
+                                    unsigned int n_sidebands, const complex128 *w2,
+                                    const complex128 *pre_phase_2,
+                                    const complex128 *w4,
+                                    const complex128 *pre_phase_4, void *vector);
+
+/**
+ * The largest number of sidebands for which the sideband amplitudes are evaluated with
+ * the direct DFT, see MRS_get_sideband_amplitudes_direct(), instead of the fftw plan.
+ */
+#define MRS_DIRECT_DFT_MAX_SIDEBANDS 16
+
+/**
+ * @brief Evaluate the sideband amplitudes from the sideband phase factors using the
+ * direct discrete Fourier transform.
+ *
+ * The amplitude at the i^th orientation and the k^th sideband is
+ *    |sum_s vector[s, i] exp(-2πI s k / n_sidebands)|^2,
+ * which is the absolute value square of the forward fftw transform. The transform is
+ * vectorized over blocks of orientations, and the k and n_sidebands - k sidebands
+ * share the products of the twiddle factors. The function is a no-op when
+ * `n_sidebands` exceeds MRS_DIRECT_DFT_MAX_SIDEBANDS.
+ *
+ * @param n_orientations The number of orientations.
+ * @param n_sidebands The number of sidebands.
+ * @param vector A pointer to the `n_sidebands x n_orientations` complex phase factors.
+ *      The amplitudes are written to the real part, and the imaginary part is zeroed.
+ */
+void MRS_get_sideband_amplitudes_direct(unsigned int n_orientations,
+                                        unsigned int n_sidebands, void *vector);
+
+/**
+ * @brief Evaluate the sideband amplitudes at every orientation from the sideband phase
+ * factors stored in the `fftw_scheme->vector` array. The amplitudes are written to the
+ * real part of the same array. Up to MRS_DIRECT_DFT_MAX_SIDEBANDS sidebands, the
+ * amplitudes are evaluated with the direct DFT, else with the fftw plan.
+ *
+ * @param plan A pointer to the mrsimulator plan of type MRS_plan.
+ * @param fftw_scheme A pointer to the fftw scheme of type MRS_fftw_scheme.
+ */
+void MRS_get_amplitudes_from_phases(MRS_plan *plan, MRS_fftw_scheme *fftw_scheme);
+
 // Important: `method.h` header file must be included after defining MRS_plan.
 #include "method.h"
 
@@ -149,7 +214,9 @@ void MRS_get_amplitudes_from_plan(MRS_averaging_scheme *scheme, MRS_plan *plan,
  * dimension increment.
  *
  * @param scheme The pointer to the powder averaging scheme of type
- *      MRS_averaging_scheme.
+ *      MRS_orientation_tables.
+ * @param workspace The pointer to the workspace of type MRS_workspace where the
+ *      rotated second and fourth-rank tensor components are stored.
  * @param plan A pointer to the mrsimulator plan of type MRS_plan.
  * @param R0 The irreducible zeroth-rank frequency component.
  * @param R2 A pointer to an array of second-rank frequency components. The frequency
@@ -164,12 +231,64 @@ void MRS_get_amplitudes_from_plan(MRS_averaging_scheme *scheme, MRS_plan *plan,
  * @param dim The pointer to the dimension of type MRS_dimension.
  * @param fraction A float representing the fraction of dimension during an event.
  */
-void MRS_get_normalized_frequencies_from_plan(MRS_averaging_scheme *scheme,
-                                              MRS_plan *plan, double R0, complex128 *R2,
-                                              complex128 *R4, bool refresh,
-                                              MRS_dimension *dim, double fraction);
+void MRS_get_normalized_frequencies_from_plan(MRS_orientation_tables *scheme,
+                                              MRS_workspace *workspace, MRS_plan *plan,
+                                              double R0, complex128 *R2, complex128 *R4,
+                                              bool refresh, MRS_dimension *dim,
+                                              double fraction);
+
+/**
+ * @brief Fused evaluation of the normalized frequencies and the sideband phase factors
+ * at every orientation.
+ *
+ * Same as calling MRS_get_normalized_frequencies_from_plan() followed by the phase
+ * evaluation of MRS_get_amplitudes_from_plan(), except the tensor components are
+ * rotated one block of orientations at a time and consumed from cache, without writing
+ * the rotated components to the workspace. Call MRS_get_amplitudes_from_phases() to
+ * evaluate the sideband amplitudes from the phase factors.
+ *
+ * @param scheme The pointer to the powder averaging scheme of type
+ *      MRS_orientation_tables.
+ * @param plan A pointer to the mrsimulator plan of type MRS_plan.
+ * @param fftw_scheme A pointer to the fftw scheme of type MRS_fftw_scheme, where the
+ *      phase factors are written to the `vector` array.
+ * @param R0 The irreducible zeroth-rank frequency component.
+ * @param R2 A pointer to the second-rank frequency components, m = [-2, 2].
+ * @param R4 A pointer to the fourth-rank frequency components, m = [-4, 4].
+ * @param refresh If true, zero the frequencies before update, else self update.
+ * @param dim The pointer to the dimension of type MRS_dimension.
+ * @param fraction A float representing the fraction of dimension during an event.
+ */
+void MRS_get_normalized_frequencies_and_phases_from_plan(
+    MRS_orientation_tables *scheme, MRS_plan *plan, MRS_fftw_scheme *fftw_scheme,
+    double R0, complex128 *R2, complex128 *R4, bool refresh, MRS_dimension *dim,
+    double fraction);
 
-void MRS_get_frequencies_from_plan(MRS_averaging_scheme *scheme, MRS_plan *plan,
+/**
+ * @brief Same as MRS_get_normalized_frequencies_and_phases_from_plan(), except the
+ * rotated tensor components are combined from the rotated spatial tensor terms of the
+ * spin system, see MRS_set_spatial_basis(), instead of rotating the R2 and R4
+ * components.
+ *
+ * @param scheme The pointer to the powder averaging scheme of type
+ *      MRS_orientation_tables.
+ * @param plan A pointer to the mrsimulator plan of type MRS_plan.
+ * @param fftw_scheme A pointer to the fftw scheme of type MRS_fftw_scheme, where the
+ *      phase factors are written to the `vector` array.
+ * @param basis A pointer to the spatial basis of type MRS_spatial_basis.
+ * @param R0 The irreducible zeroth-rank frequency component.
+ * @param c2 A pointer to the `basis->n_terms_2` coefficients of the second-rank terms.
+ * @param c4 A pointer to the `basis->n_terms_4` coefficients of the fourth-rank terms.
+ * @param refresh If true, zero the frequencies before update, else self update.
+ * @param dim The pointer to the dimension of type MRS_dimension.
+ * @param fraction A float representing the fraction of dimension during an event.
+ */
+void MRS_get_normalized_frequencies_and_phases_from_basis(
+    MRS_orientation_tables *scheme, MRS_plan *plan, MRS_fftw_scheme *fftw_scheme,
+    MRS_spatial_basis *basis, double R0, const double *c2, const double *c4,
+    bool refresh, MRS_dimension *dim, double fraction);
+
+void MRS_get_frequencies_from_plan(MRS_orientation_tables *scheme, MRS_plan *plan,
                                    double R0, complex128 *R2, complex128 *R4,
                                    bool refresh, MRS_dimension *dim);
 
@@ -222,6 +341,57 @@ void MRS_rotate_components_from_PAS_to_common_frame(
     bool *freq_contrib           // The pointer to freq contribs boolean.
 );
 
+/**
+ * @brief The number of spatial tensor terms of a spin system, see
+ * MRS_set_spatial_basis().
+ *
+ * @param sites A pointer to the site_struct structure.
+ * @param couplings A pointer to the coupling_struct structure.
+ * @param allow_4th_rank A boolean, if true, include the second-order quadrupolar terms.
+ * @param n_terms_4 A pointer where the number of fourth-rank terms is stored.
+ * @return The number of second-rank terms.
+ */
+unsigned int MRS_count_spatial_basis_terms(site_struct *sites,
+                                           coupling_struct *couplings,
+                                           bool allow_4th_rank,
+                                           unsigned int *n_terms_4);
+
+/**
+ * @brief Evaluate the spatial tensors of every interaction of the spin system, without
+ * the spin transition functions, and rotate them over all orientations of the tables.
+ * The basis must hold at least MRS_count_spatial_basis_terms() terms.
+ *
+ * @param scheme The pointer to the powder averaging scheme of type
+ *      MRS_orientation_tables.
+ * @param basis A pointer to the spatial basis of type MRS_spatial_basis.
+ * @param sites A pointer to the site_struct structure.
+ * @param couplings A pointer to the coupling_struct structure.
+ * @param allow_4th_rank A boolean, if true, include the second-order quadrupolar terms.
+ */
+void MRS_set_spatial_basis(MRS_orientation_tables *scheme, MRS_spatial_basis *basis,
+                           site_struct *sites, coupling_struct *couplings,
+                           bool allow_4th_rank);
+
+/**
+ * @brief Evaluate the zeroth-rank frequency component and the coefficients of the
+ * spatial tensor terms of a spin transition, equivalent to
+ * MRS_rotate_components_from_PAS_to_common_frame().
+ *
+ * @param sites A pointer to the site_struct structure.
+ * @param couplings A pointer to the coupling_struct structure.
+ * @param basis A pointer to the spatial basis of the spin system.
+ * @param transition A pointer to the spin quantum numbers of the spin transition.
+ * @param B0_in_T The magnetic flux density of the external magnetic field in T.
+ * @param freq_contrib A pointer to the freq contribs booleans of the event.
+ * @param R0 A pointer where the zeroth-rank frequency component is stored.
+ * @param c2 A pointer to the coefficients of the second-rank terms.
+ * @param c4 A pointer to the coefficients of the fourth-rank terms.
+ */
+void MRS_get_spatial_basis_coefficients(site_struct *sites, coupling_struct *couplings,
+                                        MRS_spatial_basis *basis, float *transition,
+                                        double B0_in_T, bool *freq_contrib, double *R0,
+                                        double *c2, double *c4);
+
 extern void get_sideband_phase_components(unsigned int number_of_sidebands,
                                           double spin_frequency,
                                           double *restrict pre_phase);
@@ -14,10 +14,9 @@
 #include "octahedron.h"
 
 /**
- * @struct MRS_averaging_scheme
+ * @struct MRS_orientation_tables
  * A powder orientation scheme for simulating solid-state NMR spectra. An orientation
- * scheme creates buffers and tabulates values for faster computation of bulk NMR
- * spectra.
+ * scheme tabulates values for faster computation of bulk NMR spectra.
  *
  * The scheme includes
  *   - pre-calculating an array of orientations over the surface of the sphere where the
@@ -27,15 +26,17 @@
  * n_2, \beta_i)@f$, and fourth-rank, @f$d^4(n_1, n_2, \beta_i)@f$, matrices at every
  * orientation angle @f$\beta_i@f$,
  *   - pre-calculating the exponent, @f$\exp(-im\alpha_i)@f$, at every azimuthal angle,
- *     @f$\alpha_i@f$ and for @f$m \in [-4, 0]@f$, and
- *   - allocating buffers for storing and computing frequencies.
+ *     @f$\alpha_i@f$ and for @f$m \in [-4, 0]@f$.
+ *
+ * The tables are read-only after creation and may be shared between threads. The
+ * buffers for storing and computing frequencies are held separately in a MRS_workspace.
  *
  * Creating a new orientation averaging scheme adds an overhead to the computation. Once
  * created, however, the scheme may be re-used for as long as required. This is
  * especially efficient when performing a batch simulation, such as simulations from
  * thousands of sites.
  */
-typedef struct MRS_averaging_scheme {
+typedef struct MRS_orientation_tables {
   unsigned int total_orientations; /**< The total number of orientations. */
 
   /** \privatesection */
@@ -46,15 +47,52 @@ typedef struct MRS_averaging_scheme {
   double *amplitudes;                //  array of amplitude scaling per orientation.
   complex128 *exp_Im_alpha;          //  array of e^in\alpha n=[0,4] per orientation.
   complex128 *exp_Im_gamma;          //  array of e^im\gamma m=[0,4] per orientation.
-  complex128 *w2;                    //  buffer for 2nd rank frequency calculation.
-  complex128 *w4;                    //  buffer for 4nd rank frequency calculation.
-  double *wigner_2j_matrices;        //  wigner-d 2j matrix per orientation.
-  double *wigner_4j_matrices;        //  wigner-d 4j matrix per orientation.
-  double *scrach;                    //  sscrach memory for calculations.
+  double *wigner_2j_matrices;        //  symmetric wigner-d 2j half-matrices (SoA).
+  double *wigner_4j_matrices;        //  symmetric wigner-d 4j half-matrices (SoA).
   bool allow_4th_rank;  //  If true, compute wigner matrices for wigner-d 4j.
-} MRS_averaging_scheme;
+} MRS_orientation_tables;
+
+/**
+ * @struct MRS_workspace
+ * The buffers for computing the frequencies over the orientations of a
+ * MRS_orientation_tables. Unlike the tables, the workspace is overwritten during the
+ * simulation, therefore, every thread requires its own workspace.
+ */
+typedef struct MRS_workspace {
+  /** \privatesection */
+  complex128 *w2;  //  buffer for 2nd rank frequency calculation.
+  complex128 *w4;  //  buffer for 4nd rank frequency calculation.
+  double *scrach;  //  sscrach memory for calculations.
+} MRS_workspace;
+
+/**
+ * The maximum number of spatial tensor terms per rank held by a MRS_spatial_basis.
+ */
+#define MRS_SPATIAL_BASIS_MAX_TERMS 8
+
+/**
+ * @struct MRS_spatial_basis
+ * The spatial tensors of the interactions of a spin system, rotated over the
+ * orientations of a MRS_orientation_tables. The frequency components of every
+ * transition pathway are linear combinations of the spatial tensors with the spin
+ * transition functions as weights, therefore, the rotated tensors are combined instead
+ * of rotating the components of every pathway, see
+ * MRS_get_normalized_frequencies_and_phases_from_basis(). Every thread requires its own
+ * basis.
+ */
+typedef struct MRS_spatial_basis {
+  unsigned int max_terms; /**< The maximum number of terms per rank. */
+  unsigned int n_terms_2; /**< The number of second-rank terms. */
+  unsigned int n_terms_4; /**< The number of fourth-rank terms. */
+  bool allow_4th_rank;    /**< If true, the basis includes the fourth-rank terms. */
 
-// typedef struct MRS_averaging_scheme;
+  /** \privatesection */
+  double *r0;  //  the zeroth-rank component paired with every second-rank term.
+  double *w2;  //  the rotated 2nd rank terms, 6 x total_orientations per term.
+  double *w4;  //  the rotated 4th rank terms, 10 x total_orientations per term.
+} MRS_spatial_basis;
+
+// typedef struct MRS_orientation_tables;
 
 /**
  * Create a new orientation averaging scheme.
@@ -72,7 +110,7 @@ typedef struct MRS_averaging_scheme {
  * tensors.
  * @param integration_volume An enumeration. 0=octant, 1=hemisphere
  */
-MRS_averaging_scheme *MRS_create_averaging_scheme(unsigned int integration_density,
+MRS_orientation_tables *MRS_create_orientation_tables(unsigned int integration_density,
                                                   bool allow_4th_rank,
                                                   unsigned int n_gamma,
                                                   unsigned int integration_volume);
@@ -91,7 +129,7 @@ MRS_averaging_scheme *MRS_create_averaging_scheme(unsigned int integration_densi
  * @param allow_4th_rank If true, the scheme also calculates matrices for fourth-rank
  * tensors.
  */
-MRS_averaging_scheme *MRS_create_averaging_scheme_from_alpha_beta(double *alpha,
+MRS_orientation_tables *MRS_create_orientation_tables_from_alpha_beta(double *alpha,
                                                                   double *beta,
                                                                   double *weight,
                                                                   unsigned int n_angles,
@@ -100,9 +138,69 @@ MRS_averaging_scheme *MRS_create_averaging_scheme_from_alpha_beta(double *alpha,
 /**
  * Free the memory allocated for the spatial orientation averaging scheme.
  *
- * @param scheme A pointer to the MRS_averaging_scheme.
+ * @param scheme A pointer to the MRS_orientation_tables.
+ */
+void MRS_free_orientation_tables(MRS_orientation_tables *scheme);
+
+/**
+ * Create a new workspace for the given orientation tables.
+ *
+ * @param scheme A pointer to the MRS_orientation_tables.
+ */
+MRS_workspace *MRS_create_workspace(MRS_orientation_tables *scheme);
+
+/**
+ * Free the memory allocated for the workspace.
+ *
+ * @param workspace A pointer to the MRS_workspace.
+ */
+void MRS_free_workspace(MRS_workspace *workspace);
+
+/**
+ * Create a new spatial basis for up to @p max_terms rotated tensor terms per rank over
+ * the orientations of the given tables. The rotated terms take `2(l+1) x
+ * total_orientations` doubles per term of rank l.
+ *
+ * @param scheme A pointer to the MRS_orientation_tables.
+ * @param max_terms The maximum number of terms per rank.
+ */
+MRS_spatial_basis *MRS_create_spatial_basis(MRS_orientation_tables *scheme,
+                                            unsigned int max_terms);
+
+/**
+ * Free the memory allocated for the spatial basis.
+ *
+ * @param basis A pointer to the MRS_spatial_basis.
+ */
+void MRS_free_spatial_basis(MRS_spatial_basis *basis);
+
+/**
+ * The maximum number of orientation tables held by the process-wide cache. Tables
+ * which are no longer referenced are evicted in the least recently used order once
+ * the cache is full.
+ */
+#define MRS_TABLES_CACHE_SIZE 8
+
+/**
+ * Return a reference to the orientation tables from the process-wide cache, creating
+ * and caching the tables on the first request. The tables are keyed by
+ * (integration_density, integration_volume, n_gamma, allow_4th_rank), see
+ * MRS_create_orientation_tables() for the description of the arguments. Every acquired
+ * reference must be released with MRS_release_orientation_tables(). The function is
+ * thread safe.
+ */
+MRS_orientation_tables *MRS_acquire_orientation_tables(unsigned int integration_density,
+                                                       bool allow_4th_rank,
+                                                       unsigned int n_gamma,
+                                                       unsigned int integration_volume);
+
+/**
+ * Release a reference to the orientation tables acquired with
+ * MRS_acquire_orientation_tables(). The tables remain cached for re-use.
+ *
+ * @param scheme A pointer to the MRS_orientation_tables.
  */
-void MRS_free_averaging_scheme(MRS_averaging_scheme *scheme);
+void MRS_release_orientation_tables(MRS_orientation_tables *scheme);
 
 #endif  // averaging_scheme_h
 
@@ -118,9 +216,85 @@ typedef struct MRS_fftw_scheme {
   fftw_plan the_fftw_plan;  //  The plan for fftw routine.
 } MRS_fftw_scheme;
 
+/** The fftw planner rigor. See MRS_set_fftw_plan_rigor(). */
+#define MRS_FFTW_ESTIMATE 0
+#define MRS_FFTW_MEASURE 1
+#define MRS_FFTW_PATIENT 2
+
+/**
+ * Create a new fftw scheme for the sideband transform over all orientations. The plan
+ * is created with the planner rigor set with MRS_set_fftw_plan_rigor().
+ *
+ * @param total_orientations The total number of orientations.
+ * @param number_of_sidebands The number of sidebands.
+ */
 MRS_fftw_scheme *create_fftw_scheme(unsigned int total_orientations,
                                     unsigned int number_of_sidebands);
 
 void MRS_free_fftw_scheme(MRS_fftw_scheme *fftw_scheme);
 
+/** The maximum number of fftw schemes held by the process-wide cache. */
+#define MRS_FFTW_CACHE_SIZE 64
+
+/**
+ * Return a fftw scheme from the process-wide cache, creating and caching a new scheme
+ * when no unused scheme of the same size exists. Unlike the orientation tables, the
+ * fftw scheme buffer is overwritten during the simulation, therefore, a cached scheme
+ * is handed to at most one caller at a time. Every acquired scheme must be returned
+ * with MRS_release_fftw_scheme(). The function is thread safe.
+ *
+ * @param total_orientations The total number of orientations.
+ * @param number_of_sidebands The number of sidebands.
+ */
+MRS_fftw_scheme *MRS_acquire_fftw_scheme(unsigned int total_orientations,
+                                         unsigned int number_of_sidebands);
+
+/**
+ * Return the fftw scheme acquired with MRS_acquire_fftw_scheme() to the cache.
+ *
+ * @param fftw_scheme A pointer to the MRS_fftw_scheme.
+ */
+void MRS_release_fftw_scheme(MRS_fftw_scheme *fftw_scheme);
+
+/**
+ * Free all unreferenced orientation tables and fftw schemes held by the process-wide
+ * caches.
+ */
+void MRS_clear_cache();
+
+/**
+ * Set the planner rigor of the fftw plans created after the call. The valid values are
+ *    - MRS_FFTW_ESTIMATE, a heuristic plan with no planning cost (default),
+ *    - MRS_FFTW_MEASURE, a plan tuned by timing several algorithms, and
+ *    - MRS_FFTW_PATIENT, a plan tuned by timing a wider range of algorithms.
+ * Tuned plans take longer to create, which is offset by re-using the plans from the
+ * cache, and by persisting the fftw wisdom with MRS_export_fftw_wisdom(). Cached fftw
+ * schemes are only re-used for requests with the same rigor.
+ *
+ * @param rigor The planner rigor.
+ */
+void MRS_set_fftw_plan_rigor(unsigned int rigor);
+
+/**
+ * Import the fftw wisdom from the given file. The function is thread safe.
+ *
+ * @param filename The path to the wisdom file.
+ * @return 1 on success, else 0.
+ */
+int MRS_import_fftw_wisdom(const char *filename);
+
+/**
+ * Export the accumulated fftw wisdom to the given file. The function is thread safe.
+ *
+ * @param filename The path to the wisdom file.
+ * @return 1 on success, else 0.
+ */
+int MRS_export_fftw_wisdom(const char *filename);
+
+/**
+ * Return the number of fftw plans created with a rigor other than MRS_FFTW_ESTIMATE.
+ * A change in the count indicates new wisdom worth exporting.
+ */
+unsigned long MRS_fftw_tuned_plan_count();
+
 #endif  // fftw_scheme_h
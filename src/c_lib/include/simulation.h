@@ -7,6 +7,9 @@
 //  Contact email = srivastava.89@osu.edu
 //
 
+#ifndef simulation_h
+#define simulation_h
+
 #include "method.h"
 #include "mrsimulator.h"
 #include "octahedron.h"
@@ -48,10 +51,13 @@ extern void __mrsimulator_core(
     // The energy states are given in Zeeman basis.
     float *transition_pathway,          // Pointer to a list of transitions.
     double *transition_pathway_weight,  // The complex weight of transition pathway.
+    double weight,                      // The scaling factor (abundance) of spectrum.
     int n_dimension,                    // The total number of spectroscopic dimensions.
     MRS_dimension *dimensions,          // Pointer to MRS_dimension structure.
     MRS_fftw_scheme *fftw_scheme,       // Pointer to the fftw scheme.
-    MRS_averaging_scheme *scheme,       // Pointer to the powder averaging scheme.
+    MRS_orientation_tables *scheme,     // Pointer to the powder averaging scheme.
+    MRS_workspace *workspace,           // Pointer to the scheme workspace.
+    MRS_spatial_basis *basis,  // Pointer to the spatial basis of spin system, or NULL.
     bool interpolation,                 // If true, perform a 1D interpolation.
     unsigned int interpolate_type,
 
@@ -72,3 +78,180 @@ extern void __mrsimulator_core(
     bool *freq_contrib,
     double *affine_matrix  // Affine transformation matrix.
 );
+
+typedef struct __worker_state __worker_state;
+
+/**
+ * @struct MRS_simulation_plan
+ * A compiled method for simulating spectra from lists of spin systems. The plan holds
+ * the orientation tables, and one set of spectral dimensions, workspace, and fftw
+ * scheme for every thread, so that the repeated simulations, for example, from a
+ * least-squares fit, only evaluate the spin systems.
+ */
+typedef struct MRS_simulation_plan {
+  /** \privatesection */
+  int n_points;                    // Total number of points of a single spectrum.
+  int n_dimension;                 // The number of spectroscopic dimensions.
+  int n_threads;                   // The number of threads.
+  bool interpolation;              // If true, perform a 1D interpolation.
+  unsigned int iso_intrp;          // Isotropic interpolation scheme.
+  bool isotropic_convolution;      // If true, convolve isotropic shift distributions.
+  bool *freq_contrib;              // A stack of freq_contrib booleans per event.
+  double affine_matrix[4];         // Affine transformation matrix.
+  MRS_orientation_tables *scheme;  // The shared orientation tables.
+  __worker_state *states;          // The worker states, one per thread.
+} MRS_simulation_plan;
+
+/**
+ * @brief Create a simulation plan for a method. The arguments follow
+ * mrsimulator_core_batch(). The arrays are copied and may be released after the call.
+ *
+ * @param n_points The total number of points of a single spectrum.
+ * @param n_threads The maximum number of threads used by MRS_run_simulation_plan().
+ * @return A pointer to the MRS_simulation_plan.
+ */
+extern MRS_simulation_plan *MRS_create_simulation_plan(
+    int n_points, int n_dimension, int *count, double *coordinates_offset,
+    double *increment, double *fractions, double *magnetic_flux_density_in_T,
+    double *rotor_frequency_in_Hz, double *rotor_angle_in_rad, int *n_events,
+    unsigned int *number_of_sidebands, unsigned int integration_density,
+    unsigned int integration_volume, unsigned int n_gamma, bool allow_4th_rank,
+    bool interpolation, unsigned int iso_intrp, bool *freq_contrib,
+    double *affine_matrix, int n_threads);
+
+/**
+ * @brief Release the memory allocated for the simulation plan.
+ *
+ * @param plan A pointer to the MRS_simulation_plan.
+ */
+extern void MRS_free_simulation_plan(MRS_simulation_plan *plan);
+
+/**
+ * @brief Enable or disable the isotropic shift convolution of the simulation plan.
+ *
+ * When enabled, and the spectra are not decomposed, MRS_run_simulation_plan() groups
+ * the single-site spin systems without couplings which differ only in the isotropic
+ * chemical shift. The lineshape of a group is evaluated once per transition pathway
+ * and convolved with the abundance weighted histogram of the isotropic shifts. The
+ * shifts are split linearly between the two nearest spectral bins, therefore, the
+ * spectrum is slightly broadened compared to the default simulation. The default is
+ * disabled.
+ *
+ * @param plan A pointer to the MRS_simulation_plan.
+ * @param enable If true, enable the isotropic shift convolution.
+ */
+extern void MRS_set_simulation_plan_isotropic_convolution(MRS_simulation_plan *plan,
+                                                          bool enable);
+
+/**
+ * @brief Set the amplitude threshold of the simulation plan.
+ *
+ * The octants of a sideband order whose largest amplitude is at most `threshold` times
+ * the largest amplitude of the transition pathway are not interpolated. The octants
+ * whose frequencies lie outside the spectral window are always skipped. The default
+ * threshold is zero, which only skips the octants outside the spectral window and
+ * leaves the spectrum unchanged.
+ *
+ * @param plan A pointer to the MRS_simulation_plan.
+ * @param threshold The amplitude threshold, as a fraction of the largest amplitude.
+ */
+extern void MRS_set_simulation_plan_amplitude_threshold(MRS_simulation_plan *plan,
+                                                        double threshold);
+
+/**
+ * @brief Evaluate the spectra from a list of spin systems using a simulation plan.
+ * The arguments follow mrsimulator_core_batch(). A plan must not be run from more
+ * than one thread at a time.
+ *
+ * All transition pathways of all spin systems are processed in this one call. The
+ * threads share the spin systems, and when there are fewer spin systems than threads,
+ * the pathways of a spin system are split between the threads, each accumulating into
+ * a private spectrum which is added to the output at the end.
+ *
+ * @param plan A pointer to the MRS_simulation_plan.
+ */
+extern void MRS_run_simulation_plan(
+    MRS_simulation_plan *plan, double *spec, bool decompose_spectrum,
+    int n_spin_systems, site_struct *sites, coupling_struct *couplings,
+    float **transition_pathways, double **transition_pathway_weights,
+    int *pathway_count, int *pathway_increment, double *scale);
+
+/**
+ * @brief Evaluate the spectra from a batch of single-site spin systems of the same
+ * isotope, given as a structure of arrays. The i-th spin system is described by the
+ * i-th element of the per-site arrays, and the i-th triplet of Euler angles of the
+ * orientation arrays. As the sites share the isotope, the spin systems also share the
+ * transition pathways. Otherwise, the arguments follow MRS_run_simulation_plan().
+ *
+ * @param spin The spin quantum number of the sites.
+ * @param gyromagnetic_ratio The gyromagnetic ratio of the sites in MHz/T.
+ * @param isotropic_chemical_shift_in_ppm The isotropic chemical shifts in ppm.
+ * @param shielding_symmetric_zeta_in_ppm The shielding anisotropies in ppm.
+ * @param shielding_symmetric_eta The shielding asymmetries.
+ * @param shielding_orientation The shielding Euler angles (α, β, γ) in radians.
+ * @param quadrupolar_Cq_in_Hz The quadrupolar coupling constants in Hz.
+ * @param quadrupolar_eta The quadrupolar asymmetries.
+ * @param quadrupolar_orientation The quadrupolar Euler angles (α, β, γ) in radians.
+ * @param transition_pathway The packed transition pathways of a single site.
+ * @param transition_pathway_weight The complex weights of the transition pathways.
+ * @param pathway_count The number of transition pathways.
+ * @param pathway_increment The length of a single transition pathway.
+ */
+extern void MRS_run_simulation_plan_single_site(
+    MRS_simulation_plan *plan, double *spec, bool decompose_spectrum,
+    int n_spin_systems, float spin, double gyromagnetic_ratio,
+    double *isotropic_chemical_shift_in_ppm, double *shielding_symmetric_zeta_in_ppm,
+    double *shielding_symmetric_eta, double *shielding_orientation,
+    double *quadrupolar_Cq_in_Hz, double *quadrupolar_eta,
+    double *quadrupolar_orientation, float *transition_pathway,
+    double *transition_pathway_weight, int pathway_count, int pathway_increment,
+    double *scale);
+
+/**
+ * @brief Evaluate the spectra from a list of spin systems over all transition pathways
+ * of every spin system.
+ *
+ * The spin systems are distributed over @p n_threads OpenMP threads, and with fewer
+ * spin systems than threads, so are their transition pathways. The orientation
+ * tables are shared between the threads. Every thread owns a private workspace,
+ * spectral dimensions, and fftw scheme, and accumulates a private spectrum, which is
+ * reduced into @p spec at the end. When the library is compiled without OpenMP
+ * support, the spin systems are evaluated serially.
+ *
+ * The function is a shorthand for creating, running, and freeing a
+ * MRS_simulation_plan. The orientation tables and fftw schemes are drawn from the
+ * process-wide cache, see MRS_acquire_orientation_tables(), so that repeated calls
+ * with the same powder averaging parameters skip the setup. Use MRS_clear_cache() to
+ * release the memory.
+ *
+ * @param spec A pointer to the spectrum array (complex) of size 2 x @p n_points, or
+ *      2 x @p n_points x @p n_spin_systems when @p decompose_spectrum is true.
+ * @param n_points The total number of points of a single spectrum.
+ * @param decompose_spectrum If true, the spectrum from every spin system is written to
+ *      its own slice of @p spec, else the spectra are added.
+ * @param n_spin_systems The number of spin systems.
+ * @param sites An array of site_struct, one per spin system.
+ * @param couplings An array of coupling_struct, one per spin system.
+ * @param transition_pathways An array of pointers to the packed transition pathways of
+ *      every spin system.
+ * @param transition_pathway_weights An array of pointers to the complex weights of the
+ *      transition pathways of every spin system.
+ * @param pathway_count The number of transition pathways per spin system. Spin systems
+ *      with zero pathways are skipped.
+ * @param pathway_increment The length of a single transition pathway per spin system.
+ * @param scale The scaling factor of the spectrum per spin system.
+ * @param n_threads The number of threads.
+ */
+extern void mrsimulator_core_batch(
+    double *spec, int n_points, bool decompose_spectrum, int n_spin_systems,
+    site_struct *sites, coupling_struct *couplings, float **transition_pathways,
+    double **transition_pathway_weights, int *pathway_count, int *pathway_increment,
+    double *scale, int n_dimension, int *count, double *coordinates_offset,
+    double *increment, double *fractions, double *magnetic_flux_density_in_T,
+    double *rotor_frequency_in_Hz, double *rotor_angle_in_rad, int *n_events,
+    unsigned int *number_of_sidebands, unsigned int integration_density,
+    unsigned int integration_volume, unsigned int n_gamma, bool allow_4th_rank,
+    bool interpolation, unsigned int iso_intrp, bool *freq_contrib,
+    double *affine_matrix, int n_threads);
+
+#endif /* simulation_h */
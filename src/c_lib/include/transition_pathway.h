@@ -0,0 +1,61 @@
+// -*- coding: utf-8 -*-
+//
+//  transition_pathway.h
+//
+//  @copyright Deepansh J. Srivastava, 2019-2021.
+//  Created by Deepansh J. Srivastava, Oct 16, 2026.
+//  Contact email = srivastava.89@osu.edu
+//
+
+#ifndef transition_pathway_h
+#define transition_pathway_h
+#include <string.h>
+
+#include "config.h"
+
+/**
+ * Enumerate the transition pathways as the cartesian product of the transitions
+ * selected at each event. A transition of an `n_sites` spin system is the `2 * n_sites`
+ * quantum numbers of the initial energy state followed by those of the final energy
+ * state. The pathways are ordered with the transition index of the last event varying
+ * the fastest.
+ *
+ * @param n_events The number of events, excluding the mixing events.
+ * @param counts The number of transitions selected at each event.
+ * @param segments The selected transitions, concatenated over the events, of shape
+ *          (sum(counts), 2, n_sites).
+ * @param n_sites The number of sites in the spin system.
+ * @param pathways The output transition pathways of shape
+ *          (prod(counts), n_events, 2, n_sites).
+ */
+void MRS_transition_pathways(const unsigned int n_events, const unsigned int *counts,
+                             const float *segments, const unsigned int n_sites,
+                             float *restrict pathways);
+
+/**
+ * Multiply the complex weights of the transition pathways with the connect factor of
+ * the transitions at events `event_1` and `event_2`, where the connecting rotation of
+ * every site is given by the ZYZ Euler angles, alpha, beta, and gamma. The weights of
+ * all pathways are evaluated in one call, one site at a time.
+ *
+ * @param n_pathways The number of transition pathways.
+ * @param n_events The number of transitions per pathway.
+ * @param n_sites The number of sites in the spin system.
+ * @param pathways The transition pathways of shape (n_pathways, n_events, 2, n_sites).
+ * @param spins The spin quantum numbers of the sites.
+ * @param event_1 The event index of the starting transitions.
+ * @param event_2 The event index of the connecting transitions.
+ * @param alpha The first Euler angle of every site.
+ * @param beta The second Euler angle of every site.
+ * @param gamma The third Euler angle of every site.
+ * @param weights The interleaved complex weights of the pathways, updated in place.
+ */
+void MRS_transition_pathway_weights(const unsigned int n_pathways,
+                                    const unsigned int n_events,
+                                    const unsigned int n_sites, const float *pathways,
+                                    const float *spins, const unsigned int event_1,
+                                    const unsigned int event_2, const double *alpha,
+                                    const double *beta, const double *gamma,
+                                    double *restrict weights);
+
+#endif /* transition_pathway_h */
@@ -397,6 +397,29 @@ static inline void vm_double_complex_exp_imag_only(int count, const void *restri
   }
 }
 
+/**
+ * Exponent of the imaginary vector I x stored in res of type complex128.
+ *      res = exp(I x)
+ * Same as vm_double_complex_exp_imag_only, except x is a double array.
+ */
+static inline void vm_double_complex_exp_I(int count, const double *restrict x,
+                                           void *restrict res) {
+  double *res_ = (double *)res;
+  double y, wt;
+  int i;
+
+  while (count-- > 0) {
+    y = absd(*x);
+    y = modd(y, CONST_2PI);
+    y *= trig_table_precision_inverse;
+    i = (int)y;
+    wt = y - i;
+    *res_++ = lerp(wt, cos_table[i], cos_table[i + 1]);
+    *res_++ = lerp(wt, sin_table[i], sin_table[i + 1]) * sign(*x);
+    x++;
+  }
+}
+
 #ifndef __blas_activate
 //========================================================================== //
 //                  Wrapper for blas and blas like functions                 //
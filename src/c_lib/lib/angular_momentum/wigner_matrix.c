@@ -564,6 +564,95 @@ void __wigner_rotation_2(const int l, const int n, const double *wigner,
   }
 }
 
+void wigner_d_matrices_to_symmetric_soa(const int l, const int n,
+                                        const double *wigner, double *wigner_soa) {
+  int orientation, m, k, n1 = 2 * l + 1;
+  double sign;
+  const double *row;
+  double *out;
+
+  for (orientation = 0; orientation < n; orientation++) {
+    for (m = 0; m <= l; m++) {
+      row = &wigner[(orientation * (l + 1) + m) * n1];
+      out = &wigner_soa[m * n1 * n + orientation];
+      out[0] = row[l];
+      sign = -1.0;  // (-1)^k
+      for (k = 1; k <= l; k++) {
+        out[k * n] = row[l - k] + sign * row[l + k];
+        out[(l + k) * n] = row[l - k] - sign * row[l + k];
+        sign = -sign;
+      }
+    }
+  }
+}
+
+MRS_SIMD_CLONES
+void __wigner_rotation_soa_block(const int l, const int n, const int start,
+                                 const int size, const double *wigner,
+                                 const void *exp_Im_alpha, const void *R_in,
+                                 double *R_out_re, double *R_out_im) {
+  const double *exp_Im_alpha_ = (const double *)exp_Im_alpha;
+  const double *R_in_ = (const double *)R_in;
+
+  int i, m, k, n1 = 2 * l + 1;
+  double re, im, r0_re = R_in_[2 * l], r0_im = R_in_[2 * l + 1];
+  const double *exp_k, *w0, *wa, *wb;
+  double *o_re, *o_im;
+
+  // Split real and imaginary parts of R(-k) exp(-ik alpha), k = 1..l, over the block.
+  double t_re[4][MRS_WIGNER_BLOCK], t_im[4][MRS_WIGNER_BLOCK];
+
+  for (k = 1; k <= l; k++) {
+    re = R_in_[2 * (l - k)];
+    im = R_in_[2 * (l - k) + 1];
+    exp_k = &exp_Im_alpha_[2 * ((4 - k) * n + start)];
+    for (i = 0; i < size; i++) {
+      t_re[k - 1][i] = re * exp_k[2 * i] - im * exp_k[2 * i + 1];
+      t_im[k - 1][i] = re * exp_k[2 * i + 1] + im * exp_k[2 * i];
+    }
+  }
+
+  for (m = 0; m <= l; m++) {
+    w0 = &wigner[m * n1 * n + start];
+    o_re = &R_out_re[m * MRS_WIGNER_BLOCK];
+    o_im = &R_out_im[m * MRS_WIGNER_BLOCK];
+    for (i = 0; i < size; i++) {
+      o_re[i] = w0[i] * r0_re;
+      o_im[i] = w0[i] * r0_im;
+    }
+    for (k = 1; k <= l; k++) {
+      wa = w0 + k * n;
+      wb = w0 + (l + k) * n;
+      for (i = 0; i < size; i++) {
+        o_re[i] += wa[i] * t_re[k - 1][i];
+        o_im[i] += wb[i] * t_im[k - 1][i];
+      }
+    }
+  }
+}
+
+void __wigner_rotation_soa(const int l, const int n, const double *wigner,
+                           const void *exp_Im_alpha, const void *R_in, void *R_out) {
+  double *R_out_ = (double *)R_out;
+  int start, size, i, m, stride = 2 * (l + 1);
+  double o_re[5 * MRS_WIGNER_BLOCK], o_im[5 * MRS_WIGNER_BLOCK], *out;
+
+  for (start = 0; start < n; start += MRS_WIGNER_BLOCK) {
+    size = (n - start < MRS_WIGNER_BLOCK) ? n - start : MRS_WIGNER_BLOCK;
+    __wigner_rotation_soa_block(l, n, start, size, wigner, exp_Im_alpha, R_in, o_re,
+                                o_im);
+
+    // Interleave to the complex output, `l+1` components per orientation.
+    for (m = 0; m <= l; m++) {
+      out = &R_out_[start * stride + 2 * m];
+      for (i = 0; i < size; i++) {
+        out[i * stride] = o_re[m * MRS_WIGNER_BLOCK + i];
+        out[i * stride + 1] = o_im[m * MRS_WIGNER_BLOCK + i];
+      }
+    }
+  }
+}
+
 // ✅ .. note: (wigner_dm0_vector) monitored with pytest .....................
 void wigner_dm0_vector(const int l, const double beta, double *R_out) {
   double sx2, sx3, cx2, cxm1, cxm12, temp;
@@ -733,11 +822,57 @@ void single_wigner_rotation(const int l, const double *euler_angles, const void
  *      rotation with fourth rank wigner matrices. The length of w4 is
  *      `octant_orientations x n_octants x 9` with 9 as the leading dimension.
  */
+/**
+ * With p = mk % 4,
+ *
+ *    (-i)^p =  1 for p = 0,
+ *    (-i)^p = -i for p = 1,
+ *    (-i)^p = -1 for p = 2,
+ *    (-i)^p =  i for p = 3.
+ *
+ * Multiplication with the above factors is exact, i.e., only swaps and sign flips.
+ */
+void __step_alpha_phase(const int l, const unsigned int k, const double *R_in,
+                        double *R_out) {
+  int m, two_l = 2 * l, idx;
+  unsigned int phase;
+  double re, im;
+
+  for (m = -l; m <= l; m++) {
+    idx = two_l + 2 * m;
+    re = R_in[idx];
+    im = R_in[idx + 1];
+    // the phase (-i)^(-mk) written as a non-negative power of -i.
+    phase = (unsigned int)((4 - (m % 4)) * k) % 4;
+    switch (phase) {
+    case 0:
+      R_out[idx] = re;
+      R_out[idx + 1] = im;
+      break;
+    case 1:
+      R_out[idx] = im;
+      R_out[idx + 1] = -re;
+      break;
+    case 2:
+      R_out[idx] = -re;
+      R_out[idx + 1] = -im;
+      break;
+    case 3:
+      R_out[idx] = -im;
+      R_out[idx + 1] = re;
+      break;
+    }
+  }
+}
+
 void __batch_wigner_rotation(const unsigned int octant_orientations,
-                             const unsigned int n_octants, double *wigner_2j_matrices,
-                             complex128 *R2, double *wigner_4j_matrices, complex128 *R4,
-                             complex128 *exp_Im_alpha, complex128 *w2, complex128 *w4) {
+                             const unsigned int n_octants,
+                             const double *wigner_2j_matrices, const complex128 *R2,
+                             const double *wigner_4j_matrices, const complex128 *R4,
+                             const complex128 *exp_Im_alpha, complex128 *w2,
+                             complex128 *w4) {
   unsigned int j, wigner_2j_inc, wigner_4j_inc = 0, w2_increment, w4_increment = 0;
+  complex128 R2_j[5], R4_j[9];
 
   w2_increment = 3 * octant_orientations;
   wigner_2j_inc = 5 * w2_increment;  // equal to 5 x 3 x octant_orientations;
@@ -747,64 +882,101 @@ void __batch_wigner_rotation(const unsigned int octant_orientations,
   }
 
   for (j = 0; j < n_octants; j++) {
+    /**
+     * Stepping the alpha phase by π/2.
+     *
+     * The orientations of the j^th octant differ from the first octant by alpha +=
+     * jπ/2. Rather than updating the exp_Im_alpha table, which is shared and
+     * read-only, the phase step is applied to the tensor components.
+     *
+     *    R(m) exp(-Im(alpha + jπ/2)) = [R(m) (-i)^(mj)] exp(-Im alpha)
+     *
+     * The phase repeats after four octants.
+     */
+    __step_alpha_phase(2, j % 4, (double *)R2, (double *)R2_j);
+
     /* Second-rank Wigner rotation from crystal/common frame to rotor frame. */
-    __wigner_rotation_2(2, octant_orientations, wigner_2j_matrices, exp_Im_alpha, R2,
-                        w2);
+    __wigner_rotation_soa(2, octant_orientations, wigner_2j_matrices, exp_Im_alpha,
+                          R2_j, w2);
     w2 += w2_increment;
     if (n_octants == 8) {
-      __wigner_rotation_2(2, octant_orientations, &wigner_2j_matrices[wigner_2j_inc],
-                          exp_Im_alpha, R2, w2);
+      __wigner_rotation_soa(2, octant_orientations, &wigner_2j_matrices[wigner_2j_inc],
+                            exp_Im_alpha, R2_j, w2);
       w2 += w2_increment;
     }
     if (w4 != NULL) {
+      __step_alpha_phase(4, j % 4, (double *)R4, (double *)R4_j);
+
       /* Fourth-rank Wigner rotation from crystal/common frame to rotor frame. */
-      __wigner_rotation_2(4, octant_orientations, wigner_4j_matrices, exp_Im_alpha, R4,
-                          w4);
+      __wigner_rotation_soa(4, octant_orientations, wigner_4j_matrices, exp_Im_alpha,
+                            R4_j, w4);
       w4 += w4_increment;
       if (n_octants == 8) {
-        __wigner_rotation_2(4, octant_orientations, &wigner_4j_matrices[wigner_4j_inc],
-                            exp_Im_alpha, R4, w4);
+        __wigner_rotation_soa(4, octant_orientations,
+                              &wigner_4j_matrices[wigner_4j_inc], exp_Im_alpha, R4_j,
+                              w4);
         w4 += w4_increment;
       }
     }
-    /**
-     * Documentation
-     * -------------
-     *
-     * Stepping the alpha phase by π/2.
-     *
-     * The array exp_Im_alpha is a two-dimensional array of shape
-     * `4 x number_of_sidebands`, where
-     *
-     * exp_Im_alpha[m, :] = exp(I (4-m) alpha) for m=[0, 1, 2, 3]. When alpha += π/2
-     *
-     *    exp_Im_alpha[0, :] = exp(I 4alpha) * exp(I 4π/2) = exp(I 4alpha)
-     *    exp_Im_alpha[0, :] *= 1
-     *
-     *    exp_Im_alpha[1, :] = exp(I 3alpha) * exp(I 3π/2) = -i exp(I 3alpha)
-     *    exp_Im_alpha[1, :] *= -I
-     *
-     *    exp_Im_alpha[2, :] = exp(I 2alpha) * exp(I 2π/2) = -1 exp(I 2alpha)
-     *    exp_Im_alpha[2, :] *= -1
-     *
-     *    exp_Im_alpha[3, :] = exp(I 1alpha) * exp(I 1π/2) = i exp(I 1alpha)
-     *    exp_Im_alpha[3, :] *= I
-     *
-     * After four iterations, exp_Im_alpha restores to its original value.
-     */
-    if (n_octants != 1) {
-      cblas_zscal(octant_orientations, (double *)NEGATIVE_IOTA,
-                  &(((double *)exp_Im_alpha)[6 * octant_orientations]), 1);
-      cblas_zdscal(octant_orientations, -1,
-                   &(((double *)exp_Im_alpha)[4 * octant_orientations]), 1);
-      if (w4 != NULL) {
-        cblas_zscal(octant_orientations, (double *)IOTA,
-                    &(((double *)exp_Im_alpha)[2 * octant_orientations]), 1);
+  }
+}
+
+void wigner_rotation_gemm_matrix(const int l, const int n, const double *wigner,
+                                 const void *exp_Im_alpha, double *matrix) {
+  const double *exp_Im_alpha_ = (const double *)exp_Im_alpha, *w0, *wa, *wb, *exp_k;
+  int i, m, k, n1 = 2 * l + 1, ld = 2 * l + 2;
+  double *re_row, *im_row;
+
+  for (m = 0; m <= l; m++) {
+    w0 = &wigner[m * n1 * n];
+    for (i = 0; i < n; i++) {
+      re_row = &matrix[(m * n + i) * ld];
+      im_row = &matrix[((l + 1 + m) * n + i) * ld];
+      re_row[0] = w0[i];
+      re_row[1] = 0.0;
+      im_row[0] = 0.0;
+      im_row[1] = w0[i];
+      for (k = 1; k <= l; k++) {
+        wa = w0 + k * n;
+        wb = w0 + (l + k) * n;
+        exp_k = &exp_Im_alpha_[2 * ((4 - k) * n + i)];
+        // Re(R[-k] exp_k) and Im(R[-k] exp_k) from Re(R[-k]) and Im(R[-k]).
+        re_row[1 + k] = wa[i] * exp_k[0];
+        re_row[1 + l + k] = -wa[i] * exp_k[1];
+        im_row[1 + k] = wb[i] * exp_k[1];
+        im_row[1 + l + k] = wb[i] * exp_k[0];
       }
     }
   }
 }
 
+void __batch_wigner_rotation_gemm(const int l, const unsigned int octant_orientations,
+                                  const unsigned int n_octants, const double *matrix,
+                                  const int n_systems, const complex128 *R_in,
+                                  double *components, double *R_out) {
+  unsigned int j;
+  int s, k, n1 = 2 * l + 1, ld = 2 * l + 2;
+  int rows = 2 * (l + 1) * octant_orientations;
+  double R_j[18];
+
+  for (j = 0; j < n_octants; j++) {
+    // Stack the alpha stepped components of the spin systems as columns.
+    for (s = 0; s < n_systems; s++) {
+      __step_alpha_phase(l, j % 4, (const double *)R_in[s * n1], R_j);
+      components[s] = R_j[2 * l];
+      components[n_systems + s] = R_j[2 * l + 1];
+      for (k = 1; k <= l; k++) {
+        components[(1 + k) * n_systems + s] = R_j[2 * (l - k)];
+        components[(1 + l + k) * n_systems + s] = R_j[2 * (l - k) + 1];
+      }
+    }
+
+    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, rows, n_systems, ld, 1.0,
+                &matrix[(j / 4) * rows * ld], ld, components, n_systems, 0.0,
+                &R_out[(size_t)j * rows * n_systems], n_systems);
+  }
+}
+
 /**
  * ✅ Calculates exp(-Im alpha), where alpha is an array of size n.
  * The function accepts cos_alpha = cos(alpha)
@@ -0,0 +1,182 @@
+// -*- coding: utf-8 -*-
+//
+//  czjzek.c
+//
+//  @copyright Deepansh J. Srivastava, 2019-2021.
+//  Created by Deepansh J. Srivastava, Oct 16, 2026.
+//  Contact email = srivastava.89@osu.edu
+//
+
+#include "czjzek.h"
+
+/* The xoshiro256+ generator, seeded with splitmix64. */
+typedef struct {
+  uint64_t s[4];
+} __rng_state;
+
+static inline uint64_t __rotl(const uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t __splitmix64(uint64_t *x) {
+  uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static inline void __rng_seed(__rng_state *rng, uint64_t seed) {
+  int i;
+  for (i = 0; i < 4; i++) rng->s[i] = __splitmix64(&seed);
+}
+
+/* A uniform random number in (0, 1]. */
+static inline double __rng_uniform(__rng_state *rng) {
+  uint64_t *s = rng->s;
+  const uint64_t result = s[0] + s[3];
+  const uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = __rotl(s[3], 45);
+  return ((result >> 11) + 1) * 0x1.0p-53;
+}
+
+/**
+ * Transform the pairs of uniform random numbers, (u[i], u[i + n]), into the pairs of
+ * independent standard normal random numbers with the Box-Muller transform.
+ */
+MRS_SIMD_CLONES
+static void __box_muller(const int n, double *restrict u) {
+  int i;
+  double r, theta;
+  for (i = 0; i < n; i++) {
+    r = sqrt(-2.0 * log(u[i]));
+    theta = CONST_2PI * u[i + n];
+    u[i] = r * cos(theta);
+    u[i + n] = r * sin(theta);
+  }
+}
+
+/**
+ * Evaluate the Haeberlen zeta and eta of a block of tensors from the five standard
+ * normal random numbers, g[k * n + i], of every tensor. The eigenvalues of the
+ * symmetric 3x3 tensor are evaluated with the trigonometric solution of the
+ * characteristic cubic equation. A zero tensor gives a zero zeta.
+ */
+MRS_SIMD_CLONES
+static void __block_haeberlen(const int n, const double *restrict g,
+                              const double *T0, const double scale,
+                              double *restrict zeta, double *restrict eta) {
+  int i;
+  const double s3 = sqrt(3.0) * scale;
+  double xx, yy, zz, xy, xz, yz, q, p, p1, p2, r, phi;
+  double e0, e1, e2, a0, a1, a2, t;
+  const double *g1 = g, *g2 = g + n, *g3 = g + 2 * n, *g4 = g + 3 * n, *g5 = g + 4 * n;
+
+  for (i = 0; i < n; i++) {
+    xx = T0[0] + s3 * g5[i] - scale * g1[i];
+    yy = T0[1] - s3 * g5[i] - scale * g1[i];
+    zz = T0[2] + 2.0 * scale * g1[i];
+    xy = s3 * g4[i];
+    xz = s3 * g2[i];
+    yz = s3 * g3[i];
+
+    // shift by the trace and scale to unit p, B = (A - qI) / p.
+    q = (xx + yy + zz) / 3.0;
+    xx -= q;
+    yy -= q;
+    zz -= q;
+    p1 = xy * xy + xz * xz + yz * yz;
+    p2 = xx * xx + yy * yy + zz * zz + 2.0 * p1;
+    p = sqrt(p2 / 6.0);
+
+    // r = det(B) / 2
+    r = xx * (yy * zz - yz * yz) - xy * (xy * zz - yz * xz) + xz * (xy * yz - yy * xz);
+    r = (p > 0.0) ? r / (2.0 * p * p * p) : 0.0;
+    r = (r < -1.0) ? -1.0 : ((r > 1.0) ? 1.0 : r);
+    phi = acos(r) / 3.0;
+
+    e0 = q + 2.0 * p * cos(phi);
+    e2 = q + 2.0 * p * cos(phi + CONST_2PI / 3.0);
+    e1 = 3.0 * q - e0 - e2;
+
+    // order the eigenvalues as |e0| <= |e1| <= |e2|.
+    a0 = fabs(e0);
+    a1 = fabs(e1);
+    a2 = fabs(e2);
+    if (a0 > a1) {
+      t = e0, e0 = e1, e1 = t;
+      t = a0, a0 = a1, a1 = t;
+    }
+    if (a1 > a2) {
+      t = e1, e1 = e2, e2 = t;
+      t = a1, a1 = a2, a2 = t;
+    }
+    if (a0 > a1) {
+      t = e0, e0 = e1, e1 = t;
+    }
+
+    zeta[i] = e2;
+    eta[i] = (e2 != 0.0) ? (e0 - e1) / e2 : 0.0;
+  }
+}
+
+/* Convert the Haeberlen zeta and eta of a block of tensors to the polar x and y. */
+static inline void __block_polar(const int n, double *restrict zeta,
+                                 double *restrict eta) {
+  int i;
+  double t, r;
+  for (i = 0; i < n; i++) {
+    t = tan(0.7853981634 * eta[i]);
+    r = fabs(zeta[i]) / sqrt(t * t + 1.0);
+    if (zeta[i] >= 0) {
+      zeta[i] = t * r;
+      eta[i] = r;
+    } else {
+      zeta[i] = r;
+      eta[i] = t * r;
+    }
+  }
+}
+
+/* The bin index of `value`, following numpy.histogram bin edges, or -1 if outside. */
+static inline int __bin_index(const double value, const unsigned int n,
+                              const double min, const double max) {
+  int index;
+  if (!(value >= min && value <= max)) return -1;
+  index = (int)((value - min) * n / (max - min));
+  return (index >= (int)n) ? (int)n - 1 : index;
+}
+
+void MRS_czjzek_histogram(double *restrict hist, const unsigned int n_x,
+                          const double x_min, const double x_max,
+                          const unsigned int n_y, const double y_min,
+                          const double y_max, const double *T0, const double scale,
+                          const unsigned long size, const bool polar,
+                          const uint64_t seed) {
+  // Six normal random numbers per tensor, from three Box-Muller pairs, of which five
+  // are used.
+  double g[6 * MRS_CZJZEK_BLOCK], zeta[MRS_CZJZEK_BLOCK], eta[MRS_CZJZEK_BLOCK];
+  unsigned long done;
+  int i, n, ix, iy;
+  __rng_state rng;
+
+  __rng_seed(&rng, seed);
+  for (done = 0; done < size; done += n) {
+    n = (size - done < MRS_CZJZEK_BLOCK) ? (int)(size - done) : MRS_CZJZEK_BLOCK;
+    for (i = 0; i < 6 * n; i++) g[i] = __rng_uniform(&rng);
+    __box_muller(3 * n, g);
+
+    __block_haeberlen(n, g, T0, scale, zeta, eta);
+    if (polar) __block_polar(n, zeta, eta);
+
+    for (i = 0; i < n; i++) {
+      ix = __bin_index(zeta[i], n_x, x_min, x_max);
+      iy = __bin_index(eta[i], n_y, y_min, y_max);
+      if (ix >= 0 && iy >= 0) hist[ix * n_y + iy] += 1.0;
+    }
+  }
+}
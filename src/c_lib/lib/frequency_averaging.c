@@ -9,6 +9,34 @@
 
 #include "frequency_averaging.h"
 
+// The largest number of octants of a powder averaging scheme.
+#define MAX_OCTANTS 8
+
+// Store the min and max of the n frequencies in range[0] and range[1].
+static inline void __frequency_range(int n, const double *freq, double *range) {
+  range[0] = range[1] = *freq;
+  while (--n > 0) {
+    freq++;
+    range[0] = (*freq < range[0]) ? *freq : range[0];
+    range[1] = (*freq > range[1]) ? *freq : range[1];
+  }
+}
+
+/**
+ * True if the frequencies within `range`, shifted by `offset`, do not write to any of
+ * the m bins. The frequencies are padded by MRS_INTERPOLATION_PAD bins, which covers
+ * the spread of the delta interpolation schemes.
+ */
+static inline bool __outside_grid(const double *range, double offset, int m) {
+  return range[1] + offset < -MRS_INTERPOLATION_PAD ||
+         range[0] + offset >= m + MRS_INTERPOLATION_PAD;
+}
+
+// The largest absolute value of the n amplitudes.
+static inline double __max_abs(int n, const double *amp) {
+  return fabs(amp[cblas_idamax(n, amp, 1)]);
+}
+
 // Multiply the amplitudes from each event to the amplitudes from the first event.
 // static inline void get_multi_event_amplitudes(int n_events, MRS_event *restrict
 // event,
@@ -21,13 +49,14 @@
 //   }
 // }
 
-void one_dimensional_averaging(MRS_dimension *dimensions, MRS_averaging_scheme *scheme,
-                               double *spec, double transition_pathway_weight,
+void one_dimensional_averaging(MRS_dimension *dimensions,
+                               MRS_orientation_tables *scheme, double *spec,
+                               double transition_pathway_weight,
                                unsigned int iso_intrp) {
   unsigned int i, j, k1, address, ptr, gamma_idx;
   unsigned int nt = scheme->integration_density, npts = scheme->octant_orientations;
 
-  double offset_0, offset;
+  double offset_0, offset, threshold = 0.0, range[2 * MAX_OCTANTS];
   double *freq, *amps = dimensions->freq_amplitude;
 
   bool delta_interpolation = false;
@@ -52,6 +81,11 @@ void one_dimensional_averaging(MRS_dimension *dimensions, MRS_averaging_scheme *
 
   cblas_dscal(planA->size, transition_pathway_weight, amps, 1);
 
+  // The octants with amplitudes below the threshold are skipped.
+  if (dimensions->amplitude_threshold > 0.0) {
+    threshold = dimensions->amplitude_threshold * __max_abs(planA->size, amps);
+  }
+
   offset_0 = dimensions->normalize_offset + dimensions->R0_offset;
 
   // gamma averaging
@@ -79,34 +113,43 @@ void one_dimensional_averaging(MRS_dimension *dimensions, MRS_averaging_scheme *
       return;
     }
 
+    // The frequency range of every octant, shared by all sideband orders.
+    for (j = 0; j < planA->n_octants; j++) {
+      __frequency_range(npts, &freq[j * npts], &range[2 * j]);
+    }
+
     for (i = 0; i < planA->number_of_sidebands; i++) {
       offset = offset_0 + planA->vr_freq[i];
       if ((int)offset >= 0 && (int)offset <= dimensions->count) {
         k1 = i * scheme->total_orientations;
         address = 0;
-        for (j = 0; j < planA->n_octants; j++) {
+        for (j = 0; j < planA->n_octants; j++, k1 += npts, address += npts) {
+          // Skip the octants outside the spectral window or below the threshold.
+          if (__outside_grid(&range[2 * j], offset, dimensions->count)) continue;
+          if (threshold > 0.0 && __max_abs(npts, &amps[k1]) <= threshold) continue;
+
           // Add offset(isotropic + sideband_order) to the local frequencies.
           vm_double_add_offset(npts, &freq[address], offset, dimensions->freq_offset);
           // Perform tenting on every sideband order over all orientations.
           octahedronInterpolation(spec, dimensions->freq_offset, nt, &amps[k1], 1,
                                   dimensions->count);
-          k1 += npts;
-          address += npts;
         }
       }
     }
   }
 }
 
-void two_dimensional_averaging(MRS_dimension *dimensions, MRS_averaging_scheme *scheme,
+void two_dimensional_averaging(MRS_dimension *dimensions,
+                               MRS_orientation_tables *scheme, MRS_workspace *workspace,
                                double *spec, double transition_pathway_weight,
                                double *affine_matrix, unsigned int iso_intrp) {
   unsigned int i, k, j, index, step_vector_i, step_vector_k, address, gamma_idx;
   unsigned int npts = scheme->octant_orientations, ptr;
 
   MRS_plan *planA, *planB, *avg_plan;
-  double *freq_ampA, *freq_ampB, *freq_amp = scheme->scrach, *avg_freq;
-  double offset0, offset1, offsetA, offsetB;
+  double *freq_ampA, *freq_ampB, *freq_amp = workspace->scrach, *avg_freq;
+  double offset0, offset1, offsetA, offsetB, threshold = 0.0;
+  double range0[2 * MAX_OCTANTS], range1[2 * MAX_OCTANTS];
   double *freq0, *freq1;
   double norm0, norm1;
 
@@ -129,6 +172,13 @@ void two_dimensional_averaging(MRS_dimension *dimensions, MRS_averaging_scheme *
   }
   cblas_dscal(planA->size, transition_pathway_weight, freq_ampA, 1);
 
+  // The octants with amplitudes below the threshold are skipped. The amplitudes are
+  // the products of the amplitudes along the two dimensions.
+  if (dimensions[0].amplitude_threshold > 0.0) {
+    threshold = dimensions[0].amplitude_threshold * __max_abs(planA->size, freq_ampA) *
+                __max_abs(planB->size, freq_ampB);
+  }
+
   // gamma averaging
   for (gamma_idx = 0; gamma_idx < scheme->n_gamma; gamma_idx++) {
     ptr = scheme->total_orientations * gamma_idx;
@@ -152,6 +202,12 @@ void two_dimensional_averaging(MRS_dimension *dimensions, MRS_averaging_scheme *
       cblas_daxpy(scheme->total_orientations, affine_matrix[2], freq0, 1, freq1, 1);
     }
 
+    // The frequency range of every octant, shared by all sideband orders.
+    for (j = 0; j < planA->n_octants; j++) {
+      __frequency_range(npts, &freq0[j * npts], &range0[2 * j]);
+      __frequency_range(npts, &freq1[j * npts], &range1[2 * j]);
+    }
+
     for (i = 0; i < planA->number_of_sidebands; i++) {
       offsetA = offset0 + planA->vr_freq[i];
       for (k = 0; k < planB->number_of_sidebands; k++) {
@@ -180,6 +236,17 @@ void two_dimensional_averaging(MRS_dimension *dimensions, MRS_averaging_scheme *
             // step_vector = 0;
             for (j = 0; j < planA->n_octants; j++) {
               address = j * npts;
+
+              // Skip the octants outside the spectral window or below the threshold.
+              if (__outside_grid(&range0[2 * j], norm0, dimensions[0].count) ||
+                  __outside_grid(&range1[2 * j], norm1, dimensions[1].count))
+                continue;
+              if (threshold > 0.0 &&
+                  __max_abs(npts, &freq_ampA[step_vector_i + address]) *
+                          __max_abs(npts, &freq_ampB[step_vector_k + address]) <=
+                      threshold)
+                continue;
+
               // Add offset(isotropic + sideband_order) to the local frequency
               // from [n to n+octant_orientation]
               vm_double_add_offset(npts, &freq0[address], norm0,
@@ -117,7 +117,7 @@ static inline void MRS_set_event(MRS_event *event, double fraction,
  * @brief Create a plan for every events within a dimension struct.
  *
  * @param dim A pointer to the MRS_dimension.
- * @param scheme A pointer to the powder averaging scheme MRS_averaging_scheme.
+ * @param scheme A pointer to the powder averaging scheme MRS_orientation_tables.
  * @param count (int) The number of points along the dimension.
  * @param increment (double) The increment in Hz along the dimension.
  * @param coordinates_offset (double) The coordinates offset in Hz along the dimension.
@@ -129,7 +129,7 @@ static inline void MRS_set_event(MRS_event *event, double fraction,
  * @param number_of_sidebands The total number of requested sidebands.
  */
 static inline void create_plans_for_events_in_dimension(
-    MRS_dimension *dim, MRS_averaging_scheme *scheme, int count, double increment,
+    MRS_dimension *dim, MRS_orientation_tables *scheme, int count, double increment,
     double coordinates_offset, int n_events, double *fraction,
     double *rotor_frequency_in_Hz, double *rotor_angle_in_rad,
     double *magnetic_flux_density_in_T, unsigned int number_of_sidebands) {
@@ -143,6 +143,7 @@ static inline void create_plans_for_events_in_dimension(
   dim->inverse_increment = 1.0 / increment;
   dim->normalize_offset = 0.5 - (coordinates_offset * dim->inverse_increment);
   dim->R0_offset = 0.0;
+  dim->amplitude_threshold = 0.0;
 
   MRS_plan *plan =
       MRS_create_plan(scheme, number_of_sidebands, *rotor_frequency_in_Hz,
@@ -177,7 +178,7 @@ static inline void create_plans_for_events_in_dimension(
  * dimension.
  **/
 MRS_dimension *MRS_create_dimensions(
-    MRS_averaging_scheme *scheme, int *count, double *coordinates_offset,
+    MRS_orientation_tables *scheme, int *count, double *coordinates_offset,
     double *increment, double *fractions, double *magnetic_flux_density_in_T,
     double *rotor_frequency_in_Hz, double *rotor_angle_in_rad, int *n_events,
     unsigned int n_dim, unsigned int *number_of_sidebands) {
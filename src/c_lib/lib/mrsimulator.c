@@ -81,7 +81,7 @@ void MRS_plan_release_temp_storage(MRS_plan *the_plan) {
  * 4) creating the fftw plan, 4) allocating buffer for storing the evaluated frequencies
  *    and their respective amplitudes.
  */
-MRS_plan *MRS_create_plan(MRS_averaging_scheme *scheme,
+MRS_plan *MRS_create_plan(MRS_orientation_tables *scheme,
                           unsigned int number_of_sidebands,
                           double rotor_frequency_in_Hz, double rotor_angle_in_rad,
                           double increment, bool allow_4th_rank) {
@@ -273,7 +273,8 @@ MRS_plan *MRS_copy_plan(MRS_plan *plan) {
  * 2) Evalute the sideband amplitudes using equation [39] of the reference
  *    https://doi.org/10.1006/jmre.1998.1427.
  */
-void MRS_get_amplitudes_from_plan(MRS_averaging_scheme *scheme, MRS_plan *plan,
+void MRS_get_amplitudes_from_plan(MRS_orientation_tables *scheme,
+                                  MRS_workspace *workspace, MRS_plan *plan,
                                   MRS_fftw_scheme *fftw_scheme, bool reset) {
   /* If the number of sidebands is 1, the sideband amplitude at every sideband order is
    * one. In this case, return null,
@@ -316,52 +317,58 @@ void MRS_get_amplitudes_from_plan(MRS_averaging_scheme *scheme, MRS_plan *plan,
    * name `vector`, which is interpreted as a row major matrix of shape
    * `number_of_sidebands` x `total_orientations` with `total_orientations` as the
    * leading dimension.
+   *
+   * Similarly, the exponent of the sideband phase w.r.t the fourth-rank tensor
+   * components is,
+   *
+   * w4(Θ) * d^4_{m, 0}(rotor_angle_in_rad) * 2πI[(exp(I m ωr t) - 1)/(I m ωr)]
+   * |-----lab frame 4th rank tensors-----|
+   *         |-------------------------- pre_phase_4--------------------------|
+   *
+   * * A given element of this product is given as the summation,
+   *
+   *           res[i, j] = \sum_{m=-4}^4 w4[i, m] * pre_phase_4[m, j],            (3)
+   *
+   * where the following symmetry holds,
+   *
+   *    w2[i, m] * pre_phase_2[m, j] = conj(w4[i, -m] * pre_phase_4[-m, j]).
+   *
+   * The above symmetry simplifies Eq (3) to
+   *
+   *         res[i, j] = \sum_{m=1}^4 2*imag(w4[i, m] * pre_phase_4[m, j]).       (4)
+   *
+   * From Eq(2), we find that evaluting half the calculations is sufficient. Since
+   * pre_phase_4[0, j] is zero, the m=0 term is dropped from Eq. (4). Notice the
+   * scaling factor 2 in Eq. (4). For computation efficiency, this factor is added to
+   * the `pre_phase_4` term in the one-time computation step.
+   *
+   * The sums in Eq. (2) and (4) have only two and four terms, respectively, which is
+   * too small an inner dimension for an efficient zgemm. Instead, the sums and the
+   * phase factor, exp(I res), are evaluated together by a kernel specialized for the
+   * two term counts. See MRS_get_sideband_phase_factors().
    */
-  cblas_zgemm(CblasRowMajor, CblasTrans, CblasTrans, plan->number_of_sidebands,
-              scheme->total_orientations, 2, ONE, (double *)(plan->pre_phase_2),
-              plan->number_of_sidebands, (double *)(scheme->w2), 3, ZERO,
-              (double *)(fftw_scheme->vector), scheme->total_orientations);
+  MRS_get_sideband_phase_factors(scheme->total_orientations, plan->number_of_sidebands,
+                                 workspace->w2, plan->pre_phase_2, workspace->w4,
+                                 plan->pre_phase_4, fftw_scheme->vector);
 
-  if (scheme->w4 != NULL) {
-    /**
-     * Similarly, evaluate the exponent of the sideband phase w.r.t the fourth-rank
-     * tensor components. The exponent is given as,
-     *
-     * w4(Θ) * d^4_{m, 0}(rotor_angle_in_rad) * 2πI[(exp(I m ωr t) - 1)/(I m ωr)]
-     * |-----lab frame 4th rank tensors-----|
-     *         |-------------------------- pre_phase_4--------------------------|
-     *
-     * * A given element of this product is given as the summation,
-     *
-     *           res[i, j] = \sum_{m=-4}^4 w4[i, m] * pre_phase_4[m, j],            (3)
-     *
-     * where the following symmetry holds,
-     *
-     *    w2[i, m] * pre_phase_2[m, j] = conj(w4[i, -m] * pre_phase_4[-m, j]).
-     *
-     * The above symmetry simplifies Eq (3) to
-     *
-     *         res[i, j] = \sum_{m=1}^4 2*imag(w4[i, m] * pre_phase_4[m, j]).       (4)
-     *
-     * From Eq(2), we find that evaluting half the calculations is sufficient. Since
-     * pre_phase_4[0, j] is zero, the m=0 term is dropped from Eq. (4). Notice the
-     * scaling factor 2 in Eq. (4). For computation efficiency, this factor is added to
-     * the `pre_phase_4` term in the one-time computation step.
-     *
-     * where `pre_phase_4` is pre-calculated and stored in the plan. This operation will
-     * add and update the values stored in the variable `vector`.
-     */
-    cblas_zgemm(CblasRowMajor, CblasTrans, CblasTrans, plan->number_of_sidebands,
-                scheme->total_orientations, 4, ONE, (double *)(plan->pre_phase_4),
-                plan->number_of_sidebands, (double *)(scheme->w4), 5, ONE,
-                (double *)(fftw_scheme->vector), scheme->total_orientations);
-  }
+  MRS_get_amplitudes_from_phases(plan, fftw_scheme);
+}
+
+/**
+ * Evaluate the sideband amplitudes from the sideband phase factors stored in
+ * `fftw_scheme->vector`.
+ */
+void MRS_get_amplitudes_from_phases(MRS_plan *plan, MRS_fftw_scheme *fftw_scheme) {
+  if (plan->number_of_sidebands == 1) return;
 
   /**
-   * Evaluate the sideband phase -> exp(vector). Since the real part of the complex data
-   * is zero, evaluate the exponential for only the imaginary part. The evaluated value
-   * is overwritten on the variable `vector`. */
-  vm_double_complex_exp_imag_only(plan->size, fftw_scheme->vector, fftw_scheme->vector);
+   * For a few sidebands, the direct DFT, vectorized over the orientations, is cheaper
+   * than the fftw plan execution followed by the absolute value square. */
+  if (plan->number_of_sidebands <= MRS_DIRECT_DFT_MAX_SIDEBANDS) {
+    MRS_get_sideband_amplitudes_direct(plan->size / plan->number_of_sidebands,
+                                       plan->number_of_sidebands, fftw_scheme->vector);
+    return;
+  }
 
   /**
    * Evaluate the Fourier transform of the variable, `vector`, -> fft(vector). The fft
@@ -385,21 +392,22 @@ void MRS_get_amplitudes_from_plan(MRS_averaging_scheme *scheme, MRS_plan *plan,
  * makes binning of frequencies on the spectrum faster as bins can then be of 1 unit
  * increments.
  */
-void MRS_get_normalized_frequencies_from_plan(MRS_averaging_scheme *scheme,
-                                              MRS_plan *plan, double R0, complex128 *R2,
-                                              complex128 *R4, bool reset,
-                                              MRS_dimension *dim, double fraction) {
+void MRS_get_normalized_frequencies_from_plan(MRS_orientation_tables *scheme,
+                                              MRS_workspace *workspace, MRS_plan *plan,
+                                              double R0, complex128 *R2, complex128 *R4,
+                                              bool reset, MRS_dimension *dim,
+                                              double fraction) {
   unsigned int i, gamma_idx, ptr;
   double temp;
   double *f_complex;
   /**
    * Rotate the R2 and R4 components from the common frame to the rotor frame over all
    * the orientations (alpha, beta). The componets are stored in w2 and w4 of the
-   * averaging scheme, respectively.
+   * workspace, respectively.
    */
   __batch_wigner_rotation(scheme->octant_orientations, plan->n_octants,
                           scheme->wigner_2j_matrices, R2, scheme->wigner_4j_matrices,
-                          R4, scheme->exp_Im_alpha, scheme->w2, scheme->w4);
+                          R4, scheme->exp_Im_alpha, workspace->w2, workspace->w4);
 
   /* If reset is true, zero the local_frequencies before update. */
   if (reset) {
@@ -428,15 +436,17 @@ void MRS_get_normalized_frequencies_from_plan(MRS_averaging_scheme *scheme,
             (double *)&(scheme->exp_Im_gamma[(2 + i) * scheme->n_gamma + gamma_idx]);
         plan->buffer = temp * plan->wigner_d2m0_vector[i] * f_complex[0];
         cblas_daxpy(scheme->total_orientations, plan->buffer,
-                    (double *)&(scheme->w2[i]), 6, &dim->local_frequency[ptr], 1);
+                    (double *)&(workspace->w2[i]), 6, &dim->local_frequency[ptr],
+                    1);
         plan->buffer = -temp * plan->wigner_d2m0_vector[i] * f_complex[1];
         cblas_daxpy(scheme->total_orientations, plan->buffer,
-                    (double *)&(scheme->w2[i]) + 1, 6, &dim->local_frequency[ptr], 1);
+                    (double *)&(workspace->w2[i]) + 1, 6,
+                    &dim->local_frequency[ptr], 1);
       }
     }
     plan->buffer = dim->inverse_increment * plan->wigner_d2m0_vector[2] * fraction;
-    cblas_daxpy(scheme->total_orientations, plan->buffer, (double *)&(scheme->w2[2]), 6,
-                &dim->local_frequency[ptr], 1);
+    cblas_daxpy(scheme->total_orientations, plan->buffer,
+                (double *)&(workspace->w2[2]), 6, &dim->local_frequency[ptr], 1);
   }
   if (plan->allow_4th_rank) {
     /**
@@ -452,19 +462,397 @@ void MRS_get_normalized_frequencies_from_plan(MRS_averaging_scheme *scheme,
               (double *)&(scheme->exp_Im_gamma[i * scheme->n_gamma + gamma_idx]);
           plan->buffer = temp * plan->wigner_d4m0_vector[i] * f_complex[0];
           cblas_daxpy(scheme->total_orientations, plan->buffer,
-                      (double *)&scheme->w4[i], 10, &dim->local_frequency[ptr], 1);
+                      (double *)&workspace->w4[i], 10, &dim->local_frequency[ptr], 1);
           plan->buffer = -temp * plan->wigner_d4m0_vector[i] * f_complex[1];
           cblas_daxpy(scheme->total_orientations, plan->buffer,
-                      (double *)&scheme->w4[i] + 1, 10, &dim->local_frequency[ptr], 1);
+                      (double *)&workspace->w4[i] + 1, 10,
+                      &dim->local_frequency[ptr], 1);
         }
       }
       plan->buffer = dim->inverse_increment * plan->wigner_d4m0_vector[4] * fraction;
-      cblas_daxpy(scheme->total_orientations, plan->buffer, (double *)&scheme->w4[4],
+      cblas_daxpy(scheme->total_orientations, plan->buffer, (double *)&workspace->w4[4],
                   10, &dim->local_frequency[ptr], 1);
     }
   }
 }
 
+/**
+ * Accumulate the frequency contributions, sum_k c_re[k] w_re[k] + c_im[k] w_im[k], of
+ * a block of rotated tensor components.
+ */
+MRS_SIMD_CLONES
+static void __block_frequencies(const int size, const int n_terms, const double *c_re,
+                                const double *c_im, const double **w_re,
+                                const double **w_im, double *restrict freq) {
+  int i, k;
+  const double *re, *im;
+  for (k = 0; k < n_terms; k++) {
+    re = w_re[k];
+    im = w_im[k];
+    for (i = 0; i < size; i++) freq[i] += c_re[k] * re[i] + c_im[k] * im[i];
+  }
+}
+
+/* Evaluate a row of the sideband phase exponent, Im(sum_k w[k, i] * phase[k]). */
+static inline void __sideband_phase_row(const int size, const int n_terms,
+                                        const double *p_re, const double *p_im,
+                                        const double **w_re, const double **w_im,
+                                        double *restrict res) {
+  int i, k;
+  double acc;
+  for (i = 0; i < size; i++) {
+    acc = 0.0;
+    for (k = 0; k < n_terms; k++) acc += p_re[k] * w_im[k][i] + p_im[k] * w_re[k][i];
+    res[i] = acc;
+  }
+}
+
+/**
+ * Evaluate the sideband phase factors of a block of rotated tensor components for
+ * every sideband,
+ *    vector[s, i] = exp(I Im(sum_k w[k, i] * phase[k, s])),
+ * with `ld` as the leading dimension of the complex `vector` array. The number of
+ * terms is either 2, for the second-rank, or 6, for the second and fourth-rank tensors.
+ */
+MRS_SIMD_CLONES
+static void __block_sideband_phase_factors(const int size, const int n_terms,
+                                           const int n_sidebands, const double **phase,
+                                           const double **w_re, const double **w_im,
+                                           complex128 *vector, const int ld) {
+  int k, s;
+  double p_re[6], p_im[6], res[MRS_WIGNER_BLOCK];
+
+  for (s = 0; s < n_sidebands; s++) {
+    for (k = 0; k < n_terms; k++) {
+      p_re[k] = phase[k][2 * s];
+      p_im[k] = phase[k][2 * s + 1];
+    }
+    // Constant term counts let the compiler unroll the sum over the terms.
+    if (n_terms == 2) {
+      __sideband_phase_row(size, 2, p_re, p_im, w_re, w_im, res);
+    } else {
+      __sideband_phase_row(size, 6, p_re, p_im, w_re, w_im, res);
+    }
+    vm_double_complex_exp_I(size, res, &vector[s * ld]);
+  }
+}
+
+/* Evaluate the sideband phase factors from the rotor-frame components. */
+void MRS_get_sideband_phase_factors(unsigned int n_orientations,
+                                    unsigned int n_sidebands, const complex128 *w2,
+                                    const complex128 *pre_phase_2,
+                                    const complex128 *w4,
+                                    const complex128 *pre_phase_4, void *vector) {
+  unsigned int start, size, i;
+  int k, n_terms = (w4 != NULL) ? 6 : 2;
+  double w_re[6 * MRS_WIGNER_BLOCK], w_im[6 * MRS_WIGNER_BLOCK];
+  const double *re[6], *im[6], *phase[6];
+  const double *w2_ = (const double *)w2, *w4_ = (const double *)w4;
+
+  for (k = 0; k < 6; k++) {
+    re[k] = &w_re[k * MRS_WIGNER_BLOCK];
+    im[k] = &w_im[k * MRS_WIGNER_BLOCK];
+  }
+  for (k = 0; k < 2; k++) phase[k] = (const double *)&pre_phase_2[k * n_sidebands];
+  for (k = 0; k < 4 && w4 != NULL; k++) {
+    phase[2 + k] = (const double *)&pre_phase_4[k * n_sidebands];
+  }
+
+  for (start = 0; start < n_orientations; start += MRS_WIGNER_BLOCK) {
+    size = (n_orientations - start < MRS_WIGNER_BLOCK) ? n_orientations - start
+                                                         : MRS_WIGNER_BLOCK;
+    // Split the m = [-2, -1] and m = [-4, ..., -1] components of the block.
+    for (i = 0; i < size; i++) {
+      for (k = 0; k < 2; k++) {
+        w_re[k * MRS_WIGNER_BLOCK + i] = w2_[2 * (3 * (start + i) + k)];
+        w_im[k * MRS_WIGNER_BLOCK + i] = w2_[2 * (3 * (start + i) + k) + 1];
+      }
+      for (k = 0; k < 4 && w4 != NULL; k++) {
+        w_re[(2 + k) * MRS_WIGNER_BLOCK + i] = w4_[2 * (5 * (start + i) + k)];
+        w_im[(2 + k) * MRS_WIGNER_BLOCK + i] = w4_[2 * (5 * (start + i) + k) + 1];
+      }
+    }
+    __block_sideband_phase_factors(size, n_terms, n_sidebands, phase, re, im,
+                                   &((complex128 *)vector)[start], n_orientations);
+  }
+}
+
+/* The number of orientations per pass of the direct DFT kernel. */
+#define MRS_DFT_BLOCK 64
+
+/**
+ * Evaluate the power spectrum of a block of sideband phase factors using the direct
+ * DFT,
+ *    vector[k, i] = |sum_s vector[s, i] exp(-2πI s k / n_sidebands)|^2,
+ * where the power is written to the real part and the imaginary part is set to zero.
+ * The k and n_sidebands - k outputs share the products of the cosine and sine tables,
+ * `cos_t` and `sin_t`, which are ordered as [k][s] for k = [0, n_sidebands / 2].
+ */
+MRS_SIMD_CLONES
+static void __block_sideband_power(const int size, const int n_sidebands,
+                                   const double *cos_t, const double *sin_t,
+                                   complex128 *vector, const int ld) {
+  int i, k, s;
+  double in_re[MRS_DIRECT_DFT_MAX_SIDEBANDS * MRS_DFT_BLOCK];
+  double in_im[MRS_DIRECT_DFT_MAX_SIDEBANDS * MRS_DFT_BLOCK];
+  double a_re[MRS_DFT_BLOCK], a_im[MRS_DFT_BLOCK], b_re[MRS_DFT_BLOCK],
+      b_im[MRS_DFT_BLOCK];
+  double c, sn, *v;
+
+  for (s = 0; s < n_sidebands; s++) {
+    v = (double *)&vector[s * ld];
+    for (i = 0; i < size; i++) {
+      in_re[s * MRS_DFT_BLOCK + i] = v[2 * i];
+      in_im[s * MRS_DFT_BLOCK + i] = v[2 * i + 1];
+    }
+  }
+
+  for (k = 0; 2 * k <= n_sidebands; k++) {
+    for (i = 0; i < size; i++) a_re[i] = a_im[i] = b_re[i] = b_im[i] = 0.0;
+    for (s = 0; s < n_sidebands; s++) {
+      c = cos_t[k * n_sidebands + s];
+      sn = sin_t[k * n_sidebands + s];
+      for (i = 0; i < size; i++) {
+        a_re[i] += c * in_re[s * MRS_DFT_BLOCK + i];
+        a_im[i] += c * in_im[s * MRS_DFT_BLOCK + i];
+        b_re[i] += sn * in_re[s * MRS_DFT_BLOCK + i];
+        b_im[i] += sn * in_im[s * MRS_DFT_BLOCK + i];
+      }
+    }
+    // X[k] = A - IB and X[n_sidebands - k] = A + IB.
+    v = (double *)&vector[k * ld];
+    for (i = 0; i < size; i++) {
+      c = a_re[i] + b_im[i];
+      sn = a_im[i] - b_re[i];
+      v[2 * i] = c * c + sn * sn;
+      v[2 * i + 1] = 0.0;
+    }
+    if (k == 0 || 2 * k == n_sidebands) continue;
+    v = (double *)&vector[(n_sidebands - k) * ld];
+    for (i = 0; i < size; i++) {
+      c = a_re[i] - b_im[i];
+      sn = a_im[i] + b_re[i];
+      v[2 * i] = c * c + sn * sn;
+      v[2 * i + 1] = 0.0;
+    }
+  }
+}
+
+/* Evaluate the sideband power spectrum with the direct DFT. */
+void MRS_get_sideband_amplitudes_direct(unsigned int n_orientations,
+                                        unsigned int n_sidebands, void *vector) {
+  unsigned int start, size;
+  int k, s;
+  double angle;
+  double cos_t[(MRS_DIRECT_DFT_MAX_SIDEBANDS / 2 + 1) * MRS_DIRECT_DFT_MAX_SIDEBANDS];
+  double sin_t[(MRS_DIRECT_DFT_MAX_SIDEBANDS / 2 + 1) * MRS_DIRECT_DFT_MAX_SIDEBANDS];
+
+  if (n_sidebands > MRS_DIRECT_DFT_MAX_SIDEBANDS) return;
+
+  // The twiddle factors, exp(-2πI s k / n_sidebands) = cos_t - I sin_t.
+  for (k = 0; 2 * k <= (int)n_sidebands; k++) {
+    for (s = 0; s < (int)n_sidebands; s++) {
+      angle = CONST_2PI * ((s * k) % n_sidebands) / n_sidebands;
+      cos_t[k * n_sidebands + s] = cos(angle);
+      sin_t[k * n_sidebands + s] = sin(angle);
+    }
+  }
+
+  for (start = 0; start < n_orientations; start += MRS_DFT_BLOCK) {
+    size = (n_orientations - start < MRS_DFT_BLOCK) ? n_orientations - start
+                                                      : MRS_DFT_BLOCK;
+    __block_sideband_power(size, n_sidebands, cos_t, sin_t,
+                           &((complex128 *)vector)[start], n_orientations);
+  }
+}
+
+/**
+ * Set the frequency coefficients of the rotor-frame components of rank l at the given
+ * gamma angle. The coefficients are ordered as m = [-l, ..., -1, 0].
+ */
+static inline void __frequency_coefficients(MRS_orientation_tables *scheme,
+                                            MRS_plan *plan, MRS_dimension *dim,
+                                            const int l, unsigned int gamma_idx,
+                                            double fraction, double *c_re,
+                                            double *c_im) {
+  int i;
+  double temp = dim->inverse_increment * 2 * fraction, *f_complex;
+  double *wigner_dm0 = (l == 2) ? plan->wigner_d2m0_vector : plan->wigner_d4m0_vector;
+
+  for (i = 0; i < l; i++) {
+    c_re[i] = 0.0;
+    c_im[i] = 0.0;
+    if (plan->is_static) {
+      // exp_Im_gamma is ordered as m=[-4,-3,-2,-1].
+      f_complex =
+          (double *)&(scheme->exp_Im_gamma[(4 - l + i) * scheme->n_gamma + gamma_idx]);
+      c_re[i] = temp * wigner_dm0[i] * f_complex[0];
+      c_im[i] = -temp * wigner_dm0[i] * f_complex[1];
+    }
+  }
+  c_re[l] = dim->inverse_increment * wigner_dm0[l] * fraction;
+  c_im[l] = 0.0;
+}
+
+/**
+ * Combine the rotated spatial tensor terms of rank l over a block of orientations,
+ *    w[k, i] = sum_t coef[t] basis[t, k, offset + i],
+ * where k runs over the real parts of m = [-l, ..., 0], followed by the imaginary
+ * parts. The block is written in the layout of __wigner_rotation_soa_block().
+ */
+MRS_SIMD_CLONES
+static void __block_spatial_basis(const int size, const int l, const int n_terms,
+                                  const double *coef, const double *basis,
+                                  const unsigned int total, const unsigned int offset,
+                                  double *restrict w_re, double *restrict w_im) {
+  int i, k, t, n_comp = 2 * (l + 1);
+  double c, *out;
+  const double *src;
+
+  for (k = 0; k < n_comp; k++) {
+    out = (k <= l) ? &w_re[k * MRS_WIGNER_BLOCK] : &w_im[(k - l - 1) * MRS_WIGNER_BLOCK];
+    for (i = 0; i < size; i++) out[i] = 0.0;
+    for (t = 0; t < n_terms; t++) {
+      c = coef[t];
+      if (c == 0.0) continue;
+      src = &basis[((size_t)t * n_comp + k) * total + offset];
+      for (i = 0; i < size; i++) out[i] += c * src[i];
+    }
+  }
+}
+
+/**
+ * Fused evaluation of the normalized frequencies and the sideband phase factors. The
+ * rotated tensor components of a block of orientations are either evaluated from the
+ * R2 and R4 components, when `basis` is NULL, or combined from the rotated spatial
+ * tensor terms with the coefficients c2 and c4. The lab-frame frequencies and phase
+ * factors are evaluated from the block while in cache.
+ */
+static void __normalized_frequencies_and_phases(
+    MRS_orientation_tables *scheme, MRS_plan *plan, MRS_fftw_scheme *fftw_scheme,
+    double R0, complex128 *R2, complex128 *R4, MRS_spatial_basis *basis,
+    const double *c2, const double *c4, bool reset, MRS_dimension *dim,
+    double fraction) {
+  unsigned int j, half, gamma_idx, start, size, offset;
+  unsigned int n = scheme->octant_orientations, total = scheme->total_orientations;
+  unsigned int n_sidebands = plan->number_of_sidebands;
+  int k, n_terms = 3, n_phase_terms = 2;
+  bool rank_4 = plan->allow_4th_rank && scheme->wigner_4j_matrices != NULL;
+  complex128 R2_j[5], R4_j[9];
+
+  if (basis != NULL) rank_4 = rank_4 && basis->n_terms_4 > 0;
+
+  // Rotated components of the block, m = [-2, -1, 0] followed by m = [-4, ..., 0].
+  double w_re[8 * MRS_WIGNER_BLOCK], w_im[8 * MRS_WIGNER_BLOCK];
+  const double *re[8], *im[8], *phase[6], *phase_re[6], *phase_im[6];
+  double c_re[8], c_im[8];
+
+  if (reset) {
+    vm_double_zeros(scheme->n_gamma * total, dim->local_frequency);
+    dim->R0_offset = 0.0;
+  }
+  dim->R0_offset += R0 * dim->inverse_increment * fraction;
+
+  /**
+   * The sideband phase exponent is the sum over m = [-2, -1] of the w2 and pre_phase_2
+   * product, and over m = [-4, ..., -1] of the w4 and pre_phase_4 product. See
+   * MRS_get_amplitudes_from_plan() for details.
+   */
+  for (k = 0; k < 8; k++) {
+    re[k] = &w_re[k * MRS_WIGNER_BLOCK];
+    im[k] = &w_im[k * MRS_WIGNER_BLOCK];
+  }
+  for (k = 0; k < 2; k++) {
+    phase[k] = (double *)&plan->pre_phase_2[k * n_sidebands];
+    phase_re[k] = re[k];
+    phase_im[k] = im[k];
+  }
+  if (rank_4) {
+    for (k = 0; k < 4; k++) {
+      phase[2 + k] = (double *)&plan->pre_phase_4[k * n_sidebands];
+      phase_re[2 + k] = re[3 + k];
+      phase_im[2 + k] = im[3 + k];
+    }
+    n_terms = 8;
+    n_phase_terms = 6;
+  }
+
+  /**
+   * Octants are ordered as the four octants from the upper hemisphere, followed by the
+   * four octants from the lower hemisphere. The orientations of the j^th octant differ
+   * from the first octant of the same hemisphere by alpha += jπ/2.
+   */
+  for (j = 0; j < plan->n_octants; j++) {
+    half = j / 4;
+    if (basis == NULL) {
+      __step_alpha_phase(2, j % 4, (double *)R2, (double *)R2_j);
+      if (rank_4) __step_alpha_phase(4, j % 4, (double *)R4, (double *)R4_j);
+    }
+
+    for (start = 0; start < n; start += MRS_WIGNER_BLOCK) {
+      size = (n - start < MRS_WIGNER_BLOCK) ? n - start : MRS_WIGNER_BLOCK;
+      offset = j * n + start;
+
+      if (basis != NULL) {
+        __block_spatial_basis(size, 2, basis->n_terms_2, c2, basis->w2, total, offset,
+                              w_re, w_im);
+        if (rank_4) {
+          __block_spatial_basis(size, 4, basis->n_terms_4, c4, basis->w4, total,
+                                offset, &w_re[3 * MRS_WIGNER_BLOCK],
+                                &w_im[3 * MRS_WIGNER_BLOCK]);
+        }
+      } else {
+        __wigner_rotation_soa_block(2, n, start, size,
+                                    &scheme->wigner_2j_matrices[half * 15 * n],
+                                    scheme->exp_Im_alpha, R2_j, w_re, w_im);
+        if (rank_4) {
+          __wigner_rotation_soa_block(4, n, start, size,
+                                      &scheme->wigner_4j_matrices[half * 45 * n],
+                                      scheme->exp_Im_alpha, R4_j,
+                                      &w_re[3 * MRS_WIGNER_BLOCK],
+                                      &w_im[3 * MRS_WIGNER_BLOCK]);
+        }
+      }
+
+      /* Normalized local anisotropic frequency contributions. */
+      for (gamma_idx = 0; gamma_idx < scheme->n_gamma; gamma_idx++) {
+        __frequency_coefficients(scheme, plan, dim, 2, gamma_idx, fraction, c_re,
+                                 c_im);
+        if (rank_4) {
+          __frequency_coefficients(scheme, plan, dim, 4, gamma_idx, fraction,
+                                   &c_re[3], &c_im[3]);
+        }
+        __block_frequencies(size, n_terms, c_re, c_im, re, im,
+                            &dim->local_frequency[gamma_idx * total + offset]);
+      }
+
+      /* Sideband phase factors. */
+      if (n_sidebands != 1) {
+        __block_sideband_phase_factors(size, n_phase_terms, n_sidebands, phase,
+                                       phase_re, phase_im,
+                                       (complex128 *)&fftw_scheme->vector[offset],
+                                       total);
+      }
+    }
+  }
+}
+
+void MRS_get_normalized_frequencies_and_phases_from_plan(
+    MRS_orientation_tables *scheme, MRS_plan *plan, MRS_fftw_scheme *fftw_scheme,
+    double R0, complex128 *R2, complex128 *R4, bool reset, MRS_dimension *dim,
+    double fraction) {
+  __normalized_frequencies_and_phases(scheme, plan, fftw_scheme, R0, R2, R4, NULL,
+                                      NULL, NULL, reset, dim, fraction);
+}
+
+void MRS_get_normalized_frequencies_and_phases_from_basis(
+    MRS_orientation_tables *scheme, MRS_plan *plan, MRS_fftw_scheme *fftw_scheme,
+    MRS_spatial_basis *basis, double R0, const double *c2, const double *c4,
+    bool reset, MRS_dimension *dim, double fraction) {
+  __normalized_frequencies_and_phases(scheme, plan, fftw_scheme, R0, NULL, NULL, basis,
+                                      c2, c4, reset, dim, fraction);
+}
+
 static inline void MRS_rotate_single_site_interaction_components(
     site_struct *sites,   // Pointer to a list of sites within a spin system.
     float *transition,    // The spin transition.
@@ -623,6 +1011,162 @@ void MRS_rotate_components_from_PAS_to_common_frame(
                                                  R0_temp, R2_temp, freq_contrib);
 }
 
+/* Rotate a spatial tensor term of rank l over all orientations of the tables. */
+static void __rotate_spatial_term(MRS_orientation_tables *scheme, const int l,
+                                  complex128 *R, double *out) {
+  unsigned int j, half, start, size, offset, n = scheme->octant_orientations;
+  unsigned int total = scheme->total_orientations, n_octants = total / n;
+  unsigned int half_size = (l + 1) * (2 * l + 1) * n;
+  int k;
+  double *wigner = (l == 2) ? scheme->wigner_2j_matrices : scheme->wigner_4j_matrices;
+  double w_re[5 * MRS_WIGNER_BLOCK], w_im[5 * MRS_WIGNER_BLOCK];
+  complex128 R_j[9];
+
+  for (j = 0; j < n_octants; j++) {
+    half = j / 4;
+    __step_alpha_phase(l, j % 4, (double *)R, (double *)R_j);
+    for (start = 0; start < n; start += MRS_WIGNER_BLOCK) {
+      size = (n - start < MRS_WIGNER_BLOCK) ? n - start : MRS_WIGNER_BLOCK;
+      offset = j * n + start;
+      __wigner_rotation_soa_block(l, n, start, size, &wigner[half * half_size],
+                                  scheme->exp_Im_alpha, R_j, w_re, w_im);
+      for (k = 0; k <= l; k++) {
+        cblas_dcopy(size, &w_re[k * MRS_WIGNER_BLOCK], 1, &out[k * total + offset], 1);
+        cblas_dcopy(size, &w_im[k * MRS_WIGNER_BLOCK], 1,
+                    &out[(l + 1 + k) * total + offset], 1);
+      }
+    }
+  }
+}
+
+unsigned int MRS_count_spatial_basis_terms(site_struct *sites,
+                                           coupling_struct *couplings,
+                                           bool allow_4th_rank,
+                                           unsigned int *n_terms_4) {
+  unsigned int i, n_terms_2 = 0;
+  *n_terms_4 = 0;
+  for (i = 0; i < sites->number_of_sites; i++) {
+    n_terms_2++;  // shielding
+    if (sites->spin[i] == 0.5) continue;
+    n_terms_2++;  // first-order quadrupolar
+    if (allow_4th_rank) {
+      n_terms_2++;  // second-order quadrupolar
+      (*n_terms_4)++;
+    }
+  }
+  return n_terms_2 + 2 * couplings->number_of_couplings;  // J and dipolar
+}
+
+/**
+ * The spatial tensor terms are ordered as the shielding, first-order quadrupolar, and
+ * second-order quadrupolar terms of every site, followed by the J and dipolar terms of
+ * every coupling. The shielding and second-order quadrupolar terms are evaluated at a
+ * Larmor frequency of 1 MHz, and scale linearly and inversely with the Larmor
+ * frequency, respectively. See MRS_get_spatial_basis_coefficients().
+ */
+void MRS_set_spatial_basis(MRS_orientation_tables *scheme, MRS_spatial_basis *basis,
+                           site_struct *sites, coupling_struct *couplings,
+                           bool allow_4th_rank) {
+  unsigned int i, t2 = 0, t4 = 0, total = scheme->total_orientations;
+  double R0;
+  complex128 R2[5], R4[9];
+
+  basis->allow_4th_rank = allow_4th_rank && basis->w4 != NULL;
+
+  for (i = 0; i < sites->number_of_sites; i++) {
+    sSOT_1st_order_nuclear_shielding_tensor_components(
+        &basis->r0[t2], R2, sites->isotropic_chemical_shift_in_ppm[i],
+        sites->shielding_symmetric_zeta_in_ppm[i], sites->shielding_symmetric_eta[i],
+        &sites->shielding_orientation[3 * i]);
+    __rotate_spatial_term(scheme, 2, R2, &basis->w2[(size_t)t2++ * 6 * total]);
+
+    if (sites->spin[i] == 0.5) continue;
+
+    sSOT_1st_order_electric_quadrupole_tensor_components(
+        R2, sites->spin[i], sites->quadrupolar_Cq_in_Hz[i], sites->quadrupolar_eta[i],
+        &sites->quadrupolar_orientation[3 * i]);
+    basis->r0[t2] = 0.0;
+    __rotate_spatial_term(scheme, 2, R2, &basis->w2[(size_t)t2++ * 6 * total]);
+
+    if (!basis->allow_4th_rank) continue;
+
+    sSOT_2nd_order_electric_quadrupole_tensor_components(
+        &R0, R2, R4, sites->spin[i], 1.0e6, sites->quadrupolar_Cq_in_Hz[i],
+        sites->quadrupolar_eta[i], &sites->quadrupolar_orientation[3 * i]);
+    basis->r0[t2] = R0;
+    __rotate_spatial_term(scheme, 2, R2, &basis->w2[(size_t)t2++ * 6 * total]);
+    __rotate_spatial_term(scheme, 4, R4, &basis->w4[(size_t)t4++ * 10 * total]);
+  }
+
+  for (i = 0; i < couplings->number_of_couplings; i++) {
+    sSOT_1st_order_weakly_coupled_J_tensor_components(
+        &basis->r0[t2], R2, couplings->isotropic_j_in_Hz[i],
+        couplings->j_symmetric_zeta_in_Hz[i], couplings->j_symmetric_eta[i],
+        &couplings->j_orientation[3 * i]);
+    __rotate_spatial_term(scheme, 2, R2, &basis->w2[(size_t)t2++ * 6 * total]);
+
+    sSOT_1st_order_weakly_coupled_dipolar_tensor_components(
+        R2, couplings->dipolar_coupling_in_Hz[i], &couplings->dipolar_orientation[3 * i]);
+    basis->r0[t2] = 0.0;
+    __rotate_spatial_term(scheme, 2, R2, &basis->w2[(size_t)t2++ * 6 * total]);
+  }
+  basis->n_terms_2 = t2;
+  basis->n_terms_4 = t4;
+}
+
+/**
+ * The coefficients follow MRS_rotate_components_from_PAS_to_common_frame(), with the
+ * spin transition functions, the Larmor frequency scaling, and the freq_contrib flags
+ * of the event in place of the spatial tensors.
+ */
+void MRS_get_spatial_basis_coefficients(site_struct *sites, coupling_struct *couplings,
+                                        MRS_spatial_basis *basis, float *transition,
+                                        double B0_in_T, bool *freq_contrib, double *R0,
+                                        double *c2, double *c4) {
+  unsigned int i, t2 = 0, t4 = 0, n_sites = sites->number_of_sites;
+  int site_index_A, site_index_X;
+  double larmor_freq_in_MHz, stf, cl_value[3];
+  float mi, mf;
+
+  *R0 = 0.0;
+  for (i = 0; i < n_sites; i++) {
+    mi = transition[i];
+    mf = transition[n_sites + i];
+    larmor_freq_in_MHz = -B0_in_T * sites->gyromagnetic_ratio[i];
+
+    stf = (mi == mf) ? 0.0 : STF_p(mf, mi) * larmor_freq_in_MHz;
+    if (freq_contrib[0]) *R0 += stf * basis->r0[t2];
+    c2[t2++] = (freq_contrib[1]) ? stf : 0.0;
+
+    if (sites->spin[i] == 0.5) continue;
+
+    stf = (mi == mf) ? 0.0 : STF_d(mf, mi);
+    c2[t2++] = (freq_contrib[2]) ? stf : 0.0;
+
+    if (!basis->allow_4th_rank) continue;
+
+    if (mi == mf) {
+      cl_value[0] = cl_value[1] = cl_value[2] = 0.0;
+    } else {
+      STF_cL(cl_value, mf, mi, sites->spin[i]);
+    }
+    if (freq_contrib[3]) *R0 += cl_value[0] / larmor_freq_in_MHz * basis->r0[t2];
+    c2[t2++] = (freq_contrib[4]) ? cl_value[1] / larmor_freq_in_MHz : 0.0;
+    c4[t4++] = (freq_contrib[5]) ? cl_value[2] / larmor_freq_in_MHz : 0.0;
+  }
+
+  for (i = 0; i < couplings->number_of_couplings; i++) {
+    site_index_A = couplings->site_index[2 * i];
+    site_index_X = couplings->site_index[2 * i + 1];
+    stf = STF_dIS(transition[site_index_A + n_sites], transition[site_index_A],
+                  transition[site_index_X + n_sites], transition[site_index_X]);
+
+    if (freq_contrib[6]) *R0 += stf * basis->r0[t2];
+    c2[t2++] = (freq_contrib[7]) ? stf : 0.0;
+    c2[t2++] = (freq_contrib[8]) ? stf : 0.0;
+  }
+}
+
 /**
  * The function calculates the following.
  *
@@ -9,7 +9,18 @@
 
 #include "schemes.h"
 
-static inline void averaging_scheme_setup(MRS_averaging_scheme *scheme,
+/* Evaluate the half wigner-d matrices of rank l at n orientations and store them in the
+ * symmetric structure-of-arrays layout used by __wigner_rotation_soa. */
+static inline void symmetric_wigner_d_matrices(const int l, const int n,
+                                               complex128 *exp_I_beta,
+                                               double *wigner_soa) {
+  double *wigner = malloc_double((l + 1) * (2 * l + 1) * n);
+  wigner_d_matrices_from_exp_I_beta(l, n, true, exp_I_beta, wigner);
+  wigner_d_matrices_to_symmetric_soa(l, n, wigner, wigner_soa);
+  free(wigner);
+}
+
+static inline void averaging_scheme_setup(MRS_orientation_tables *scheme,
                                           complex128 *exp_I_beta, bool allow_4th_rank) {
   unsigned int allocate_size_2, allocate_size_4;
 
@@ -43,8 +54,8 @@ static inline void averaging_scheme_setup(MRS_averaging_scheme *scheme,
    */
 
   // calculating the required space for storing wigner matrices.
-  allocate_size_2 = 15 * scheme->octant_orientations;  // (5 x 3) half-matrix
-  allocate_size_4 = 45 * scheme->octant_orientations;  // (9 x 5) half-matrix
+  allocate_size_2 = 15 * scheme->octant_orientations;  // (3 x 5) symmetric half-matrix
+  allocate_size_4 = 45 * scheme->octant_orientations;  // (5 x 9) symmetric half-matrix
   if (scheme->integration_volume == 2) {
     allocate_size_2 *= 2;
     allocate_size_4 *= 2;
@@ -53,16 +64,16 @@ static inline void averaging_scheme_setup(MRS_averaging_scheme *scheme,
   /* Second-rank reduced wigner matrices at every β orientation from the positive upper
    * octant. */
   scheme->wigner_2j_matrices = malloc_double(allocate_size_2);
-  wigner_d_matrices_from_exp_I_beta(2, scheme->octant_orientations, true, exp_I_beta,
-                                    scheme->wigner_2j_matrices);
+  symmetric_wigner_d_matrices(2, scheme->octant_orientations, exp_I_beta,
+                              scheme->wigner_2j_matrices);
 
   scheme->wigner_4j_matrices = NULL;
   if (allow_4th_rank) {
     /* Fourt-rank reduced wigner matrices at every β orientation from the positive upper
      * octant. */
     scheme->wigner_4j_matrices = malloc_double(allocate_size_4);
-    wigner_d_matrices_from_exp_I_beta(4, scheme->octant_orientations, true, exp_I_beta,
-                                      scheme->wigner_4j_matrices);
+    symmetric_wigner_d_matrices(4, scheme->octant_orientations, exp_I_beta,
+                                scheme->wigner_4j_matrices);
   }
 
   /**
@@ -87,52 +98,84 @@ static inline void averaging_scheme_setup(MRS_averaging_scheme *scheme,
 
     /* Second-rank reduced wigner matrices at every β orientation over an octant from
      * the lower hemisphere */
-    wigner_d_matrices_from_exp_I_beta(2, scheme->octant_orientations, true, exp_I_beta,
-                                      &scheme->wigner_2j_matrices[allocate_size_2]);
+    symmetric_wigner_d_matrices(2, scheme->octant_orientations, exp_I_beta,
+                                &scheme->wigner_2j_matrices[allocate_size_2]);
     if (allow_4th_rank) {
       /* Fourth-rank reduced wigner matrices at every β orientation. */
-      wigner_d_matrices_from_exp_I_beta(4, scheme->octant_orientations, true,
-                                        exp_I_beta,
-                                        &scheme->wigner_4j_matrices[allocate_size_4]);
+      symmetric_wigner_d_matrices(4, scheme->octant_orientations, exp_I_beta,
+                                  &scheme->wigner_4j_matrices[allocate_size_4]);
     }
   }
   /* -------------------------------------------------------------------------------- */
-
-  /* Setting up buffers and tables for processing the second rank tensors. . */
-  /* ................................................................................ */
-  /* w2 is the buffer for storing the frequencies calculated from the second-rank
-   * tensors. Only calcuate the -2, -1, and 0 tensor components.*/
-  scheme->w2 = malloc_complex128(3 * scheme->total_orientations);
-
-  scheme->w4 = NULL;
-  if (allow_4th_rank) {
-    /* w4 is the buffer for storing the frequencies calculated from the fourth-rank
-     * tensors. Only calcuate the -4, -3, -2, -1, and 0 tensor components.*/
-    scheme->w4 = malloc_complex128(5 * scheme->total_orientations);
-  }
 }
 
 /* Free the memory from the mrsimulator plan associated with the spherical averaging
  * scheme */
-void MRS_free_averaging_scheme(MRS_averaging_scheme *scheme) {
+void MRS_free_orientation_tables(MRS_orientation_tables *scheme) {
   free(scheme->amplitudes);
   free(scheme->exp_Im_alpha);
   free(scheme->exp_Im_gamma);
-  free(scheme->w2);
-  free(scheme->w4);
   free(scheme->wigner_2j_matrices);
   free(scheme->wigner_4j_matrices);
-  free(scheme->scrach);
   free(scheme);
 }
 
+/* Create a new workspace with buffers sized for the orientation tables. */
+MRS_workspace *MRS_create_workspace(MRS_orientation_tables *scheme) {
+  MRS_workspace *workspace = malloc(sizeof(MRS_workspace));
+
+  /* w2 is the buffer for storing the frequencies calculated from the second-rank
+   * tensors. Only calcuate the -2, -1, and 0 tensor components.*/
+  workspace->w2 = malloc_complex128(3 * scheme->total_orientations);
+
+  workspace->w4 = NULL;
+  if (scheme->allow_4th_rank) {
+    /* w4 is the buffer for storing the frequencies calculated from the fourth-rank
+     * tensors. Only calcuate the -4, -3, -2, -1, and 0 tensor components.*/
+    workspace->w4 = malloc_complex128(5 * scheme->total_orientations);
+  }
+
+  workspace->scrach = (double *)malloc_complex128(scheme->octant_orientations);
+  return workspace;
+}
+
+void MRS_free_workspace(MRS_workspace *workspace) {
+  free(workspace->w2);
+  free(workspace->w4);
+  free(workspace->scrach);
+  free(workspace);
+}
+
+MRS_spatial_basis *MRS_create_spatial_basis(MRS_orientation_tables *scheme,
+                                            unsigned int max_terms) {
+  size_t total = scheme->total_orientations;
+  MRS_spatial_basis *basis = malloc(sizeof(MRS_spatial_basis));
+
+  basis->max_terms = max_terms;
+  basis->n_terms_2 = 0;
+  basis->n_terms_4 = 0;
+  basis->allow_4th_rank = false;
+  basis->r0 = malloc_double(max_terms);
+  basis->w2 = malloc_double(6 * total * max_terms);
+  basis->w4 = NULL;
+  if (scheme->allow_4th_rank) basis->w4 = malloc_double(10 * total * max_terms);
+  return basis;
+}
+
+void MRS_free_spatial_basis(MRS_spatial_basis *basis) {
+  free(basis->r0);
+  free(basis->w2);
+  free(basis->w4);
+  free(basis);
+}
+
 /* Create a new orientation averaging scheme. */
-MRS_averaging_scheme *MRS_create_averaging_scheme(unsigned int integration_density,
+MRS_orientation_tables *MRS_create_orientation_tables(unsigned int integration_density,
                                                   bool allow_4th_rank,
                                                   unsigned int n_gamma,
                                                   unsigned int integration_volume) {
   int i;
-  MRS_averaging_scheme *scheme = malloc(sizeof(MRS_averaging_scheme));
+  MRS_orientation_tables *scheme = malloc(sizeof(MRS_orientation_tables));
 
   scheme->n_gamma = n_gamma;
   scheme->integration_density = integration_density;
@@ -172,20 +215,19 @@ MRS_averaging_scheme *MRS_create_averaging_scheme(unsigned int integration_densi
                      &scheme->exp_Im_gamma[(4 - i) * scheme->n_gamma]);
   }
 
-  // reallocate exp_I_beta memory as scrach.
-  scheme->scrach = (double *)exp_I_beta;
+  free(exp_I_beta);
   free(gamma);
   free(temp);
   return scheme;
 }
 
 /* Create a new orientation averaging scheme. */
-MRS_averaging_scheme *MRS_create_averaging_scheme_from_alpha_beta(double *alpha,
+MRS_orientation_tables *MRS_create_orientation_tables_from_alpha_beta(double *alpha,
                                                                   double *beta,
                                                                   double *weight,
                                                                   unsigned int n_angles,
                                                                   bool allow_4th_rank) {
-  MRS_averaging_scheme *scheme = malloc(sizeof(MRS_averaging_scheme));
+  MRS_orientation_tables *scheme = malloc(sizeof(MRS_orientation_tables));
 
   scheme->octant_orientations = n_angles;
   scheme->integration_volume = 0;
@@ -204,14 +246,31 @@ MRS_averaging_scheme *MRS_create_averaging_scheme_from_alpha_beta(double *alpha,
 
   averaging_scheme_setup(scheme, exp_I_beta, allow_4th_rank);
 
-  // reallocate exp_I_beta memory as scrach.
-  scheme->scrach = (double *)exp_I_beta;
+  free(exp_I_beta);
+  scheme->allow_4th_rank = allow_4th_rank;
   return scheme;
 }
 
 /* ---------------------------------------------------------------------------------- */
 /* fftw routine setup ............................................................... */
 /* .................................................................................. */
+
+/* The planner rigor of the new fftw plans, and the count of plans created with a rigor
+ * other than MRS_FFTW_ESTIMATE. Both are guarded by the mrs_fftw_planner section. */
+static unsigned int __fftw_plan_rigor = MRS_FFTW_ESTIMATE;
+static unsigned long __fftw_tuned_plans = 0;
+
+static inline unsigned int __fftw_planner_flag(unsigned int rigor) {
+  switch (rigor) {
+  case MRS_FFTW_MEASURE:
+    return FFTW_MEASURE;
+  case MRS_FFTW_PATIENT:
+    return FFTW_PATIENT;
+  default:
+    return FFTW_ESTIMATE;
+  }
+}
+
 MRS_fftw_scheme *create_fftw_scheme(unsigned int total_orientations,
                                     unsigned int number_of_sidebands) {
   unsigned int size = total_orientations * number_of_sidebands;
@@ -229,13 +288,17 @@ MRS_fftw_scheme *create_fftw_scheme(unsigned int total_orientations,
   // }
   // fftw_plan_with_nthreads(2);
 
+  /**
+   * The MEASURE and PATIENT planners time the candidate algorithms, and overwrite the
+   * `vector` buffer while doing so. This is safe since `vector` is re-evaluated before
+   * every transform. With the wisdom from a previous run, see MRS_import_fftw_wisdom(),
+   * the planner re-uses the tuned plans without re-measuring.
+   */
   fftw_scheme->the_fftw_plan = fftw_plan_many_dft(
       1, &nssb, total_orientations, fftw_scheme->vector, NULL, total_orientations, 1,
-      fftw_scheme->vector, NULL, total_orientations, 1, FFTW_FORWARD, FFTW_ESTIMATE);
-
-  // char *filename = "128_sidebands.wisdom";
-  // int status = fftw_export_wisdom_to_filename(filename);
-  // printf("file save status %i \n", status);
+      fftw_scheme->vector, NULL, total_orientations, 1, FFTW_FORWARD,
+      __fftw_planner_flag(__fftw_plan_rigor));
+  if (__fftw_plan_rigor != MRS_FFTW_ESTIMATE) __fftw_tuned_plans++;
   /* ----------------------------------------------------------------------- */
   return fftw_scheme;
 }
@@ -246,3 +309,216 @@ void MRS_free_fftw_scheme(MRS_fftw_scheme *fftw_scheme) {
   // fftw_cleanup();
   free(fftw_scheme);
 }
+
+/* ---------------------------------------------------------------------------------- */
+/* process-wide cache ............................................................... */
+/* .................................................................................. */
+
+/* The cache entries. A NULL pointer marks an empty slot. The `ref_count` of a tables
+ * entry counts the active references, while for a fftw entry, it is either 0 (free) or
+ * 1 (in use). The `last_used` stamp orders the entries for eviction. */
+typedef struct __tables_cache_entry {
+  MRS_orientation_tables *scheme;
+  unsigned int ref_count;
+  unsigned long last_used;
+} __tables_cache_entry;
+
+typedef struct __fftw_cache_entry {
+  MRS_fftw_scheme *fftw_scheme;
+  unsigned int total_orientations;
+  unsigned int number_of_sidebands;
+  unsigned int plan_rigor;
+  unsigned int ref_count;
+  unsigned long last_used;
+} __fftw_cache_entry;
+
+static __tables_cache_entry __tables_cache[MRS_TABLES_CACHE_SIZE];
+static __fftw_cache_entry __fftw_cache[MRS_FFTW_CACHE_SIZE];
+static unsigned long __tables_clock = 0, __fftw_clock = 0;
+
+/* Return the index of an empty slot, or else, the least recently used unreferenced
+ * slot, or -1 if every slot is in use. The scheme of an evicted slot is freed. */
+static inline int __tables_cache_slot() {
+  int i, slot = -1;
+  for (i = 0; i < MRS_TABLES_CACHE_SIZE; i++) {
+    if (__tables_cache[i].scheme == NULL) return i;
+    if (__tables_cache[i].ref_count != 0) continue;
+    if (slot == -1 || __tables_cache[i].last_used < __tables_cache[slot].last_used) {
+      slot = i;
+    }
+  }
+  if (slot != -1) {
+    MRS_free_orientation_tables(__tables_cache[slot].scheme);
+    __tables_cache[slot].scheme = NULL;
+  }
+  return slot;
+}
+
+MRS_orientation_tables *MRS_acquire_orientation_tables(unsigned int integration_density,
+                                                       bool allow_4th_rank,
+                                                       unsigned int n_gamma,
+                                                       unsigned int integration_volume) {
+  int i, slot;
+  MRS_orientation_tables *scheme = NULL, *item;
+
+#pragma omp critical(mrs_tables_cache)
+  {
+    for (i = 0; i < MRS_TABLES_CACHE_SIZE; i++) {
+      item = __tables_cache[i].scheme;
+      if (item != NULL && item->integration_density == integration_density &&
+          item->integration_volume == integration_volume &&
+          item->n_gamma == n_gamma && item->allow_4th_rank == allow_4th_rank) {
+        __tables_cache[i].ref_count++;
+        __tables_cache[i].last_used = ++__tables_clock;
+        scheme = item;
+        break;
+      }
+    }
+
+    if (scheme == NULL) {
+      scheme = MRS_create_orientation_tables(integration_density, allow_4th_rank,
+                                             n_gamma, integration_volume);
+      // When every slot is referenced, the tables are handed out uncached.
+      slot = __tables_cache_slot();
+      if (slot != -1) {
+        __tables_cache[slot].scheme = scheme;
+        __tables_cache[slot].ref_count = 1;
+        __tables_cache[slot].last_used = ++__tables_clock;
+      }
+    }
+  }
+  return scheme;
+}
+
+void MRS_release_orientation_tables(MRS_orientation_tables *scheme) {
+  int i;
+  bool cached = false;
+
+#pragma omp critical(mrs_tables_cache)
+  {
+    for (i = 0; i < MRS_TABLES_CACHE_SIZE; i++) {
+      if (__tables_cache[i].scheme == scheme) {
+        if (__tables_cache[i].ref_count > 0) __tables_cache[i].ref_count--;
+        cached = true;
+        break;
+      }
+    }
+  }
+  if (!cached) MRS_free_orientation_tables(scheme);
+}
+
+/* Same as __tables_cache_slot for the fftw cache. Call within mrs_fftw_planner. */
+static inline int __fftw_cache_slot() {
+  int i, slot = -1;
+  for (i = 0; i < MRS_FFTW_CACHE_SIZE; i++) {
+    if (__fftw_cache[i].fftw_scheme == NULL) return i;
+    if (__fftw_cache[i].ref_count != 0) continue;
+    if (slot == -1 || __fftw_cache[i].last_used < __fftw_cache[slot].last_used) {
+      slot = i;
+    }
+  }
+  if (slot != -1) {
+    MRS_free_fftw_scheme(__fftw_cache[slot].fftw_scheme);
+    __fftw_cache[slot].fftw_scheme = NULL;
+  }
+  return slot;
+}
+
+MRS_fftw_scheme *MRS_acquire_fftw_scheme(unsigned int total_orientations,
+                                         unsigned int number_of_sidebands) {
+  int i, slot;
+  MRS_fftw_scheme *fftw_scheme = NULL;
+
+// The fftw planner is not thread safe, hence the cache shares its critical section.
+#pragma omp critical(mrs_fftw_planner)
+  {
+    for (i = 0; i < MRS_FFTW_CACHE_SIZE; i++) {
+      if (__fftw_cache[i].fftw_scheme != NULL && __fftw_cache[i].ref_count == 0 &&
+          __fftw_cache[i].total_orientations == total_orientations &&
+          __fftw_cache[i].number_of_sidebands == number_of_sidebands &&
+          __fftw_cache[i].plan_rigor == __fftw_plan_rigor) {
+        __fftw_cache[i].ref_count = 1;
+        __fftw_cache[i].last_used = ++__fftw_clock;
+        fftw_scheme = __fftw_cache[i].fftw_scheme;
+        break;
+      }
+    }
+
+    if (fftw_scheme == NULL) {
+      fftw_scheme = create_fftw_scheme(total_orientations, number_of_sidebands);
+      slot = __fftw_cache_slot();
+      if (slot != -1) {
+        __fftw_cache[slot].fftw_scheme = fftw_scheme;
+        __fftw_cache[slot].total_orientations = total_orientations;
+        __fftw_cache[slot].number_of_sidebands = number_of_sidebands;
+        __fftw_cache[slot].plan_rigor = __fftw_plan_rigor;
+        __fftw_cache[slot].ref_count = 1;
+        __fftw_cache[slot].last_used = ++__fftw_clock;
+      }
+    }
+  }
+  return fftw_scheme;
+}
+
+void MRS_release_fftw_scheme(MRS_fftw_scheme *fftw_scheme) {
+  int i;
+  bool cached = false;
+
+#pragma omp critical(mrs_fftw_planner)
+  {
+    for (i = 0; i < MRS_FFTW_CACHE_SIZE; i++) {
+      if (__fftw_cache[i].fftw_scheme == fftw_scheme) {
+        __fftw_cache[i].ref_count = 0;
+        cached = true;
+        break;
+      }
+    }
+    if (!cached) MRS_free_fftw_scheme(fftw_scheme);
+  }
+}
+
+void MRS_clear_cache() {
+  int i;
+#pragma omp critical(mrs_tables_cache)
+  for (i = 0; i < MRS_TABLES_CACHE_SIZE; i++) {
+    if (__tables_cache[i].scheme != NULL && __tables_cache[i].ref_count == 0) {
+      MRS_free_orientation_tables(__tables_cache[i].scheme);
+      __tables_cache[i].scheme = NULL;
+    }
+  }
+
+#pragma omp critical(mrs_fftw_planner)
+  for (i = 0; i < MRS_FFTW_CACHE_SIZE; i++) {
+    if (__fftw_cache[i].fftw_scheme != NULL && __fftw_cache[i].ref_count == 0) {
+      MRS_free_fftw_scheme(__fftw_cache[i].fftw_scheme);
+      __fftw_cache[i].fftw_scheme = NULL;
+    }
+  }
+}
+
+void MRS_set_fftw_plan_rigor(unsigned int rigor) {
+  if (rigor > MRS_FFTW_PATIENT) rigor = MRS_FFTW_PATIENT;
+#pragma omp critical(mrs_fftw_planner)
+  __fftw_plan_rigor = rigor;
+}
+
+int MRS_import_fftw_wisdom(const char *filename) {
+  int status;
+#pragma omp critical(mrs_fftw_planner)
+  status = fftw_import_wisdom_from_filename(filename);
+  return status;
+}
+
+int MRS_export_fftw_wisdom(const char *filename) {
+  int status;
+#pragma omp critical(mrs_fftw_planner)
+  status = fftw_export_wisdom_to_filename(filename);
+  return status;
+}
+
+unsigned long MRS_fftw_tuned_plan_count() {
+  unsigned long count;
+#pragma omp critical(mrs_fftw_planner)
+  count = __fftw_tuned_plans;
+  return count;
+}
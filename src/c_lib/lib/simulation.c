@@ -11,6 +11,15 @@
 
 #include "frequency_averaging.h"
 
+#include <stdint.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#define __thread_id() omp_get_thread_num()
+#else
+#define __thread_id() 0
+#endif
+
 /**
  * Each event consists of the following freq contrib ordered as
  * 1. Shielding 1st order 0th rank
@@ -33,27 +42,17 @@ static inline void __zero_components(double *R0, complex128 *R2, complex128 *R4)
   vm_double_zeros(18, (double *)R4);
 }
 
-// Calculate spectrum from the spin systems for a single transition.
-void __mrsimulator_core(
-    // spectrum information and related amplitude
-    double *spec,                // Pointer to the spectrum array (complex).
+// Evaluate the frequencies and amplitudes of a transition pathway along every dimension.
+static void __evaluate_pathway_frequencies(
     site_struct *sites,          // Pointer to a list of sites within a spin system.
     coupling_struct *couplings,  // Pointer to a list of couplings within a spin system.
-
-    // A pointer to a spin transition pathway packed as a series of transitions. Each
-    // transition is a list of quantum numbers packed as quantum numbers from the
-    // initial energy state followed by the quantum numbers from the final energy state.
-    // The energy states are given in Zeeman basis.
-    float *transition_pathway,          // Pointer to the transition pathway,
-    double *transition_pathway_weight,  // The comlpex weight of transition pathway.
-    int n_dimension,                    // The total number of spectroscopic dimensions.
-    MRS_dimension *dimensions,          // Pointer to MRS_dimension structure.
-    MRS_fftw_scheme *fftw_scheme,       // Pointer to the fftw scheme.
-    MRS_averaging_scheme *scheme,       // Pointer to the powder averaging scheme.
-    bool interpolation,                 // If true, perform a 1D interpolation.
-    unsigned int iso_intrp,  // Isotropic interpolation scheme (linear | Gaussian)
-    bool *freq_contrib,      // A list of freq_contrib booleans.
-    double *affine_matrix    // Affine transformation matrix.
+    float *transition_pathway,   // Pointer to the transition pathway,
+    int n_dimension,             // The total number of spectroscopic dimensions.
+    MRS_dimension *dimensions,   // Pointer to MRS_dimension structure.
+    MRS_fftw_scheme *fftw_scheme,    // Pointer to the fftw scheme.
+    MRS_orientation_tables *scheme,  // Pointer to the powder averaging scheme.
+    MRS_spatial_basis *basis,  // Pointer to the spatial basis of spin system, or NULL.
+    bool *freq_contrib         // A list of freq_contrib booleans.
 ) {
   /*
   The sideband computation is based on the method described by Eden and Levitt
@@ -70,6 +69,9 @@ void __mrsimulator_core(
   double R0 = 0.0, R0_temp = 0.0;
   complex128 R2[5], R4[9], R2_temp[5], R4_temp[9];
 
+  // Coefficients of the spatial tensor terms, when evaluating from the spatial basis.
+  double c2[MRS_SPATIAL_BASIS_MAX_TERMS], c4[MRS_SPATIAL_BASIS_MAX_TERMS];
+
   // `transition_increment` is the step size to the next transition within the pathway.
   int transition_increment = 2 * sites->number_of_sites;
   float *transition = transition_pathway;
@@ -91,33 +93,43 @@ void __mrsimulator_core(
       B0_in_T = event->magnetic_flux_density_in_T;
       fraction = event->fraction;
 
-      /* Initialize with zeroing all spatial components */
-      __zero_components(&R0, R2, R4);
-
-      /* Rotate all frequency components from PAS to a common frame */
-      MRS_rotate_components_from_PAS_to_common_frame(
-          sites,                 // Pointer to a list of sites within a spin system.
-          couplings,             // Pointer to a list of couplings within a spin system.
-          transition,            // Pointer to a single transition.
-          plan->allow_4th_rank,  // If 1, prepare for 4th rank computation.
-          &R0,                   // The R0 components.
-          R2,                    // The R2 components.
-          R4,                    // The R4 components.
-          &R0_temp,              // The temporary R0 components.
-          R2_temp,               // The temporary R2 components.
-          R4_temp,               // The temporary R4 components.
-          B0_in_T,               // Magnetic flux density in T.
-          freq_contrib           // The pointer to freq contribs boolean.
-      );
+      /* Get frequencies and amplitudes per octant .................................. */
+      /* IMPORTANT: Always evalute the frequencies before the amplitudes. */
+      if (basis != NULL) {
+        /* The frequency components are linear combinations of the rotated spatial
+         * tensor terms of the spin system, weighted by the spin transition functions. */
+        MRS_get_spatial_basis_coefficients(sites, couplings, basis, transition, B0_in_T,
+                                           freq_contrib, &R0, c2, c4);
+        MRS_get_normalized_frequencies_and_phases_from_basis(
+            scheme, plan, fftw_scheme, basis, R0, c2, c4, reset, &dimensions[dim],
+            fraction);
+      } else {
+        /* Initialize with zeroing all spatial components */
+        __zero_components(&R0, R2, R4);
+
+        /* Rotate all frequency components from PAS to a common frame */
+        MRS_rotate_components_from_PAS_to_common_frame(
+            sites,       // Pointer to a list of sites within a spin system.
+            couplings,   // Pointer to a list of couplings within a spin system.
+            transition,  // Pointer to a single transition.
+            plan->allow_4th_rank,  // If 1, prepare for 4th rank computation.
+            &R0,                   // The R0 components.
+            R2,                    // The R2 components.
+            R4,                    // The R4 components.
+            &R0_temp,              // The temporary R0 components.
+            R2_temp,               // The temporary R2 components.
+            R4_temp,               // The temporary R4 components.
+            B0_in_T,               // Magnetic flux density in T.
+            freq_contrib           // The pointer to freq contribs boolean.
+        );
+        MRS_get_normalized_frequencies_and_phases_from_plan(
+            scheme, plan, fftw_scheme, R0, R2, R4, reset, &dimensions[dim], fraction);
+      }
 
       // The number 6 comes from the six types of pre-listed freq contributions.
       freq_contrib += FREQ_CONTRIB_INCREMENT;
 
-      /* Get frequencies and amplitudes per octant .................................. */
-      /* IMPORTANT: Always evalute the frequencies before the amplitudes. */
-      MRS_get_normalized_frequencies_from_plan(scheme, plan, R0, R2, R4, reset,
-                                               &dimensions[dim], fraction);
-      MRS_get_amplitudes_from_plan(scheme, plan, fftw_scheme, 1);
+      MRS_get_amplitudes_from_phases(plan, fftw_scheme);
 
       /* Copy the amplitudes from the `fftw_scheme->vector` to the
        * `event->freq_amplitude` for each event within the dimension. If the number of
@@ -135,35 +147,76 @@ void __mrsimulator_core(
       reset = 0;  // reset the freqs to zero for next dimension.
     }             // end events
   }               // end dimensions
+}
 
-  /* ---------------------------------------------------------------------
-   *              Delta and triangle tenting interpolation
-   */
-
+// Delta and triangle tenting interpolation of the evaluated frequencies and amplitudes.
+static inline void __average_pathway(double *spec, double weight_re, double weight_im,
+                                     int n_dimension, MRS_dimension *dimensions,
+                                     MRS_orientation_tables *scheme,
+                                     MRS_workspace *workspace, unsigned int iso_intrp,
+                                     double *affine_matrix) {
   switch (n_dimension) {
   case 1:
-    if (transition_pathway_weight[0] != 0.0) {
-      one_dimensional_averaging(dimensions, scheme, spec, transition_pathway_weight[0],
-                                iso_intrp);
+    if (weight_re != 0.0) {
+      one_dimensional_averaging(dimensions, scheme, spec, weight_re, iso_intrp);
     }
-    if (transition_pathway_weight[1] != 0.0) {
-      one_dimensional_averaging(dimensions, scheme, spec + 1,
-                                transition_pathway_weight[1], iso_intrp);
+    if (weight_im != 0.0) {
+      one_dimensional_averaging(dimensions, scheme, spec + 1, weight_im, iso_intrp);
     }
     break;
   case 2:
-    if (transition_pathway_weight[0] != 0.0) {
-      two_dimensional_averaging(dimensions, scheme, spec, transition_pathway_weight[0],
+    if (weight_re != 0.0) {
+      two_dimensional_averaging(dimensions, scheme, workspace, spec, weight_re,
                                 affine_matrix, iso_intrp);
     }
-    if (transition_pathway_weight[1] != 0.0) {
-      two_dimensional_averaging(dimensions, scheme, spec + 1,
-                                transition_pathway_weight[1], affine_matrix, iso_intrp);
+    if (weight_im != 0.0) {
+      two_dimensional_averaging(dimensions, scheme, workspace, spec + 1, weight_im,
+                                affine_matrix, iso_intrp);
     }
     break;
   }
 }
 
+// Calculate spectrum from the spin systems for a single transition.
+void __mrsimulator_core(
+    // spectrum information and related amplitude
+    double *spec,                // Pointer to the spectrum array (complex).
+    site_struct *sites,          // Pointer to a list of sites within a spin system.
+    coupling_struct *couplings,  // Pointer to a list of couplings within a spin system.
+
+    // A pointer to a spin transition pathway packed as a series of transitions. Each
+    // transition is a list of quantum numbers packed as quantum numbers from the
+    // initial energy state followed by the quantum numbers from the final energy state.
+    // The energy states are given in Zeeman basis.
+    float *transition_pathway,          // Pointer to the transition pathway,
+    double *transition_pathway_weight,  // The comlpex weight of transition pathway.
+    double weight,                      // The scaling factor (abundance) of spectrum.
+    int n_dimension,                    // The total number of spectroscopic dimensions.
+    MRS_dimension *dimensions,          // Pointer to MRS_dimension structure.
+    MRS_fftw_scheme *fftw_scheme,       // Pointer to the fftw scheme.
+    MRS_orientation_tables *scheme,     // Pointer to the powder averaging scheme.
+    MRS_workspace *workspace,           // Pointer to the scheme workspace.
+    MRS_spatial_basis *basis,  // Pointer to the spatial basis of spin system, or NULL.
+    bool interpolation,                 // If true, perform a 1D interpolation.
+    unsigned int iso_intrp,  // Isotropic interpolation scheme (linear | Gaussian)
+    bool *freq_contrib,      // A list of freq_contrib booleans.
+    double *affine_matrix    // Affine transformation matrix.
+) {
+  // Fold the spectrum scaling into the pathway weight, so that the amplitudes are
+  // accumulated directly into the spectrum.
+  double weight_re = transition_pathway_weight[0] * weight;
+  double weight_im = transition_pathway_weight[1] * weight;
+
+  __evaluate_pathway_frequencies(sites, couplings, transition_pathway, n_dimension,
+                                 dimensions, fftw_scheme, scheme, basis, freq_contrib);
+
+  /* ---------------------------------------------------------------------
+   *              Delta and triangle tenting interpolation
+   */
+  __average_pathway(spec, weight_re, weight_im, n_dimension, dimensions, scheme,
+                    workspace, iso_intrp, affine_matrix);
+}
+
 void mrsimulator_core(
     // spectrum information and related amplitude
     double *spec,                // Pointer to the spectrum array (complex).
@@ -208,11 +261,13 @@ void mrsimulator_core(
     number_of_sidebands = 1;
   }
 
-  MRS_averaging_scheme *scheme = MRS_create_averaging_scheme(
+  MRS_orientation_tables *scheme = MRS_acquire_orientation_tables(
       integration_density, allow_4th_rank, 9, integration_volume);
 
+  MRS_workspace *workspace = MRS_create_workspace(scheme);
+
   MRS_fftw_scheme *fftw_scheme =
-      create_fftw_scheme(scheme->total_orientations, number_of_sidebands);
+      MRS_acquire_fftw_scheme(scheme->total_orientations, number_of_sidebands);
 
   // gettimeofday(&all_site_time, NULL);
   __mrsimulator_core(
@@ -221,8 +276,8 @@ void mrsimulator_core(
       sites,               // Pointer to a list of sites within the spin system.
       couplings,           // Pointer to a list of couplings within a spin system.
       transition_pathway,  // Pointer to a list of transition.
-      transition_pathway_weight, n_dimension, dimensions, fftw_scheme, scheme,
-      interpolation, interpolate_type, freq_contrib, affine_matrix);
+      transition_pathway_weight, 1.0, n_dimension, dimensions, fftw_scheme, scheme,
+      workspace, NULL, interpolation, interpolate_type, freq_contrib, affine_matrix);
 
   // gettimeofday(&end, NULL);
   // clock_time = (double)(end.tv_usec - begin.tv_usec) / 1000000. +
@@ -231,7 +286,1039 @@ void mrsimulator_core(
   // cpu_time_[0] += clock_time;
 
   /* clean up */
-  MRS_free_fftw_scheme(fftw_scheme);
-  MRS_free_averaging_scheme(scheme);
+  MRS_release_fftw_scheme(fftw_scheme);
+  MRS_free_workspace(workspace);
+  MRS_release_orientation_tables(scheme);
   // MRS_free_plan(plan);
 }
+
+/**
+ * Worker state for the threaded spin system loop. The orientation tables are shared
+ * between the threads. The workspace, dimension buffers, and fftw scheme are
+ * overwritten for every transition pathway, therefore, every thread owns a private
+ * copy.
+ */
+struct __worker_state {
+  MRS_workspace *workspace;      // Thread-local scheme workspace.
+  MRS_dimension *dimensions;     // Thread-local spectral dimensions.
+  MRS_fftw_scheme *fftw_scheme;  // Thread-local fftw scheme.
+  MRS_spatial_basis *basis;      // Thread-local spatial basis, created on demand.
+  double *snapshot;  // Thread-local copy of the frequencies and amplitudes, on demand.
+  double *spec;                  // Thread-local accumulated spectrum.
+};
+
+static inline void __create_worker_state(
+    __worker_state *state, int n_points, MRS_orientation_tables *scheme,
+    int n_dimension, int *count, double *coordinates_offset, double *increment,
+    double *fractions, double *magnetic_flux_density_in_T,
+    double *rotor_frequency_in_Hz, double *rotor_angle_in_rad, int *n_events,
+    unsigned int *number_of_sidebands) {
+  int dim;
+  unsigned int max_sidebands = 1;
+  for (dim = 0; dim < n_dimension; dim++) {
+    if (number_of_sidebands[dim] > max_sidebands) {
+      max_sidebands = number_of_sidebands[dim];
+    }
+  }
+
+  state->workspace = MRS_create_workspace(scheme);
+  state->dimensions = MRS_create_dimensions(
+      scheme, count, coordinates_offset, increment, fractions,
+      magnetic_flux_density_in_T, rotor_frequency_in_Hz, rotor_angle_in_rad, n_events,
+      n_dimension, number_of_sidebands);
+
+  state->fftw_scheme = MRS_acquire_fftw_scheme(scheme->total_orientations, max_sidebands);
+  state->basis = NULL;
+  state->snapshot = NULL;
+
+  state->spec = (double *)calloc(2 * n_points, sizeof(double));
+}
+
+static inline void __free_worker_state(__worker_state *state, int n_dimension) {
+  MRS_release_fftw_scheme(state->fftw_scheme);
+  MRS_free_dimension(state->dimensions, n_dimension);
+  MRS_free_workspace(state->workspace);
+  if (state->basis != NULL) MRS_free_spatial_basis(state->basis);
+  free(state->snapshot);
+  free(state->spec);
+}
+
+/**
+ * Prepare the spatial basis of a spin system when the rotation of its spatial tensor
+ * terms, once for all pathways, is cheaper than the rotation of the summed R2 and R4
+ * components for every pathway and event. The cost is counted in multiplications per
+ * orientation. Returns NULL when the components are rotated per event.
+ */
+static inline MRS_spatial_basis *__prepare_spatial_basis(MRS_simulation_plan *plan,
+                                                         __worker_state *state,
+                                                         site_struct *sites,
+                                                         coupling_struct *couplings,
+                                                         int n_pathways) {
+  int dim;
+  unsigned int n_terms_2, n_terms_4, events = 0, cost_basis, cost_direct;
+  bool allow_4th_rank = plan->scheme->allow_4th_rank;
+
+  for (dim = 0; dim < plan->n_dimension; dim++) {
+    events += state->dimensions[dim].n_events;
+  }
+  events *= n_pathways;
+
+  n_terms_2 = MRS_count_spatial_basis_terms(sites, couplings, allow_4th_rank, &n_terms_4);
+  if (n_terms_2 > MRS_SPATIAL_BASIS_MAX_TERMS) return NULL;
+
+  cost_basis = n_terms_2 * (40 + 6 * events) + n_terms_4 * (106 + 10 * events);
+  cost_direct = events * (40 + ((allow_4th_rank) ? 106 : 0));
+  if (cost_basis >= cost_direct) return NULL;
+
+  if (state->basis == NULL || state->basis->max_terms < n_terms_2) {
+    if (state->basis != NULL) MRS_free_spatial_basis(state->basis);
+    state->basis = MRS_create_spatial_basis(plan->scheme, n_terms_2);
+  }
+  MRS_set_spatial_basis(plan->scheme, state->basis, sites, couplings, allow_4th_rank);
+  return state->basis;
+}
+
+/* ---------------------------------------------------------------------------------- *
+ *                          Isotropic J coupled multiplets                              *
+ * ---------------------------------------------------------------------------------- *
+ * When the couplings of a spin system are isotropic J couplings only, the transition
+ * pathways which flip the same sites between the same states share the anisotropic
+ * lineshape, and differ only by the isotropic J frequency of the spectator sites. The
+ * frequencies and amplitudes of such a group are evaluated once, and binned at every
+ * distinct line of the multiplet. Lines at the same frequency are merged by adding
+ * their weights.
+ */
+
+// True if every coupling of the spin system is an isotropic J coupling.
+static inline bool __isotropic_j_couplings(coupling_struct *couplings) {
+  unsigned int i;
+  if (couplings->number_of_couplings == 0) return false;
+  for (i = 0; i < couplings->number_of_couplings; i++) {
+    if (couplings->j_symmetric_zeta_in_Hz[i] != 0.0) return false;
+    if (couplings->dipolar_coupling_in_Hz[i] != 0.0) return false;
+  }
+  return true;
+}
+
+// True if the two pathways flip the same sites between the same states at every
+// transition. Sites with equal initial and final states are spectators.
+static inline bool __same_anisotropic_pathway(float *a, float *b, unsigned int n_sites,
+                                              int length) {
+  int i;
+  unsigned int j;
+  bool flip_a, flip_b;
+  for (i = 0; i < length; i += 2 * n_sites) {
+    for (j = 0; j < n_sites; j++) {
+      flip_a = a[i + j] != a[i + j + n_sites];
+      flip_b = b[i + j] != b[i + j + n_sites];
+      if (flip_a != flip_b) return false;
+      if (flip_a && (a[i + j] != b[i + j] || a[i + j + n_sites] != b[i + j + n_sites])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Isotropic J frequency of a pathway along every dimension, normalized to the
+// increment of the dimension.
+static inline void __isotropic_j_offsets(coupling_struct *couplings,
+                                         unsigned int n_sites, float *transition,
+                                         int n_dimension, MRS_dimension *dimensions,
+                                         bool *freq_contrib, double *offset) {
+  unsigned int evt, i;
+  int dim, A, X;
+  double J;
+  for (dim = 0; dim < n_dimension; dim++) {
+    offset[dim] = 0.0;
+    for (evt = 0; evt < dimensions[dim].n_events; evt++) {
+      if (freq_contrib[6]) {
+        J = 0.0;
+        for (i = 0; i < couplings->number_of_couplings; i++) {
+          A = couplings->site_index[2 * i];
+          X = couplings->site_index[2 * i + 1];
+          J += couplings->isotropic_j_in_Hz[i] *
+               STF_dIS(transition[A + n_sites], transition[A], transition[X + n_sites],
+                       transition[X]);
+        }
+        offset[dim] += J * dimensions[dim].inverse_increment *
+                       dimensions[dim].events[evt].fraction;
+      }
+      freq_contrib += FREQ_CONTRIB_INCREMENT;
+      transition += 2 * n_sites;
+    }
+  }
+}
+
+// True if the lines of two pathways at the same frequency may be binned once with the
+// sum of their weights. The amplitudes are scaled in place by the real and then the
+// imaginary weight, therefore, only lines with the same single nonzero part merge.
+static inline bool __mergeable_weights(double *a, double *b) {
+  if (a[0] != 0.0 && a[1] != 0.0) return false;
+  if (b[0] != 0.0 && b[1] != 0.0) return false;
+  return (a[1] == 0.0) == (b[1] == 0.0);
+}
+
+// Save (or restore) the frequencies and amplitudes which are overwritten when binned.
+static inline void __copy_dimension_buffers(MRS_dimension *dimensions, int n_dimension,
+                                            MRS_orientation_tables *scheme,
+                                            double *buffer, bool save) {
+  int dim, size;
+  for (dim = 0; dim < n_dimension; dim++) {
+    size = scheme->n_gamma * scheme->total_orientations;
+    if (save) {
+      cblas_dcopy(size, dimensions[dim].local_frequency, 1, buffer, 1);
+    } else {
+      cblas_dcopy(size, buffer, 1, dimensions[dim].local_frequency, 1);
+    }
+    buffer += size;
+
+    size = dimensions[dim].events->plan->size;
+    if (save) {
+      cblas_dcopy(size, dimensions[dim].freq_amplitude, 1, buffer, 1);
+    } else {
+      cblas_dcopy(size, buffer, 1, dimensions[dim].freq_amplitude, 1);
+    }
+    buffer += size;
+  }
+}
+
+static inline double *__acquire_snapshot(MRS_simulation_plan *plan,
+                                         __worker_state *state) {
+  int dim;
+  size_t size = 0;
+  if (state->snapshot == NULL) {
+    for (dim = 0; dim < plan->n_dimension; dim++) {
+      size += plan->scheme->n_gamma * plan->scheme->total_orientations;
+      size += state->dimensions[dim].events->plan->size;
+    }
+    state->snapshot = malloc_double(size);
+  }
+  return state->snapshot;
+}
+
+// Calculate the spectrum of a spin system with isotropic J couplings only. Returns
+// false, without simulating, when the buffers of the multiplets can not be allocated.
+static bool __mrsimulator_multiplet_core(
+    double *spec,                // Pointer to the spectrum array (complex).
+    site_struct *sites,          // Pointer to a list of sites within a spin system.
+    coupling_struct *couplings,  // Pointer to a list of couplings within a spin system.
+    float *transition_pathways,          // The transition pathways of the spin system.
+    double *transition_pathway_weights,  // The complex pathway weights.
+    int n_pathways,                      // The number of transition pathways.
+    int increment,                       // Length of one transition pathway.
+    double weight,                       // The scaling factor (abundance) of spectrum.
+    MRS_simulation_plan *plan,           // The simulation plan.
+    __worker_state *state                // The worker state of the calling thread.
+) {
+  int p, q, r, dim, n_groups = 0, n_dimension = plan->n_dimension;
+  unsigned int n_sites = sites->number_of_sites;
+  double weight_re, weight_im, *offset, *snapshot;
+  double *R0 = malloc_double((n_pathways + 1) * n_dimension);
+  int *group = malloc(n_pathways * sizeof(int));
+  bool *done = calloc(n_pathways, sizeof(bool));
+  MRS_spatial_basis *basis;
+  MRS_dimension *dimensions = state->dimensions;
+
+  if (R0 == NULL || group == NULL || done == NULL) {
+    free(R0);
+    free(group);
+    free(done);
+    return false;
+  }
+
+  // Group the pathways by their anisotropic part, and evaluate the J frequencies.
+  for (p = 0; p < n_pathways; p++) {
+    group[p] = p;
+    for (q = 0; q < p; q++) {
+      if (group[q] == q &&
+          __same_anisotropic_pathway(&transition_pathways[increment * p],
+                                     &transition_pathways[increment * q], n_sites,
+                                     increment)) {
+        group[p] = q;
+        break;
+      }
+    }
+    if (group[p] == p) n_groups++;
+    __isotropic_j_offsets(couplings, n_sites, &transition_pathways[increment * p],
+                          n_dimension, dimensions, plan->freq_contrib,
+                          &R0[n_dimension * p]);
+  }
+
+  snapshot = (n_groups < n_pathways) ? __acquire_snapshot(plan, state) : NULL;
+  if (n_groups < n_pathways && snapshot == NULL) {
+    free(R0);
+    free(group);
+    free(done);
+    return false;
+  }
+  basis = __prepare_spatial_basis(plan, state, sites, couplings, n_groups);
+  offset = &R0[n_dimension * n_pathways];
+
+  for (p = 0; p < n_pathways; p++) {
+    if (group[p] != p) continue;
+    __evaluate_pathway_frequencies(sites, couplings, &transition_pathways[increment * p],
+                                   n_dimension, dimensions, state->fftw_scheme,
+                                   plan->scheme, basis, plan->freq_contrib);
+
+    // The isotropic offset of the lineshape without the J frequency of pathway `p`.
+    for (dim = 0; dim < n_dimension; dim++) {
+      offset[dim] = dimensions[dim].R0_offset - R0[n_dimension * p + dim];
+    }
+    if (snapshot != NULL) {
+      __copy_dimension_buffers(dimensions, n_dimension, plan->scheme, snapshot, true);
+    }
+
+    for (q = p; q < n_pathways; q++) {
+      if (group[q] != p || done[q]) continue;
+
+      // Merge the lines of the multiplet at the same frequency.
+      weight_re = weight_im = 0.0;
+      for (r = q; r < n_pathways; r++) {
+        if (group[r] != p || done[r]) continue;
+        if (r != q && !__mergeable_weights(&transition_pathway_weights[2 * q],
+                                           &transition_pathway_weights[2 * r])) {
+          continue;
+        }
+        for (dim = 0; dim < n_dimension; dim++) {
+          if (fabs(R0[n_dimension * r + dim] - R0[n_dimension * q + dim]) > 1e-9) break;
+        }
+        if (dim != n_dimension) continue;
+        weight_re += transition_pathway_weights[2 * r];
+        weight_im += transition_pathway_weights[2 * r + 1];
+        done[r] = true;
+      }
+
+      if (q != p) {
+        __copy_dimension_buffers(dimensions, n_dimension, plan->scheme, snapshot, false);
+      }
+      for (dim = 0; dim < n_dimension; dim++) {
+        dimensions[dim].R0_offset = offset[dim] + R0[n_dimension * q + dim];
+      }
+      __average_pathway(spec, weight_re * weight, weight_im * weight, n_dimension,
+                        dimensions, plan->scheme, state->workspace, plan->iso_intrp,
+                        plan->affine_matrix);
+    }
+  }
+
+  free(R0);
+  free(group);
+  free(done);
+  return true;
+}
+
+// Calculate the spectrum of a spin system over all transition pathways.
+static inline void __simulate_spin_system(
+    MRS_simulation_plan *plan,   // The simulation plan.
+    __worker_state *state,       // The worker state of the calling thread.
+    double *spec,                // Pointer to the spectrum array (complex).
+    site_struct *sites,          // Pointer to a list of sites within a spin system.
+    coupling_struct *couplings,  // Pointer to a list of couplings within a spin system.
+    float *transition_pathways,          // The transition pathways of the spin system.
+    double *transition_pathway_weights,  // The complex pathway weights.
+    int n_pathways,                      // The number of transition pathways.
+    int increment,                       // Length of one transition pathway.
+    double scale                         // The scaling factor (abundance) of spectrum.
+) {
+  int trans;
+  MRS_spatial_basis *basis;
+
+  // Multiplets of isotropic J couplings share the anisotropic lineshape. Without the
+  // buffers of the multiplets, the pathways are simulated one at a time.
+  if (n_pathways > 1 && __isotropic_j_couplings(couplings) &&
+      __mrsimulator_multiplet_core(spec, sites, couplings, transition_pathways,
+                                   transition_pathway_weights, n_pathways, increment,
+                                   scale, plan, state)) {
+    return;
+  }
+
+  // Rotate the spatial tensors once, when shared by sufficiently many pathways.
+  basis = __prepare_spatial_basis(plan, state, sites, couplings, n_pathways);
+
+  for (trans = 0; trans < n_pathways; trans++) {
+    __mrsimulator_core(spec, sites, couplings, &transition_pathways[increment * trans],
+                       &transition_pathway_weights[2 * trans], scale, plan->n_dimension,
+                       state->dimensions, state->fftw_scheme, plan->scheme,
+                       state->workspace, basis, plan->interpolation, plan->iso_intrp,
+                       plan->freq_contrib, plan->affine_matrix);
+  }
+}
+
+/* ---------------------------------------------------------------------------------- *
+ *                         Isotropic chemical shift distributions                       *
+ * ---------------------------------------------------------------------------------- *
+ * Single-site spin systems which differ only in the isotropic chemical shift share the
+ * anisotropic lineshape. With the isotropic convolution of the plan enabled, the
+ * lineshape of every transition pathway of such a group is binned once, over a grid
+ * extended by the spread of the shifts, and convolved with the abundance weighted
+ * histogram of the isotropic shifts. The shifts are split linearly between the two
+ * nearest bins of the histogram, which adds a sub-bin broadening compared to the
+ * spectra simulated one spin system at a time.
+ */
+
+// True if the spin system may be part of an isotropic shift distribution.
+static inline bool __isotropic_distribution_candidate(site_struct *sites,
+                                                      coupling_struct *couplings) {
+  return sites->number_of_sites == 1 && couplings->number_of_couplings == 0;
+}
+
+// True if the two single-site spin systems differ at most in the isotropic shift.
+static inline bool __same_anisotropic_site(site_struct *a, site_struct *b) {
+  int i;
+  if (a->spin[0] != b->spin[0]) return false;
+  if (a->gyromagnetic_ratio[0] != b->gyromagnetic_ratio[0]) return false;
+  if (a->shielding_symmetric_zeta_in_ppm[0] != b->shielding_symmetric_zeta_in_ppm[0]) {
+    return false;
+  }
+  if (a->shielding_symmetric_eta[0] != b->shielding_symmetric_eta[0]) return false;
+  if (a->quadrupolar_Cq_in_Hz[0] != b->quadrupolar_Cq_in_Hz[0]) return false;
+  if (a->quadrupolar_eta[0] != b->quadrupolar_eta[0]) return false;
+  for (i = 0; i < 3; i++) {
+    if (a->shielding_orientation[i] != b->shielding_orientation[i]) return false;
+    if (a->quadrupolar_orientation[i] != b->quadrupolar_orientation[i]) return false;
+  }
+  return true;
+}
+
+// True if the two spin systems have the same transition pathways and weights.
+static inline bool __same_pathways(float *pathways_a, double *weights_a, int count_a,
+                                   int increment_a, float *pathways_b,
+                                   double *weights_b, int count_b, int increment_b) {
+  if (count_a != count_b || increment_a != increment_b) return false;
+  if (pathways_a != pathways_b &&
+      memcmp(pathways_a, pathways_b, count_a * increment_a * sizeof(float)) != 0) {
+    return false;
+  }
+  if (weights_a != weights_b &&
+      memcmp(weights_a, weights_b, 2 * count_a * sizeof(double)) != 0) {
+    return false;
+  }
+  return true;
+}
+
+// FNV-1a hash of `size` bytes, continued from `hash`.
+static inline uint64_t __hash_bytes(uint64_t hash, const void *data, size_t size) {
+  const unsigned char *byte = data;
+  while (size--) hash = (hash ^ *byte++) * 0x100000001b3ULL;
+  return hash;
+}
+
+// Hash of the fields compared by __same_anisotropic_site and __same_pathways.
+static uint64_t __isotropic_distribution_key(site_struct *site, float *pathways,
+                                             double *weights, int count,
+                                             int increment) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  hash = __hash_bytes(hash, site->spin, sizeof(float));
+  hash = __hash_bytes(hash, site->gyromagnetic_ratio, sizeof(double));
+  hash = __hash_bytes(hash, site->shielding_symmetric_zeta_in_ppm, sizeof(double));
+  hash = __hash_bytes(hash, site->shielding_symmetric_eta, sizeof(double));
+  hash = __hash_bytes(hash, site->quadrupolar_Cq_in_Hz, sizeof(double));
+  hash = __hash_bytes(hash, site->quadrupolar_eta, sizeof(double));
+  hash = __hash_bytes(hash, site->shielding_orientation, 3 * sizeof(double));
+  hash = __hash_bytes(hash, site->quadrupolar_orientation, 3 * sizeof(double));
+  hash = __hash_bytes(hash, &count, sizeof(int));
+  hash = __hash_bytes(hash, &increment, sizeof(int));
+  hash = __hash_bytes(hash, pathways, (size_t)count * increment * sizeof(float));
+  return __hash_bytes(hash, weights, 2 * (size_t)count * sizeof(double));
+}
+
+typedef struct __keyed_spin_system {
+  uint64_t key;
+  int sys;
+} __keyed_spin_system;
+
+// Order by key, and by spin system index within the same key.
+static int __compare_keyed_spin_systems(const void *a, const void *b) {
+  const __keyed_spin_system *x = a, *y = b;
+  if (x->key != y->key) return (x->key < y->key) ? -1 : 1;
+  return x->sys - y->sys;
+}
+
+/**
+ * Group the spin systems into isotropic shift distributions. The spin systems of group
+ * `g` are `order[start[g]]` to `order[start[g + 1] - 1]`, and the groups are ordered by
+ * their first spin system. The candidates are sorted by the hash of their anisotropic
+ * site and transition pathways, and the equality is only confirmed within a run of
+ * equal hashes. Returns the number of groups, or -1 if the allocation fails.
+ */
+static int __group_isotropic_distributions(
+    int n_spin_systems, site_struct *sites, coupling_struct *couplings,
+    float **transition_pathways, double **transition_pathway_weights,
+    int *pathway_count, int *pathway_increment, int *order, int *start) {
+  int i, j, k, a, b, sys, g, n_keys = 0, n_groups = 0;
+  int *group = malloc(n_spin_systems * sizeof(int));
+  int *head = malloc(n_spin_systems * sizeof(int));
+  __keyed_spin_system *keys = malloc(n_spin_systems * sizeof(__keyed_spin_system));
+
+  if (group == NULL || head == NULL || keys == NULL) {
+    free(group);
+    free(head);
+    free(keys);
+    return -1;
+  }
+
+  // Every spin system leads its own group until matched with an earlier spin system.
+  for (sys = 0; sys < n_spin_systems; sys++) {
+    head[sys] = sys;
+    if (__isotropic_distribution_candidate(&sites[sys], &couplings[sys])) {
+      keys[n_keys].key = __isotropic_distribution_key(
+          &sites[sys], transition_pathways[sys], transition_pathway_weights[sys],
+          pathway_count[sys], pathway_increment[sys]);
+      keys[n_keys++].sys = sys;
+    }
+  }
+  qsort(keys, n_keys, sizeof(__keyed_spin_system), __compare_keyed_spin_systems);
+
+  for (i = 0; i < n_keys; i = j) {
+    for (j = i + 1; j < n_keys && keys[j].key == keys[i].key; j++) {
+      b = keys[j].sys;
+      for (k = i; k < j; k++) {
+        a = keys[k].sys;
+        if (head[a] == a && __same_anisotropic_site(&sites[b], &sites[a]) &&
+            __same_pathways(transition_pathways[b], transition_pathway_weights[b],
+                            pathway_count[b], pathway_increment[b],
+                            transition_pathways[a], transition_pathway_weights[a],
+                            pathway_count[a], pathway_increment[a])) {
+          head[b] = a;
+          break;
+        }
+      }
+    }
+  }
+
+  // Number the groups in the order of their first spin system. A spin system is always
+  // matched with a head of a lower index.
+  for (sys = 0; sys < n_spin_systems; sys++) {
+    group[sys] = (head[sys] == sys) ? n_groups++ : group[head[sys]];
+  }
+
+  // Counting sort of the spin systems by group.
+  for (g = 0; g <= n_groups; g++) start[g] = 0;
+  for (sys = 0; sys < n_spin_systems; sys++) start[group[sys] + 1]++;
+  for (g = 0; g < n_groups; g++) start[g + 1] += start[g];
+  for (g = 0; g < n_groups; g++) head[g] = start[g];
+  for (sys = 0; sys < n_spin_systems; sys++) order[head[group[sys]]++] = sys;
+
+  free(group);
+  free(head);
+  free(keys);
+  return n_groups;
+}
+
+// The shift of a transition pathway in bins of the spectrum per ppm of the isotropic
+// chemical shift of the site, after the affine transformation.
+static inline void __isotropic_shift_per_ppm(site_struct *site, float *transition,
+                                             int n_dimension, MRS_dimension *dimensions,
+                                             bool *freq_contrib, double *affine_matrix,
+                                             double *shift) {
+  unsigned int evt;
+  int dim;
+  double larmor_freq_in_MHz, temp;
+  for (dim = 0; dim < n_dimension; dim++) {
+    shift[dim] = 0.0;
+    for (evt = 0; evt < dimensions[dim].n_events; evt++) {
+      if (freq_contrib[0]) {
+        larmor_freq_in_MHz = -dimensions[dim].events[evt].magnetic_flux_density_in_T *
+                             site->gyromagnetic_ratio[0];
+        shift[dim] += larmor_freq_in_MHz * STF_p(transition[1], transition[0]) *
+                      dimensions[dim].inverse_increment *
+                      dimensions[dim].events[evt].fraction;
+      }
+      freq_contrib += FREQ_CONTRIB_INCREMENT;
+      transition += 2;
+    }
+  }
+  if (n_dimension == 2) {
+    temp = affine_matrix[0] * shift[0] + affine_matrix[1] * shift[1];
+    shift[1] = affine_matrix[3] * shift[1] + affine_matrix[2] * temp;
+    shift[0] = temp;
+  }
+}
+
+// The extent of the grid of a transition pathway, extended by the range of the shifts.
+static inline void __isotropic_distribution_extent(int n_members, double *iso_shift,
+                                                   double iso_ref,
+                                                   double *shift_per_ppm, int *count,
+                                                   int *n_min, int *pad, int *ext,
+                                                   int *bins) {
+  int m, n, dim, n_max;
+  for (dim = 0; dim < 2; dim++) {
+    n_min[dim] = n_max = 0;
+    for (m = 0; m < n_members; m++) {
+      n = (int)floor(shift_per_ppm[dim] * (iso_shift[m] - iso_ref));
+      if (n < n_min[dim]) n_min[dim] = n;
+      if (n > n_max) n_max = n;
+    }
+    pad[dim] = n_max + 1;
+    ext[dim] = count[dim] + pad[dim] - n_min[dim];
+    bins[dim] = n_max - n_min[dim] + 2;
+    if (shift_per_ppm[dim] == 0.0) {
+      pad[dim] = 0;
+      ext[dim] = count[dim];
+      bins[dim] = 1;
+    }
+  }
+}
+
+// Calculate the spectrum of an isotropic shift distribution of single-site spin systems.
+static void __simulate_isotropic_distribution(
+    MRS_simulation_plan *plan,   // The simulation plan.
+    __worker_state *state,       // The worker state of the calling thread.
+    double *spec,                // Pointer to the spectrum array (complex).
+    int *members,                // The indexes of the spin systems of the group.
+    int n_members,               // The number of spin systems in the group.
+    site_struct *sites,          // Array of sites structs, one per spin system.
+    coupling_struct *couplings,  // Array of coupling structs, one per spin system.
+    float *transition_pathways,          // The transition pathways of the group.
+    double *transition_pathway_weights,  // The complex pathway weights of the group.
+    int n_pathways,                      // The number of transition pathways.
+    int increment,                       // Length of one transition pathway.
+    double *scale  // Scaling factor (abundance) per spin system.
+) {
+  int i, j, m, p, dim, n_dimension = plan->n_dimension;
+  int count[2] = {1, 1}, ext[2], pad[2], n_min[2], n[2], bins[2];
+  size_t template_size = 0, histogram_size = 0;
+  double iso_ref, iso_min, iso_max, w, f[2], shift_per_ppm[2] = {0.0, 0.0};
+  double *template = NULL, *histogram = NULL, *iso_shift = malloc_double(n_members);
+  site_struct site = sites[members[0]];
+  coupling_struct *coupling = &couplings[members[0]];
+  MRS_dimension *dimensions = state->dimensions;
+  MRS_spatial_basis *basis;
+
+  if (iso_shift == NULL) goto fallback;
+
+  // The lineshape is evaluated at the center of the distribution.
+  iso_min = iso_max = site.isotropic_chemical_shift_in_ppm[0];
+  for (m = 0; m < n_members; m++) {
+    iso_shift[m] = sites[members[m]].isotropic_chemical_shift_in_ppm[0];
+    if (iso_shift[m] < iso_min) iso_min = iso_shift[m];
+    if (iso_shift[m] > iso_max) iso_max = iso_shift[m];
+  }
+  iso_ref = 0.5 * (iso_min + iso_max);
+  site.isotropic_chemical_shift_in_ppm = &iso_ref;
+  for (dim = 0; dim < n_dimension; dim++) count[dim] = dimensions[dim].count;
+
+  // The template and the histogram are sized for the largest pathway of the group.
+  for (p = 0; p < n_pathways; p++) {
+    __isotropic_shift_per_ppm(&site, &transition_pathways[increment * p], n_dimension,
+                              dimensions, plan->freq_contrib, plan->affine_matrix,
+                              shift_per_ppm);
+    __isotropic_distribution_extent(n_members, iso_shift, iso_ref, shift_per_ppm,
+                                    count, n_min, pad, ext, bins);
+    if (2 * (size_t)ext[0] * ext[1] > template_size) {
+      template_size = 2 * (size_t)ext[0] * ext[1];
+    }
+    if ((size_t)bins[0] * bins[1] > histogram_size) {
+      histogram_size = (size_t)bins[0] * bins[1];
+    }
+  }
+  template = malloc_double(template_size);
+  histogram = malloc_double(histogram_size);
+  if (template == NULL || histogram == NULL) goto fallback;
+
+  basis = __prepare_spatial_basis(plan, state, &site, coupling, n_pathways);
+
+  for (p = 0; p < n_pathways; p++) {
+    __isotropic_shift_per_ppm(&site, &transition_pathways[increment * p], n_dimension,
+                              dimensions, plan->freq_contrib, plan->affine_matrix,
+                              shift_per_ppm);
+    __isotropic_distribution_extent(n_members, iso_shift, iso_ref, shift_per_ppm,
+                                    count, n_min, pad, ext, bins);
+
+    // Abundance weighted histogram of the shifts, split between the nearest bins.
+    vm_double_zeros(bins[0] * bins[1], histogram);
+    for (m = 0; m < n_members; m++) {
+      for (dim = 0; dim < 2; dim++) {
+        w = shift_per_ppm[dim] * (iso_shift[m] - iso_ref);
+        n[dim] = (int)floor(w);
+        f[dim] = w - n[dim];
+        n[dim] -= n_min[dim];
+      }
+      w = scale[members[m]];
+      histogram[n[0] * bins[1] + n[1]] += w * (1.0 - f[0]) * (1.0 - f[1]);
+      if (f[0] != 0.0) histogram[(n[0] + 1) * bins[1] + n[1]] += w * f[0] * (1.0 - f[1]);
+      if (f[1] != 0.0) histogram[n[0] * bins[1] + n[1] + 1] += w * (1.0 - f[0]) * f[1];
+      if (f[0] != 0.0 && f[1] != 0.0) {
+        histogram[(n[0] + 1) * bins[1] + n[1] + 1] += w * f[0] * f[1];
+      }
+    }
+
+    // Bin the lineshape over the extended grid.
+    for (dim = 0; dim < n_dimension; dim++) {
+      dimensions[dim].count = ext[dim];
+      dimensions[dim].normalize_offset += pad[dim];
+    }
+    vm_double_zeros(2 * ext[0] * ext[1], template);
+    __evaluate_pathway_frequencies(&site, coupling, &transition_pathways[increment * p],
+                                   n_dimension, dimensions, state->fftw_scheme,
+                                   plan->scheme, basis, plan->freq_contrib);
+    __average_pathway(template, transition_pathway_weights[2 * p],
+                      transition_pathway_weights[2 * p + 1], n_dimension, dimensions,
+                      plan->scheme, state->workspace, plan->iso_intrp,
+                      plan->affine_matrix);
+    for (dim = 0; dim < n_dimension; dim++) {
+      dimensions[dim].count = count[dim];
+      dimensions[dim].normalize_offset -= pad[dim];
+    }
+
+    // Add the shifted lineshape for every nonzero bin of the histogram.
+    for (n[0] = 0; n[0] < bins[0]; n[0]++) {
+      for (n[1] = 0; n[1] < bins[1]; n[1]++) {
+        w = histogram[n[0] * bins[1] + n[1]];
+        if (w == 0.0) continue;
+        i = pad[0] - n[0] - n_min[0];
+        j = pad[1] - n[1] - n_min[1];
+        if (ext[1] == count[1]) {
+          cblas_daxpy(2 * count[0] * count[1], w, &template[2 * i * ext[1]], 1, spec, 1);
+          continue;
+        }
+        for (m = 0; m < count[0]; m++) {
+          cblas_daxpy(2 * count[1], w, &template[2 * ((i + m) * ext[1] + j)], 1,
+                      &spec[2 * m * count[1]], 1);
+        }
+      }
+    }
+  }
+  free(template);
+  free(histogram);
+  free(iso_shift);
+  return;
+
+fallback:
+  // Without the buffers, the spin systems are simulated one at a time.
+  free(template);
+  free(histogram);
+  free(iso_shift);
+  for (m = 0; m < n_members; m++) {
+    __simulate_spin_system(plan, state, spec, &sites[members[m]],
+                           &couplings[members[m]], transition_pathways,
+                           transition_pathway_weights, n_pathways, increment,
+                           scale[members[m]]);
+  }
+}
+
+void MRS_set_simulation_plan_isotropic_convolution(MRS_simulation_plan *plan,
+                                                   bool enable) {
+  plan->isotropic_convolution = enable;
+}
+
+void MRS_set_simulation_plan_amplitude_threshold(MRS_simulation_plan *plan,
+                                                 double threshold) {
+  int i, dim;
+  for (i = 0; i < plan->n_threads; i++) {
+    for (dim = 0; dim < plan->n_dimension; dim++) {
+      plan->states[i].dimensions[dim].amplitude_threshold = threshold;
+    }
+  }
+}
+
+/* Create a simulation plan for the given method and powder averaging parameters. */
+MRS_simulation_plan *MRS_create_simulation_plan(
+    int n_points, int n_dimension, int *count, double *coordinates_offset,
+    double *increment, double *fractions, double *magnetic_flux_density_in_T,
+    double *rotor_frequency_in_Hz, double *rotor_angle_in_rad, int *n_events,
+    unsigned int *number_of_sidebands, unsigned int integration_density,
+    unsigned int integration_volume, unsigned int n_gamma, bool allow_4th_rank,
+    bool interpolation, unsigned int iso_intrp, bool *freq_contrib,
+    double *affine_matrix, int n_threads) {
+  int i, total_events = 0;
+  MRS_simulation_plan *plan = malloc(sizeof(MRS_simulation_plan));
+
+  if (n_threads < 1) n_threads = 1;
+  for (i = 0; i < n_dimension; i++) total_events += n_events[i];
+
+  plan->n_points = n_points;
+  plan->n_dimension = n_dimension;
+  plan->n_threads = n_threads;
+  plan->interpolation = interpolation;
+  plan->iso_intrp = iso_intrp;
+  plan->isotropic_convolution = false;
+
+  plan->freq_contrib = malloc(FREQ_CONTRIB_INCREMENT * total_events * sizeof(bool));
+  memcpy(plan->freq_contrib, freq_contrib,
+         FREQ_CONTRIB_INCREMENT * total_events * sizeof(bool));
+  for (i = 0; i < 4; i++) plan->affine_matrix[i] = affine_matrix[i];
+
+  // The orientation tables are read-only and shared between all threads.
+  plan->scheme = MRS_acquire_orientation_tables(integration_density, allow_4th_rank,
+                                                n_gamma, integration_volume);
+
+  plan->states = malloc(n_threads * sizeof(__worker_state));
+  for (i = 0; i < n_threads; i++) {
+    __create_worker_state(&plan->states[i], n_points, plan->scheme, n_dimension, count,
+                          coordinates_offset, increment, fractions,
+                          magnetic_flux_density_in_T, rotor_frequency_in_Hz,
+                          rotor_angle_in_rad, n_events, number_of_sidebands);
+  }
+  return plan;
+}
+
+void MRS_free_simulation_plan(MRS_simulation_plan *plan) {
+  int i;
+  for (i = 0; i < plan->n_threads; i++) {
+    __free_worker_state(&plan->states[i], plan->n_dimension);
+  }
+  MRS_release_orientation_tables(plan->scheme);
+  free(plan->states);
+  free(plan->freq_contrib);
+  free(plan);
+}
+
+/**
+ * A unit of work of the threaded spin system loop, the transition pathways `first` to
+ * `first + count - 1` of the spin system group `group`. When there are fewer groups
+ * than threads, the pathways of a spin system are split between several work items,
+ * because the spectrum of a spin system is the sum of the spectra of its pathways.
+ */
+typedef struct {
+  int group;
+  int first;
+  int count;
+} __work_item;
+
+// Split the spin system groups into work items, skipping the spin systems without
+// pathways. Returns the number of work items.
+static int __create_work_items(int n_groups, int n_threads, int *order, int *start,
+                               int *pathway_count, __work_item *items) {
+  int g, sys, i, n_chunks, chunk, n_items = 0;
+  int chunks_per_group = (n_threads + n_groups - 1) / n_groups;
+
+  for (g = 0; g < n_groups; g++) {
+    sys = (order == NULL) ? g : order[start[g]];
+    n_chunks = 1;
+
+    // The isotropic shift distributions are simulated as one lineshape.
+    if (order == NULL || start[g + 1] - start[g] == 1) n_chunks = chunks_per_group;
+    if (n_chunks > pathway_count[sys]) n_chunks = pathway_count[sys];
+    if (n_chunks < 1) n_chunks = 1;
+
+    chunk = (pathway_count[sys] + n_chunks - 1) / n_chunks;
+    for (i = 0; i < pathway_count[sys]; i += chunk) {
+      items[n_items].group = g;
+      items[n_items].first = i;
+      items[n_items].count = (pathway_count[sys] - i < chunk) ? pathway_count[sys] - i
+                                                               : chunk;
+      n_items++;
+    }
+  }
+  return n_items;
+}
+
+// Calculate spectra from a list of spin systems using a simulation plan.
+void MRS_run_simulation_plan(
+    MRS_simulation_plan *plan,  // The simulation plan.
+    double *spec,               // Pointer to the spectrum array (complex).
+    bool decompose_spectrum,    // If true, write one spectrum per spin system.
+    int n_spin_systems,         // The number of spin systems.
+    site_struct *sites,         // Array of sites structs, one per spin system.
+    coupling_struct *couplings,  // Array of coupling structs, one per spin system.
+    float **transition_pathways,          // Transition pathways per spin system.
+    double **transition_pathway_weights,  // Pathway weights per spin system.
+    int *pathway_count,                   // Number of pathways per spin system.
+    int *pathway_increment,  // Length of one transition pathway per spin system.
+    double *scale            // Scaling factor (abundance) per spin system.
+) {
+  int n_groups = n_spin_systems, n_items, *order = NULL, *start = NULL;
+  int n_threads = plan->n_threads;
+  __work_item *items;
+
+  // Group the isotropic shift distributions, simulated with a single lineshape.
+  if (plan->isotropic_convolution && !decompose_spectrum && n_spin_systems > 1) {
+    order = malloc(n_spin_systems * sizeof(int));
+    start = malloc((n_spin_systems + 1) * sizeof(int));
+    if (order != NULL && start != NULL) {
+      n_groups = __group_isotropic_distributions(
+          n_spin_systems, sites, couplings, transition_pathways,
+          transition_pathway_weights, pathway_count, pathway_increment, order, start);
+    }
+    // Without the grouping, the spin systems are simulated one at a time.
+    if (order == NULL || start == NULL || n_groups < 0) {
+      free(order);
+      free(start);
+      order = start = NULL;
+      n_groups = n_spin_systems;
+    }
+  }
+
+  if (n_groups < 1) return;
+
+  // With fewer groups than threads, the pathways are split between the threads.
+  items = malloc(n_groups * ((n_threads + n_groups - 1) / n_groups) *
+                 sizeof(__work_item));
+  n_items = __create_work_items(n_groups, (n_threads > n_groups) ? n_threads : 1,
+                                order, start, pathway_count, items);
+
+  if (n_threads > n_items) n_threads = n_items;
+  if (n_threads < 1) {
+    free(items);
+    return;
+  }
+
+#pragma omp parallel num_threads(n_threads) if (n_threads > 1)
+  {
+    int i, g, sys, first, size = 2 * plan->n_points;
+    bool tile;
+    double *amp;
+    __worker_state *state = &plan->states[__thread_id()];
+
+    // A single thread accumulates straight into the output spectrum. The spin systems
+    // are accumulated in place, hence the private spectra are zeroed and reduced over
+    // their full size once per thread, and once per split spin system when decomposed,
+    // instead of once per spin system, without tracking the bins written.
+    double *thread_spec = (n_threads > 1) ? state->spec : spec;
+    if (n_threads > 1) vm_double_zeros(size, state->spec);
+
+#pragma omp for schedule(dynamic)
+    for (i = 0; i < n_items; i++) {
+      g = items[i].group;
+      first = items[i].first;
+      sys = (order == NULL) ? g : order[start[g]];
+
+      // In decompose mode, every spin system owns a slice of the output array.
+      // Otherwise, the scaled amplitudes of all spin systems are accumulated into the
+      // same spectrum. A spin system split between threads is simulated into the
+      // private tile of the thread, and then added to its slice.
+      tile = decompose_spectrum && items[i].count != pathway_count[sys];
+      amp = (decompose_spectrum) ? spec + (size_t)sys * size : thread_spec;
+      if (tile) {
+        amp = state->spec;
+        vm_double_zeros(size, amp);
+      }
+
+      if (order != NULL && start[g + 1] - start[g] > 1) {
+        __simulate_isotropic_distribution(
+            plan, state, amp, &order[start[g]], start[g + 1] - start[g], sites,
+            couplings, transition_pathways[sys], transition_pathway_weights[sys],
+            pathway_count[sys], pathway_increment[sys], scale);
+        continue;
+      }
+
+      __simulate_spin_system(
+          plan, state, amp, &sites[sys], &couplings[sys],
+          &transition_pathways[sys][(size_t)pathway_increment[sys] * first],
+          &transition_pathway_weights[sys][2 * first], items[i].count,
+          pathway_increment[sys], scale[sys]);
+
+      if (tile) {
+#pragma omp critical(mrs_spectrum_reduction)
+        cblas_daxpy(size, 1.0, amp, 1, spec + (size_t)sys * size, 1);
+      }
+    }
+
+    // Reduce the thread-local spectrum.
+    if (!decompose_spectrum && n_threads > 1) {
+#pragma omp critical(mrs_spectrum_reduction)
+      cblas_daxpy(size, 1.0, state->spec, 1, spec, 1);
+    }
+  }
+  free(items);
+  free(order);
+  free(start);
+}
+
+// Calculate spectra from single-site spin systems given as structure of arrays.
+void MRS_run_simulation_plan_single_site(
+    MRS_simulation_plan *plan,  // The simulation plan.
+    double *spec,               // Pointer to the spectrum array (complex).
+    bool decompose_spectrum,    // If true, write one spectrum per spin system.
+    int n_spin_systems,         // The number of single-site spin systems.
+    float spin,                 // The spin quantum number of the sites.
+    double gyromagnetic_ratio,  // The gyromagnetic ratio of the sites.
+    double *isotropic_chemical_shift_in_ppm,  // Isotropic chemical shift per site.
+    double *shielding_symmetric_zeta_in_ppm,  // Shielding anisotropy per site.
+    double *shielding_symmetric_eta,          // Shielding asymmetry per site.
+    double *shielding_orientation,            // Shielding Euler angles, 3 per site.
+    double *quadrupolar_Cq_in_Hz,             // Quadrupolar coupling per site.
+    double *quadrupolar_eta,                  // Quadrupolar asymmetry per site.
+    double *quadrupolar_orientation,          // Quadrupolar Euler angles, 3 per site.
+    float *transition_pathway,          // Transition pathways shared by all sites.
+    double *transition_pathway_weight,  // Pathway weights shared by all sites.
+    int pathway_count,                  // Number of transition pathways.
+    int pathway_increment,              // Length of one transition pathway.
+    double *scale                       // Scaling factor (abundance) per spin system.
+) {
+  int i;
+  site_struct *sites = malloc(n_spin_systems * sizeof(site_struct));
+  coupling_struct *couplings = calloc(n_spin_systems, sizeof(coupling_struct));
+  float **pathways = malloc(n_spin_systems * sizeof(float *));
+  double **weights = malloc(n_spin_systems * sizeof(double *));
+  int *counts = malloc(n_spin_systems * sizeof(int));
+  int *increments = malloc(n_spin_systems * sizeof(int));
+
+  // The site structs are views into the arrays, no data is copied.
+  for (i = 0; i < n_spin_systems; i++) {
+    sites[i].number_of_sites = 1;
+    sites[i].spin = &spin;
+    sites[i].gyromagnetic_ratio = &gyromagnetic_ratio;
+    sites[i].isotropic_chemical_shift_in_ppm = &isotropic_chemical_shift_in_ppm[i];
+    sites[i].shielding_symmetric_zeta_in_ppm = &shielding_symmetric_zeta_in_ppm[i];
+    sites[i].shielding_symmetric_eta = &shielding_symmetric_eta[i];
+    sites[i].shielding_orientation = &shielding_orientation[3 * i];
+    sites[i].quadrupolar_Cq_in_Hz = &quadrupolar_Cq_in_Hz[i];
+    sites[i].quadrupolar_eta = &quadrupolar_eta[i];
+    sites[i].quadrupolar_orientation = &quadrupolar_orientation[3 * i];
+    pathways[i] = transition_pathway;
+    weights[i] = transition_pathway_weight;
+    counts[i] = pathway_count;
+    increments[i] = pathway_increment;
+  }
+
+  MRS_run_simulation_plan(plan, spec, decompose_spectrum, n_spin_systems, sites,
+                          couplings, pathways, weights, counts, increments, scale);
+
+  free(sites);
+  free(couplings);
+  free(pathways);
+  free(weights);
+  free(counts);
+  free(increments);
+}
+
+// Calculate spectra from a list of spin systems over all transition pathways.
+void mrsimulator_core_batch(
+    // spectrum information and related amplitude
+    double *spec,             // Pointer to the spectrum array (complex).
+    int n_points,             // Total number of points of a single spectrum.
+    bool decompose_spectrum,  // If true, write one spectrum per spin system.
+
+    // spin systems
+    int n_spin_systems,          // The number of spin systems.
+    site_struct *sites,          // Array of sites structs, one per spin system.
+    coupling_struct *couplings,  // Array of coupling structs, one per spin system.
+    float **transition_pathways,          // Transition pathways per spin system.
+    double **transition_pathway_weights,  // Pathway weights per spin system.
+    int *pathway_count,                   // Number of pathways per spin system.
+    int *pathway_increment,  // Length of one transition pathway per spin system.
+    double *scale,           // Scaling factor (abundance) per spin system.
+
+    // method
+    int n_dimension, int *count, double *coordinates_offset, double *increment,
+    double *fractions, double *magnetic_flux_density_in_T,
+    double *rotor_frequency_in_Hz, double *rotor_angle_in_rad, int *n_events,
+    unsigned int *number_of_sidebands,
+
+    // powder orientation average
+    unsigned int integration_density,  // The number of triangle along the edge.
+    unsigned int integration_volume,   // 0-octant, 1-hemisphere, 2-sphere.
+    unsigned int n_gamma,              // The number of gamma angles.
+    bool allow_4th_rank,               // If true, evaluate the fourth-rank tensors.
+    bool interpolation, unsigned int iso_intrp, bool *freq_contrib,
+    double *affine_matrix,
+    int n_threads  // The number of threads.
+) {
+  // The work items, and so the threads used, are sized by MRS_run_simulation_plan.
+  if (n_threads < 1) n_threads = 1;
+  if (n_spin_systems < 1) return;
+
+  MRS_simulation_plan *plan = MRS_create_simulation_plan(
+      n_points, n_dimension, count, coordinates_offset, increment, fractions,
+      magnetic_flux_density_in_T, rotor_frequency_in_Hz, rotor_angle_in_rad, n_events,
+      number_of_sidebands, integration_density, integration_volume, n_gamma,
+      allow_4th_rank, interpolation, iso_intrp, freq_contrib, affine_matrix, n_threads);
+
+  MRS_run_simulation_plan(plan, spec, decompose_spectrum, n_spin_systems, sites,
+                          couplings, transition_pathways, transition_pathway_weights,
+                          pathway_count, pathway_increment, scale);
+
+  MRS_free_simulation_plan(plan);
+}
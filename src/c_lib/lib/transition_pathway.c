@@ -0,0 +1,69 @@
+// -*- coding: utf-8 -*-
+//
+//  transition_pathway.c
+//
+//  @copyright Deepansh J. Srivastava, 2019-2021.
+//  Created by Deepansh J. Srivastava, Oct 16, 2026.
+//  Contact email = srivastava.89@osu.edu
+//
+
+#include "transition_pathway.h"
+
+#include "angular_momentum/wigner_element.h"
+
+void MRS_transition_pathways(const unsigned int n_events, const unsigned int *counts,
+                             const float *segments, const unsigned int n_sites,
+                             float *restrict pathways) {
+  const unsigned int size = 2 * n_sites;
+  unsigned int *index, *offset, i, j;
+  unsigned long p, n_pathways = 1;
+
+  for (i = 0; i < n_events; i++) n_pathways *= counts[i];
+  if (n_pathways == 0) return;
+
+  index = calloc(n_events, sizeof(unsigned int));
+  offset = malloc(n_events * sizeof(unsigned int));
+  for (i = 0, j = 0; i < n_events; j += counts[i++]) offset[i] = j;
+
+  for (p = 0; p < n_pathways; p++) {
+    for (i = 0; i < n_events; i++) {
+      memcpy(pathways, &segments[(offset[i] + index[i]) * size], size * sizeof(float));
+      pathways += size;
+    }
+    // advance the transition indexes, last event first.
+    for (i = n_events; i-- > 0;) {
+      if (++index[i] < counts[i]) break;
+      index[i] = 0;
+    }
+  }
+  free(index);
+  free(offset);
+}
+
+void MRS_transition_pathway_weights(const unsigned int n_pathways,
+                                    const unsigned int n_events,
+                                    const unsigned int n_sites, const float *pathways,
+                                    const float *spins, const unsigned int event_1,
+                                    const unsigned int event_2, const double *alpha,
+                                    const double *beta, const double *gamma,
+                                    double *restrict weights) {
+  const unsigned int size = 2 * n_sites, stride = n_events * size;
+  const float *trans1, *trans2;
+  double factor[2], re;
+  unsigned int p, i;
+
+  for (i = 0; i < n_sites; i++) {
+    trans1 = &pathways[event_1 * size + i];
+    trans2 = &pathways[event_2 * size + i];
+    for (p = 0; p < n_pathways; p++) {
+      // the transitions are |m_f >< m_i|, where m_i = trans[0] and m_f = trans[n_sites]
+      transition_connect_factor(spins[i], trans1[n_sites], trans1[0], trans2[n_sites],
+                                trans2[0], alpha[i], beta[i], gamma[i], factor);
+      re = weights[2 * p] * factor[0] - weights[2 * p + 1] * factor[1];
+      weights[2 * p + 1] = weights[2 * p] * factor[1] + weights[2 * p + 1] * factor[0];
+      weights[2 * p] = re;
+      trans1 += stride;
+      trans2 += stride;
+    }
+  }
+}
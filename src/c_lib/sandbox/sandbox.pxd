@@ -10,23 +10,23 @@
 from libcpp cimport bool as bool_t
 
 cdef extern from "schemes.h":
-    ctypedef struct MRS_averaging_scheme:
+    ctypedef struct MRS_orientation_tables:
         unsigned int total_orientations
         unsigned int integration_density
         unsigned int integration_volume
 
-    MRS_averaging_scheme * MRS_create_averaging_scheme(
+    MRS_orientation_tables * MRS_create_orientation_tables(
                             unsigned int integration_density,
                             bool_t allow_4th_rank,
                             unsigned int n_gamma,
                             unsigned int integration_volume)
 
-    MRS_averaging_scheme *MRS_create_averaging_scheme_from_alpha_beta(
+    MRS_orientation_tables *MRS_create_orientation_tables_from_alpha_beta(
                             double *alpha, double *beta,
                             double *weight, unsigned int n_angles,
                             bool_t allow_4th_rank)
 
-    void MRS_free_averaging_scheme(MRS_averaging_scheme *scheme)
+    void MRS_free_orientation_tables(MRS_orientation_tables *scheme)
 
 cdef extern from "mrsimulator.h":
 
@@ -35,7 +35,7 @@ cdef extern from "mrsimulator.h":
         double rotor_frequency_in_Hz
         double rotor_angle_in_rad
 
-    MRS_plan *MRS_create_plan(MRS_averaging_scheme *scheme, unsigned int number_of_sidebands,
+    MRS_plan *MRS_create_plan(MRS_orientation_tables *scheme, unsigned int number_of_sidebands,
                           double rotor_frequency_in_Hz,
                           double rotor_angle_in_rad, double increment,
                           bool_t allow_4th_rank)
@@ -13,7 +13,7 @@ __integration_volume_enum_rev__ = {0: "octant", 1: "hemisphere"}
 
 
 # cdef class UserDefinedAveragingScheme:
-#     cdef clib.MRS_averaging_scheme *scheme
+#     cdef clib.MRS_orientation_tables *scheme
 
 #     def __init__(
 #             self,
@@ -28,7 +28,7 @@ __integration_volume_enum_rev__ = {0: "octant", 1: "hemisphere"}
 #                 'The length of alpha, beta, and weight array must be equal.'
 #             )
 #         cdef int n_angles = alpha.size
-#         self.scheme = clib.MRS_create_averaging_scheme_from_alpha_beta(&alpha[0],
+#         self.scheme = clib.MRS_create_orientation_tables_from_alpha_beta(&alpha[0],
 #                                             &beta[0], &weight[0], n_angles,
 #                                             allow_4th_rank_)
 #     @property
@@ -62,11 +62,11 @@ __integration_volume_enum_rev__ = {0: "octant", 1: "hemisphere"}
 #         ).format(self.total_orientations, self.interpolation)
 
 #     # def __del__(self):
-#     #     clib.MRS_free_averaging_scheme(self.scheme)
+#     #     clib.MRS_free_orientation_tables(self.scheme)
 
 
 cdef class AveragingScheme:
-    cdef clib.MRS_averaging_scheme *scheme
+    cdef clib.MRS_orientation_tables *scheme
     cdef bool_t allow_4th_rank
 
     def __init__(self, int integration_density, integration_volume='octant', bool_t allow_4th_rank=False):
@@ -81,7 +81,7 @@ cdef class AveragingScheme:
         integration_volume_ = 0
         if integration_volume == 'hemisphere':
             integration_volume_=1
-        self.scheme = clib.MRS_create_averaging_scheme(integration_density,
+        self.scheme = clib.MRS_create_orientation_tables(integration_density,
                                     allow_4th_rank, 9, integration_volume_)
 
     @property
@@ -101,7 +101,7 @@ cdef class AveragingScheme:
     def integration_density(self, value):
         if isinstance(value, int):
             if value > 0:
-                self.scheme = clib.MRS_create_averaging_scheme(value,
+                self.scheme = clib.MRS_create_orientation_tables(value,
                                 self.allow_4th_rank, 9,
                                 self.scheme.integration_volume)
                 return
@@ -116,7 +116,7 @@ cdef class AveragingScheme:
     def integration_volume(self, value):
         if value in __integration_volume_enum__.keys():
             self.scheme.integration_volume = __integration_volume_enum__[value]
-            self.scheme = clib.MRS_create_averaging_scheme(
+            self.scheme = clib.MRS_create_orientation_tables(
                     self.scheme.integration_density, 9,
                     self.allow_4th_rank, value
                 )
@@ -156,7 +156,7 @@ cdef class AveragingScheme:
         )
 
     def __del__(self):
-        clib.MRS_free_averaging_scheme(self.scheme)
+        clib.MRS_free_orientation_tables(self.scheme)
 
 
 cdef class MRSPlan:
@@ -33,6 +33,21 @@ cdef extern from "angular_momentum/wigner_matrix.h":
     void __wigner_rotation_2(const int l, const int n, const double *wigner,
                             const void *exp_Im_alpha, const void *R_in, void *R_out)
 
+    void wigner_d_matrices_to_symmetric_soa(const int l, const int n,
+                            const double *wigner, double *wigner_soa)
+
+    void __wigner_rotation_soa(const int l, const int n, const double *wigner,
+                            const void *exp_Im_alpha, const void *R_in, void *R_out)
+
+    void wigner_rotation_gemm_matrix(const int l, const int n, const double *wigner,
+                            const void *exp_Im_alpha, double *matrix)
+
+    void __batch_wigner_rotation_gemm(const int l,
+                            const unsigned int octant_orientations,
+                            const unsigned int n_octants, const double *matrix,
+                            const int n_systems, const void *R_in, double *components,
+                            double *R_out)
+
     void single_wigner_rotation(const int l, const double *euler_angles, const void *R_in,
                             void *R_out)
 
@@ -107,6 +122,20 @@ cdef extern from "mrsimulator.h":
         double spin_frequency,
         double *pre_phase)
 
+    void MRS_get_sideband_phase_factors(
+        unsigned int n_orientations,
+        unsigned int n_sidebands,
+        const double complex *w2,
+        const double complex *pre_phase_2,
+        const double complex *w4,
+        const double complex *pre_phase_4,
+        void *vector)
+
+    void MRS_get_sideband_amplitudes_direct(
+        unsigned int n_orientations,
+        unsigned int n_sidebands,
+        void *vector)
+
 #     ctypedef struct MRS_plan
 
 #     MRS_plan *MRS_create_plan(
@@ -145,7 +174,7 @@ cdef extern from "method.h":
         unsigned int n_events           # The number of events.
 
     # MRS_dimension *MRS_create_dimensions(
-    #     MRS_averaging_scheme *scheme,
+    #     MRS_orientation_tables *scheme,
     #     int count,
     #     double coordinates_offset,
     #     double increment,
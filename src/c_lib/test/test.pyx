@@ -108,6 +108,88 @@ def __wigner_rotation_2(int l, np.ndarray[double] cos_alpha,
     return R_out.reshape(n, (l + 1))
 
 
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def wigner_d_matrices_to_symmetric_soa(int l, np.ndarray[double] wigner):
+    cdef int n = wigner.size // ((2 * l + 1) * (l + 1))
+    cdef np.ndarray[double] wigner_soa = np.empty(wigner.size, dtype=np.float64)
+    clib.wigner_d_matrices_to_symmetric_soa(l, n, &wigner[0], &wigner_soa[0])
+    return wigner_soa
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def wigner_rotation_tables(int l, np.ndarray[double] cos_alpha,
+                           np.ndarray[double] cos_beta):
+    """Return the half wigner-d matrices, their symmetric structure-of-arrays form, and
+    the exp(-im alpha) table at the given orientations."""
+    cdef int n1 = 2 * l + 1
+    cdef int n = cos_alpha.size
+    cdef np.ndarray[double, ndim=1] wigner
+    cdef np.ndarray[double complex, ndim=1] exp_I_beta
+    wigner = np.empty(n1 * (l+1) * n, dtype=np.float64)
+    sin_beta = np.sqrt(1 - cos_beta**2)
+    exp_I_beta = np.asarray(cos_beta + 1j*sin_beta, dtype=np.complex128)
+    clib.wigner_d_matrices_from_exp_I_beta(l, n, True, &exp_I_beta[0], &wigner[0])
+
+    cdef np.ndarray[double complex] exp_im_alpha
+    exp_im_alpha = np.empty(4 * n, dtype=np.complex128)
+    exp_im_alpha[3*n:] = cos_alpha + 1j*np.sqrt(1.0 - cos_alpha**2)
+    clib.get_exp_Im_alpha(n, 1, &exp_im_alpha[0])
+    return wigner, wigner_d_matrices_to_symmetric_soa(l, wigner), exp_im_alpha
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def wigner_rotation_kernel(int l, np.ndarray[double] wigner,
+                           np.ndarray[double complex] exp_im_alpha,
+                           np.ndarray[double complex] R_in,
+                           np.ndarray[double complex] R_out,
+                           bool_t soa=True):
+    """Rotate R_in over all orientations using the tables from wigner_rotation_tables.
+    When soa is True, `wigner` is the symmetric structure-of-arrays form, otherwise the
+    half wigner-d matrices."""
+    cdef int n = exp_im_alpha.size // 4
+    if soa:
+        clib.__wigner_rotation_soa(l, n, &wigner[0], &exp_im_alpha[0], &R_in[0],
+                                   &R_out[0])
+    else:
+        clib.__wigner_rotation_2(l, n, &wigner[0], &exp_im_alpha[0], &R_in[0],
+                                 &R_out[0])
+    return R_out
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def wigner_rotation_gemm_matrix(int l, np.ndarray[double] wigner_soa,
+                                np.ndarray[double complex] exp_im_alpha):
+    """Return the `2(l+1)n x (2l+2)` matrix for the batched rotation of many tensors
+    from the tables of wigner_rotation_tables."""
+    cdef int n = exp_im_alpha.size // 4
+    cdef np.ndarray[double] matrix = np.empty(4 * (l + 1)**2 * n, dtype=np.float64)
+    clib.wigner_rotation_gemm_matrix(l, n, &wigner_soa[0], &exp_im_alpha[0],
+                                     &matrix[0])
+    return matrix
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def wigner_rotation_gemm_kernel(int l, np.ndarray[double] matrix,
+                                np.ndarray[double complex, ndim=2] R_in,
+                                np.ndarray[double] R_out,
+                                unsigned int n_octants=1):
+    """Rotate the `n_systems x (2l+1)` stacked tensors R_in over the orientations of
+    `n_octants` octants. R_out is the `n_octants x 2 x (l+1) x n x n_systems` array of
+    the real and imaginary parts of the rotated components."""
+    cdef int n_systems = R_in.shape[0]
+    cdef unsigned int n = matrix.size // (4 * (l + 1)**2)
+    cdef np.ndarray[double complex, ndim=1] R_in_c = np.ascontiguousarray(R_in).ravel()
+    cdef np.ndarray[double] components = np.empty((2 * l + 2) * n_systems)
+    clib.__batch_wigner_rotation_gemm(l, n, n_octants, &matrix[0], n_systems,
+                                      &R_in_c[0], &components[0], &R_out[0])
+    return R_out
+
+
 @cython.boundscheck(False)
 @cython.wraparound(False)
 def get_exp_Im_alpha(int n, np.ndarray[double] cos_alpha, bool_t allow_4th_rank):
@@ -127,6 +209,48 @@ def pre_phase_components(unsigned int number_of_sidebands, double rotor_frequenc
     return pre_phase.view(dtype=np.complex128).reshape(4, number_of_sidebands)
 
 
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def sideband_phase_factors(np.ndarray[double complex, ndim=2] w2,
+                           np.ndarray[double complex, ndim=2] pre_phase_2,
+                           w4=None, pre_phase_4=None):
+    """Evaluate exp(I sum_m Im(w[i, m] pre_phase[m, j])) over m = [-2, -1] of the
+    `n x 3` array w2 and the `2 x n_sidebands` array pre_phase_2, and optionally, over
+    m = [-4, ..., -1] of the `n x 5` array w4 and `4 x n_sidebands` array pre_phase_4.
+    Returns a `n_sidebands x n` array."""
+    cdef unsigned int n = w2.shape[0]
+    cdef unsigned int n_sidebands = pre_phase_2.shape[1]
+    cdef np.ndarray[double complex, ndim=1] w2_c = np.ascontiguousarray(w2).ravel()
+    cdef np.ndarray[double complex, ndim=1] p2_c = np.ascontiguousarray(pre_phase_2).ravel()
+    cdef np.ndarray[double complex, ndim=1] w4_c
+    cdef np.ndarray[double complex, ndim=1] p4_c
+    cdef double complex *w4_ptr = NULL
+    cdef double complex *p4_ptr = NULL
+    if w4 is not None:
+        w4_c = np.ascontiguousarray(w4, dtype=np.complex128).ravel()
+        p4_c = np.ascontiguousarray(pre_phase_4, dtype=np.complex128).ravel()
+        w4_ptr = &w4_c[0]
+        p4_ptr = &p4_c[0]
+
+    cdef np.ndarray[double complex, ndim=1] vector = np.empty(n * n_sidebands, dtype=np.complex128)
+    clib.MRS_get_sideband_phase_factors(n, n_sidebands, &w2_c[0], &p2_c[0], w4_ptr,
+                                        p4_ptr, &vector[0])
+    return vector.reshape(n_sidebands, n)
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def sideband_amplitudes_direct(np.ndarray[double complex, ndim=2] factors):
+    """Evaluate |fft(factors, axis=0)|^2 of the `n_sidebands x n` array of sideband
+    phase factors with the direct DFT kernel. Returns a `n_sidebands x n` array."""
+    cdef unsigned int n_sidebands = factors.shape[0]
+    cdef unsigned int n = factors.shape[1]
+    cdef np.ndarray[double complex, ndim=1] vector = np.ascontiguousarray(
+        factors, dtype=np.complex128).ravel().copy()
+    clib.MRS_get_sideband_amplitudes_direct(n, n_sidebands, &vector[0])
+    return vector.real.reshape(n_sidebands, n)
+
+
 @cython.boundscheck(False)
 @cython.wraparound(False)
 def cosine_of_polar_angles_and_amplitudes(int integration_density=72):
@@ -254,8 +378,18 @@ def __batch_wigner_rotation(unsigned int octant_orientations,
 
     cdef np.ndarray[double complex] w2 = np.empty(3*octant_orientations*n_octants, dtype=np.complex128)
     cdef np.ndarray[double complex] w4 = np.empty(5*octant_orientations*n_octants, dtype=np.complex128)
+
+    # the batch rotation expects the wigner matrices in the symmetric SoA layout.
+    cdef np.ndarray[double] wigner_2j_soa = np.concatenate([
+        wigner_d_matrices_to_symmetric_soa(2, item)
+        for item in np.split(wigner_2j_matrices, wigner_2j_matrices.size // (15*octant_orientations))
+    ])
+    cdef np.ndarray[double] wigner_4j_soa = np.concatenate([
+        wigner_d_matrices_to_symmetric_soa(4, item)
+        for item in np.split(wigner_4j_matrices, wigner_4j_matrices.size // (45*octant_orientations))
+    ])
     clib.__batch_wigner_rotation(octant_orientations, n_octants,
-                            &wigner_2j_matrices[0], &R2[0], &wigner_4j_matrices[0],
+                            &wigner_2j_soa[0], &R2[0], &wigner_4j_soa[0],
                             &R4[0], &exp_Im_alpha[0], &w2[0], &w4[0])
     return w2, w4
 
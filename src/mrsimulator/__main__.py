@@ -15,6 +15,8 @@ def run_benchmark(args):
         n_jobs=int(args.n_jobs),
         interpolation=args.interpolation,
         simulation=args.simulation,
+        rotation=args.rotation,
+        sidebands=args.sidebands,
     )
 
 
@@ -85,6 +87,16 @@ parser.add_argument(
     action="store_true",
     help="run simulation benchmark. Default is False.",
 )
+parser.add_argument(
+    "--rotation",
+    action="store_true",
+    help="run wigner rotation kernel benchmark. Default is False.",
+)
+parser.add_argument(
+    "--sidebands",
+    action="store_true",
+    help="run sideband phase kernel benchmark. Default is False.",
+)
 args = parser.parse_args()
 
 
@@ -278,26 +278,116 @@ def interpolation_benchmark(n):
     ]
 
 
+def rotation_blocks(n, level, n_batch=256):
+    print(f"\nLevel {level} results.")
+    print(
+        "Average computation time for rotating a second and fourth-rank tensor over "
+        "all orientations of an octant."
+    )
+    print(
+        f"Reported value is the time per rotation averaged over {n} rotations. The "
+        "array-of-structures (AoS) kernel is the reference for the vectorized "
+        "structure-of-arrays (SoA) kernel. The GEMM kernel rotates batches of "
+        f"{n_batch} tensors."
+    )
+    terminal_start_setup()
+    for density in [70, 100, 150, 200]:
+        for rank in [2, 4]:
+            tables, R_in, R_out = rotation_benchmark(rank, density)
+            for soa, wigner in zip([False, True], tables[:2]):
+                args = (rank, wigner, tables[2], R_in, R_out, soa)
+                t = timeit.timeit(lambda: clib.wigner_rotation_kernel(*args), number=n)
+                layout = "SoA" if soa else "AoS"
+                des = f"Rank-{rank} rotation, integration density {density} ({layout})"
+                terminal_end_setup(t, n, des)
+
+            # batched rotation of `n_batch` tensors with one GEMM.
+            matrix = clib.wigner_rotation_gemm_matrix(rank, tables[1], tables[2])
+            R_batch = np.tile(R_in, (n_batch, 1))
+            R_batch_out = np.empty(2 * R_out.size * n_batch)
+            args = (rank, matrix, R_batch, R_batch_out)
+            t = timeit.timeit(lambda: clib.wigner_rotation_gemm_kernel(*args), number=n)
+            des = f"Rank-{rank} rotation, integration density {density} (GEMM)"
+            terminal_end_setup(t, n * n_batch, des)
+
+
+def rotation_benchmark(rank, integration_density):
+    n = ((integration_density + 1) * (integration_density + 2)) // 2
+    cos_alpha = 2.0 * np.random.rand(n) - 1.0
+    cos_beta = 2.0 * np.random.rand(n) - 1.0
+    tables = clib.wigner_rotation_tables(rank, cos_alpha, cos_beta)
+    R_in = np.random.rand(2 * rank + 1) + 1j * np.random.rand(2 * rank + 1)
+    R_out = np.empty((rank + 1) * n, dtype=np.complex128)
+    return tables, R_in, R_out
+
+
+def sideband_phase_blocks(n, level):
+    print(f"\nLevel {level} results.")
+    print(
+        "Average computation time for evaluating the sideband phase factors over all "
+        "orientations of a hemisphere."
+    )
+    print(
+        f"Reported value is the time per evaluation averaged over {n} evaluations. The "
+        "BLAS path is a complex matrix product followed by the exponential in numpy."
+    )
+    paths = [("BLAS", blas_sideband_phase), ("kernel", c_sideband_phase)]
+    terminal_start_setup()
+    for density in [70, 100, 150, 200]:
+        for rank_4 in [False, True]:
+            args = sideband_phase_benchmark(density, 32, rank_4)
+            rank = "2 and 4" if rank_4 else "2"
+            for name, fn in paths:
+                t = timeit.timeit(lambda: fn(*args), number=n)
+                des = f"Rank-{rank} phase, integration density {density} ({name})"
+                terminal_end_setup(t, n, des)
+
+
+def blas_sideband_phase(w2, pre_phase_2, w4, pre_phase_4):
+    phase = pre_phase_2.T @ w2[:, :2].T
+    if w4 is not None:
+        phase += pre_phase_4.T @ w4[:, :4].T
+    return np.exp(1j * phase.imag)
+
+
+def c_sideband_phase(w2, pre_phase_2, w4, pre_phase_4):
+    return clib.sideband_phase_factors(w2, pre_phase_2, w4, pre_phase_4)
+
+
+def sideband_phase_benchmark(integration_density, number_of_sidebands, rank_4):
+    n = 4 * ((integration_density + 1) * (integration_density + 2)) // 2
+    w2 = np.random.rand(n, 3) + 1j * np.random.rand(n, 3)
+    pre_phase = clib.pre_phase_components(number_of_sidebands, 1e3)
+    if not rank_4:
+        return w2, pre_phase[2:], None, None
+    w4 = np.random.rand(n, 5) + 1j * np.random.rand(n, 5)
+    return w2, pre_phase[2:], w4, pre_phase
+
+
 class Benchmark:
     @staticmethod
     def prep():
         print(f"Benchmarking using mrsimulator version {__version__}")
 
     @staticmethod
-    def l0(n_jobs, interpolation, simulation):
-        setup(10, 0, n_jobs, interpolation, simulation)
+    def l0(n_jobs, interpolation, simulation, rotation=False, sidebands=False):
+        setup(10, 0, n_jobs, interpolation, simulation, rotation, sidebands)
 
     @staticmethod
-    def l1(n_jobs, interpolation, simulation):
-        setup(2000, 1, n_jobs, interpolation, simulation)
+    def l1(n_jobs, interpolation, simulation, rotation=False, sidebands=False):
+        setup(2000, 1, n_jobs, interpolation, simulation, rotation, sidebands)
 
     @staticmethod
-    def l2(n_jobs, interpolation, simulation):
-        setup(10000, 2, n_jobs, interpolation, simulation)
+    def l2(n_jobs, interpolation, simulation, rotation=False, sidebands=False):
+        setup(10000, 2, n_jobs, interpolation, simulation, rotation, sidebands)
 
 
-def setup(n, level, n_jobs, interpolation, simulation):
+def setup(n, level, n_jobs, interpolation, simulation, rotation=False, sidebands=False):
     if simulation:
         spectrum_blocks(n, level, n_jobs)
     if interpolation:
         interpolation_blocks(n, level)
+    if rotation:
+        rotation_blocks(max(n // 10, 1), level)
+    if sidebands:
+        sideband_phase_blocks(max(n // 100, 1), level)
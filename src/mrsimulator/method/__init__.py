@@ -1,3 +1,5 @@
+import hashlib
+import json
 from copy import deepcopy
 from typing import ClassVar
 from typing import Dict
@@ -9,6 +11,8 @@ import matplotlib as mpl
 import numpy as np
 import pandas as pd
 from mrsimulator.base_model import transition_connect_factor
+from mrsimulator.base_model import transition_pathway_weights
+from mrsimulator.base_model import transition_pathways
 from mrsimulator.spin_system.isotope import Isotope
 from mrsimulator.transition import SymmetryPathway
 from mrsimulator.transition import Transition
@@ -27,7 +31,9 @@ from .utils import cartesian_product
 from .utils import check_for_at_least_one_event
 from .utils import check_for_number_of_spectral_dimensions
 from .utils import check_spectral_dimensions_are_dict
+from .utils import coupled_site_pairs
 from .utils import mixing_query_connect_map
+from .utils import reduce_transition_pathways
 from .utils import to_euler_list
 
 # from .utils import convert_transition_query
@@ -38,6 +44,26 @@ from .utils import to_euler_list
 __author__ = ["Deepansh J. Srivastava", "Matthew D. Giammar"]
 __email__ = ["srivastava.89@osu.edu", "giammar.7@buckeyemail.osu.edu"]
 
+# The transition pathways and weights, keyed by the isotopes of the spin system and a
+# hash of the method channels and events, and by the coupled site pairs for the reduced
+# pathways. The oldest entry is dropped once the cache holds `_PATHWAY_CACHE_SIZE`
+# entries.
+_pathway_cache = {}
+_PATHWAY_CACHE_SIZE = 256
+
+
+def _cache_pathways(key, value):
+    if len(_pathway_cache) >= _PATHWAY_CACHE_SIZE:
+        _pathway_cache.pop(next(iter(_pathway_cache)))
+    _pathway_cache[key] = value
+
+
+def _read_only(*arrays):
+    """Return the arrays flagged as read-only, as shared by the pathway cache."""
+    for array in arrays:
+        array.setflags(write=False)
+    return arrays
+
 
 class Method(Parseable):
     r"""Base Method class. A method class represents the NMR method.
@@ -462,35 +488,46 @@ class Method(Parseable):
             for item in products
         ]
 
-    def _get_transition_pathways_np(self, spin_system):
-        all_transitions = spin_system._all_transitions()
-
-        isotopes = spin_system.get_isotopes(symbol=True)
-        channels = [item.symbol for item in self.channels]
-        if np.any([item not in isotopes for item in channels]):
-            return np.asarray([])
+    def _pathway_hash(self):
+        """A hash of the method attributes which select the transition pathways and
+        their weights, that is, the channels and the events."""
+        events = [
+            [evt.__class__.__name__, evt.json(units=False)]
+            for dim in self.spectral_dimensions
+            for evt in dim.events
+        ]
+        item = [[item.symbol for item in self.channels], events]
+        item = json.dumps(item, sort_keys=True, default=str).encode()
+        return hashlib.sha1(item).hexdigest()
 
-        segments = [
-            evt.filter_transitions(all_transitions, isotopes, channels)
+    def _get_transition_pathways_np(self, spin_system):
+        """Return the transition pathways as a float32 array of shape
+        (n_pathways, n_events, 2, n_sites), where the events exclude the mixing
+        events."""
+        events = [
+            evt
             for dim in self.spectral_dimensions
             for evt in dim.events
             if evt.__class__.__name__ != "MixingEvent"
         ]
+        isotopes = spin_system.get_isotopes(symbol=True)
+        channels = [item.symbol for item in self.channels]
+        if np.any([item not in isotopes for item in channels]):
+            n_sites = len(spin_system.sites)
+            return np.empty((0, len(events), 2, n_sites), dtype=np.float32)
 
-        segments_index = [np.arange(item.shape[0]) for item in segments]
-        cartesian_index = cartesian_product(*segments_index)
-        return [
-            [segments[i][j] for i, j in enumerate(item)] for item in cartesian_index
-        ]
+        spins = [item.isotope.spin for item in spin_system.sites]
+        segments = [evt.select_transitions(spins, isotopes, channels) for evt in events]
+        return transition_pathways(segments)
 
     def _get_transition_pathway_weights(self, pathways, spin_system):
-        if pathways == []:
-            return np.asarray([])
+        weights = np.ones(pathways.shape[0], dtype=complex)
+        if weights.size == 0:
+            return weights
 
         symbol = [item.isotope.symbol for item in spin_system.sites]
         spins = np.asarray([item.isotope.spin for item in spin_system.sites])
         channels = [item.symbol for item in self.channels]
-        weights = np.ones(len(pathways), dtype=complex)
 
         # Mapping is a list of dict where each dict
         mapping = mixing_query_connect_map(self.spectral_dimensions)
@@ -499,10 +536,9 @@ class Method(Parseable):
             # Each column is list of the same angles
             alpha_, beta_, gamma_ = np.r_[euler_angles].T
             near_ = obj["near_index"]
-            for j, path in enumerate(pathways):
-                weights[j] *= self._calculate_transition_connect_weight(
-                    path[near_[0]], path[near_[1]], spins, alpha_, beta_, gamma_
-                )
+            transition_pathway_weights(
+                pathways, spins, near_[0], near_[1], alpha_, beta_, gamma_, weights
+            )
         return np.round(weights, decimals=6)
 
     @staticmethod
@@ -544,12 +580,32 @@ class Method(Parseable):
             )
         return amp
 
-    def _get_transition_pathway_and_weights_np(self, spin_system):
-        segments = self._get_transition_pathways_np(spin_system)
-        weights = self._get_transition_pathway_weights(segments, spin_system)
-        return segments, weights
-        # indexes = np.where(weights != 0)[0]
-        # return np.asarray(segments)[indexes], weights[indexes]
+    def _get_transition_pathway_and_weights_np(self, spin_system, reduced=False):
+        """Return the transition pathways and weights of the spin system. The results
+        depend only on the isotopes of the sites, and the coupled site pairs when
+        `reduced`, and are cached, therefore, the returned arrays are read-only.
+
+        Args:
+            SpinSystem spin_system: A SpinSystem object.
+            bool reduced: If true, the zero-weight pathways are dropped, and the
+                pathways with identical frequencies in every event are merged, see
+                `reduce_transition_pathways`.
+        """
+        key = (tuple(spin_system.get_isotopes(symbol=True)), self._pathway_hash())
+        if key not in _pathway_cache:
+            segments = self._get_transition_pathways_np(spin_system)
+            weights = self._get_transition_pathway_weights(segments, spin_system)
+            _cache_pathways(key, _read_only(segments, weights))
+        if not reduced:
+            return _pathway_cache[key]
+
+        pairs = coupled_site_pairs(spin_system)
+        reduced_key = (*key, pairs)
+        if reduced_key not in _pathway_cache:
+            segments, weights = _pathway_cache[key]
+            reduced_pathways = reduce_transition_pathways(segments, weights, pairs)
+            _cache_pathways(reduced_key, _read_only(*reduced_pathways))
+        return _pathway_cache[reduced_key]
 
     def get_transition_pathways(self, spin_system) -> List[TransitionPathway]:
         """Return a list of transition pathways from the given spin system that satisfy
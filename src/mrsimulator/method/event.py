@@ -17,6 +17,7 @@ from .query import MixingQuery
 from .query import TransitionQuery
 from .utils import D_symmetry_indexes
 from .utils import P_symmetry_indexes
+from .utils import transitions_from_symmetry
 
 __author__ = "Deepansh J. Srivastava"
 __email__ = "srivastava.89@osu.edu"
@@ -130,6 +131,24 @@ class BaseEvent(Parseable):
             segment += [st]
         return np.vstack(segment)
 
+    def select_transitions(self, spins, isotopes, channels):
+        """Generate the transitions selected by the transition query. The result is the
+        same as `filter_transitions` over all transitions of the spin system, but only
+        the selected transitions are ever generated.
+
+        Args:
+            (list) spins: List of spin quantum numbers of the sites.
+            (list) isotopes: List of isotopes in the spin system.
+            (list) channels: List of method channels.
+        """
+        symmetry_combinations = self.combination(isotopes, channels)
+        return np.vstack(
+            [
+                transitions_from_symmetry(spins, item["P"], item["D"])
+                for item in symmetry_combinations
+            ]
+        )
+
 
 class SpectralEvent(BaseEvent):
     r"""Base SpectralEvent class defines the spin environment and the transition query
@@ -6,8 +6,12 @@ from mrsimulator.method import Method
 from mrsimulator.method import MixingEvent
 from mrsimulator.method import SpectralDimension
 from mrsimulator.method.utils import combine_mixing_queries
+from mrsimulator.method.utils import D_symmetry_indexes
 from mrsimulator.method.utils import mixing_query_connect_map
 from mrsimulator.method.utils import nearest_nonmixing_event
+from mrsimulator.method.utils import P_symmetry_indexes
+from mrsimulator.method.utils import reduce_transition_pathways
+from mrsimulator.method.utils import transitions_from_symmetry
 from mrsimulator.utils.error import MissingSpectralEventError
 
 # from mrsimulator.method.utils import angle_and_phase_list
@@ -127,3 +131,59 @@ def test_mixing_query_connect_map():
     error = "SpectralDimension requires at least one SpectralEvent"
     with pytest.raises(MissingSpectralEventError, match=f".*{error}.*"):
         SpectralDimension(events=[MX1, MX2, {"duration": 0.5}, MX2, {"duration": 0.5}])
+
+
+def test_transitions_from_symmetry():
+    sys = SpinSystem(sites=[{"isotope": "27Al"}, {"isotope": "1H"}, {"isotope": "2H"}])
+    spins = [site.isotope.spin for site in sys.sites]
+    all_transitions = sys._all_transitions()
+
+    nan = np.nan
+    queries = [
+        ([[-1, 0, 0]], []),
+        ([[-1, 0, 0], [0, -1, 0], [0, 0, -1]], []),
+        ([[-1, nan, 0]], [[0, nan, nan]]),
+        ([], [[0, 0, 0], [2, nan, 0]]),
+        ([[1, -1, nan]], [[nan, 0, 1]]),
+        ([], []),
+    ]
+    for P, D in queries:
+        P, D = np.asarray(P), np.asarray(D)
+        expected = all_transitions
+        if P.size > 0:
+            expected = expected[P_symmetry_indexes(expected, P)]
+        if D.size > 0:
+            expected = expected[D_symmetry_indexes(expected, D)]
+
+        transitions = transitions_from_symmetry(spins, P, D)
+        np.testing.assert_equal(transitions, expected)
+
+
+def test_reduce_transition_pathways():
+    # 1H -1 transitions of a 1H-13C pair with the 13C spectator at m = -1/2 and 1/2.
+    pathways = 0.5 * np.asarray(
+        [
+            [[[1, -1], [-1, -1]]],
+            [[[1, 1], [-1, 1]]],
+            [[[1, -1], [1, 1]]],
+            [[[-1, 1], [1, 1]]],
+        ],
+        dtype=np.float32,
+    )
+    weights = np.asarray([0.5, 0.5j, 0, 1])
+
+    # uncoupled sites, the spectator state does not change the frequencies.
+    reduced, reduced_weights = reduce_transition_pathways(pathways, weights)
+    np.testing.assert_equal(reduced, pathways[[0, 3]])
+    np.testing.assert_equal(reduced_weights, [0.5 + 0.5j, 1])
+
+    # coupled sites, the spectator state shifts the frequencies.
+    reduced, reduced_weights = reduce_transition_pathways(pathways, weights, [(0, 1)])
+    np.testing.assert_equal(reduced, pathways[[0, 1, 3]])
+    np.testing.assert_equal(reduced_weights, [0.5, 0.5j, 1])
+
+    # cancelling weights are dropped.
+    weights = np.asarray([0.5, -0.5, 0, 1])
+    reduced, reduced_weights = reduce_transition_pathways(pathways, weights)
+    np.testing.assert_equal(reduced, pathways[[3]])
+    np.testing.assert_equal(reduced_weights, [1])
@@ -5,6 +5,8 @@ from mrsimulator.method import MixingEvent
 from mrsimulator.method import SpectralDimension
 from mrsimulator.method import SpectralEvent
 from mrsimulator.method.query import MixingEnum
+from mrsimulator.method.utils import mixing_query_connect_map
+from mrsimulator.method.utils import to_euler_list
 from mrsimulator.transition import TransitionPathway
 
 __author__ = "Deepansh J. Srivastava"
@@ -226,6 +228,54 @@ def test_no_mixing():
     assert_transitions(tr_should_be, weights_should_be, transitions)
 
 
+def test_pathway_weights_and_cache():
+    system = SpinSystem(
+        sites=[{"isotope": "1H"}, {"isotope": "1H"}, {"isotope": "13C"}]
+    )
+    method = Method(
+        channels=["1H"],
+        spectral_dimensions=[
+            {
+                "events": [
+                    {"transition_queries": [{"ch1": {"P": [-1]}}]},
+                    {"query": {"ch1": {"angle": 1.2, "phase": 0.3}}},
+                ],
+            },
+            {"events": [{"transition_queries": [{"ch1": {"P": [-1]}}]}]},
+        ],
+    )
+    pathways, weights = method._get_transition_pathway_and_weights_np(system)
+    assert pathways.shape == (len(weights), 2, 2, 3)
+
+    # compare with the per-site evaluation of the connect factors.
+    query_list = mixing_query_connect_map(method.spectral_dimensions)[0]
+    query_list = query_list["mixing_query_list"]
+    angles = to_euler_list(["1H", "1H", "13C"], ["1H"], query_list)
+    alpha, beta, gamma = np.asarray(angles).T
+    spins = np.asarray([0.5, 0.5, 0.5])
+    expected = [
+        method._calculate_transition_connect_weight(
+            path[0], path[1], spins, alpha, beta, gamma
+        )
+        for path in pathways
+    ]
+    np.testing.assert_almost_equal(weights, expected, decimal=5)
+
+    # the pathways of the same isotopes and method are reused.
+    other = SpinSystem(sites=[{"isotope": "1H"}, {"isotope": "1H"}, {"isotope": "13C"}])
+    cached = method._get_transition_pathway_and_weights_np(other)
+    assert cached[0] is pathways and cached[1] is weights
+
+    # the cached arrays are shared, hence read-only.
+    assert not pathways.flags.writeable and not weights.flags.writeable
+    reduced = method._get_transition_pathway_and_weights_np(system, reduced=True)
+    assert not reduced[0].flags.writeable and not reduced[1].flags.writeable
+
+    method.spectral_dimensions[0].events[1].query.ch1.phase = 0.0
+    updated = method._get_transition_pathway_and_weights_np(system)
+    assert updated[1] is not weights
+
+
 def assert_transitions(transition_pathways, weights, tr):
     expected = [
         TransitionPathway(
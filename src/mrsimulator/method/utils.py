@@ -48,6 +48,108 @@ def D_symmetry_indexes(transitions, list_of_D):
     return get_symmetry_indexes(D_fn, list_of_D)
 
 
+def _site_transition_codes(m, levels, P, D):
+    """Return the Zeeman state indexes of the initial and final energy states of the
+    transitions with the symmetry P and D at every site. The indexes are built site by
+    site from the (m_i, m_f) pairs of the site satisfying its P and D values."""
+    initial = np.zeros(1, dtype=np.int64)
+    final = np.zeros(1, dtype=np.int64)
+    for k, m_k in enumerate(m):
+        m_i, m_f = np.meshgrid(m_k, m_k, indexing="ij")
+        select = np.ones(m_i.shape, dtype=bool)
+        if not np.isnan(P[k]):
+            select &= (m_f - m_i) == P[k]
+        if not np.isnan(D[k]):
+            select &= (m_f**2 - m_i**2) == D[k]
+        index_i, index_f = np.nonzero(select)
+        initial = (initial[:, np.newaxis] * levels[k] + index_i).ravel()
+        final = (final[:, np.newaxis] * levels[k] + index_f).ravel()
+    return np.column_stack([initial, final])
+
+
+def transitions_from_symmetry(spins, list_of_P, list_of_D):
+    """Return the transitions of a spin system with the P and D symmetry of any of the
+    queries, as a Numpy array of shape (M, 2, N) ordered as the transitions from
+    `SpinSystem._all_transitions`. The transitions are generated site by site from the
+    symmetry queries, instead of filtering all (prod(2I+1))^2 transitions of the spin
+    system, so that the memory and time scale with the number of selected transitions.
+
+    Args:
+        spins: List of the spin quantum numbers of the N sites.
+        list_of_P: Array of shape (k, N) of the P symmetry queries. A nan matches any P
+            value of the site, and an empty array matches all transitions.
+        list_of_D: Array of shape (l, N) of the D symmetry queries. A nan matches any D
+            value of the site, and an empty array matches all transitions.
+    """
+    n_sites = len(spins)
+    m = [np.arange(2 * spin + 1) - spin for spin in spins]
+    levels = [item.size for item in m]
+
+    queries = [list_of_P, list_of_D]
+    queries = [
+        np.asarray(item, dtype=float).reshape(-1, n_sites)
+        if np.asarray(item).size > 0
+        else np.full((1, n_sites), np.nan)
+        for item in queries
+    ]
+
+    codes = [
+        _site_transition_codes(m, levels, P, D) for P in queries[0] for D in queries[1]
+    ]
+    codes = np.unique(np.vstack(codes), axis=0)
+
+    transitions = np.empty((codes.shape[0], 2, n_sites))
+    for k in range(n_sites)[::-1]:
+        codes, index = np.divmod(codes, levels[k])
+        transitions[:, :, k] = m[k][index]
+    return transitions
+
+
+def coupled_site_pairs(spin_system):
+    """Return a sorted tuple of the (i, j) site index pairs of the spin system
+    couplings."""
+    couplings = spin_system.couplings or []
+    return tuple(sorted({tuple(sorted(item.site_index)) for item in couplings}))
+
+
+def reduce_transition_pathways(pathways, weights, coupled_pairs=()):
+    """Drop the zero-weight transition pathways, and merge the pathways with identical
+    frequencies in every event into one pathway with the sum of the complex weights.
+
+    The frequencies of a transition are given by the P and D symmetry functions of
+    every site, which also determine the F symmetry function, and by the dIS symmetry
+    function of every coupled pair of sites. The merged pathways keep the order of
+    their first occurrence.
+
+    Args:
+        pathways: Array of shape (n_pathways, n_events, 2, n_sites) of the pathways.
+        weights: Complex array of the pathway weights.
+        coupled_pairs: List of the (i, j) site indexes of the couplings.
+    """
+    keep = weights != 0
+    pathways, weights = pathways[keep], weights[keep]
+    if weights.size == 0:
+        return pathways, weights
+
+    initial, final = pathways[:, :, 0, :], pathways[:, :, 1, :]
+    symmetry = [final - initial, final**2 - initial**2]
+    if len(coupled_pairs) > 0:
+        i, j = np.asarray(coupled_pairs).T
+        symmetry += [final[..., i] * final[..., j] - initial[..., i] * initial[..., j]]
+    symmetry = np.concatenate(symmetry, axis=2).reshape(weights.size, -1)
+
+    _, index, inverse = np.unique(
+        symmetry, axis=0, return_index=True, return_inverse=True
+    )
+    merged = np.zeros(index.size, dtype=complex)
+    np.add.at(merged, inverse.ravel(), weights)
+
+    order = np.argsort(index)
+    pathways, merged = pathways[index[order]], np.round(merged[order], decimals=6)
+    keep = merged != 0
+    return pathways[keep], merged[keep]
+
+
 def get_iso_dict(channels, isotopes):
     """
     Parse the spin system sites to determine indices of each isotope that is part of
@@ -1,4 +1,5 @@
 import numpy as np
+from mrsimulator.base_model import czjzek_histogram
 from mrsimulator.spin_system.tensors import SymmetricTensor
 
 from .utils import get_Haeberlen_components
@@ -70,7 +71,8 @@ def _czjzek_random_distribution_tensors(sigma, n):
 class AbstractDistribution:
     def pdf(self, pos, size: int = 400000):
         """Generates a probability distribution function by binning the random
-        variates of length size onto the given grid system.
+        variates of length size onto the given grid system. The random variates are
+        drawn and binned in C, without storing the random tensors.
 
         Args:
             pos: A list of coordinates along the two dimensions given as NumPy arrays.
@@ -93,8 +95,8 @@ class AbstractDistribution:
 
         x_size = pos[0].size
         y_size = pos[1].size
-        zeta, eta = self.rvs(size)
-        hist, _, _ = np.histogram2d(zeta, eta, bins=[x_size, y_size], range=[x, y])
+        T0, scale = self._tensor_parameters()
+        hist = czjzek_histogram(x, x_size, y, y_size, T0, scale, size, self.polar)
 
         hist /= hist.sum()
 
@@ -141,6 +143,10 @@ class CzjzekDistribution(AbstractDistribution):
         self.sigma = sigma
         self.polar = polar
 
+    def _tensor_parameters(self):
+        """The principal components of the dominant tensor and the perturbation."""
+        return [0.0, 0.0, 0.0], self.sigma
+
     def rvs(self, size: int):
         """Draw random variates of length `size` from the distribution.
 
@@ -207,24 +213,8 @@ class ExtCzjzekDistribution(AbstractDistribution):
         self.eps = eps
         self.polar = polar
 
-    def rvs(self, size: int):
-        """Draw random variates of length `size` from the distribution.
-
-        Args:
-            size: The number of random points to draw.
-
-        Returns:
-            A list of two NumPy array, where the first and the second array are the
-            anisotropic/quadrupolar coupling constant and asymmetry parameter,
-            respectively.
-
-        Example:
-            >>> Cq_dist, eta_dist = ext_cz_model.rvs(size=1000000)
-        """
-
-        # czjzek_random_distribution model
-        tensors = _czjzek_random_distribution_tensors(1, size)
-
+    def _tensor_parameters(self):
+        """The principal components of the dominant tensor and the perturbation."""
         symmetric_tensor = self.symmetric_tensor
 
         if isinstance(symmetric_tensor, dict):
@@ -244,6 +234,28 @@ class ExtCzjzekDistribution(AbstractDistribution):
         # the perturbation factor
         rho = self.eps * norm_T0 / np.sqrt(30)
 
+        return T0, rho
+
+    def rvs(self, size: int):
+        """Draw random variates of length `size` from the distribution.
+
+        Args:
+            size: The number of random points to draw.
+
+        Returns:
+            A list of two NumPy array, where the first and the second array are the
+            anisotropic/quadrupolar coupling constant and asymmetry parameter,
+            respectively.
+
+        Example:
+            >>> Cq_dist, eta_dist = ext_cz_model.rvs(size=1000000)
+        """
+
+        # czjzek_random_distribution model
+        tensors = _czjzek_random_distribution_tensors(1, size)
+
+        T0, rho = self._tensor_parameters()
+
         # total tensor
         total_tensors = np.diag(T0) + rho * tensors
 
@@ -0,0 +1,193 @@
+import hashlib
+import json
+import os
+
+import numpy as np
+from mrsimulator import __version__
+from mrsimulator.base_model import CompiledMethod
+from mrsimulator.simulator.config import ConfigSimulator
+
+__author__ = "Deepansh J. Srivastava"
+__email__ = "srivastava.89@osu.edu"
+
+# The directory of the kernel cache, None when disabled. The kernels are stored as
+# `.npy` files, named after a hash of the mrsimulator version, the method, the
+# simulation config, and the grid, and are memory mapped when loaded.
+_kernel_cache_dir = None
+
+# The number of lineshapes simulated, and written to the kernel file, at a time.
+_CHUNK = 1024
+
+
+def set_kernel_cache_dir(dirname):
+    """Set the directory of the lineshape kernel cache. The cache is disabled by
+    default, and the kernels are then held in memory. The cached kernels are never
+    removed, and a None value disables the cache again.
+
+    Example:
+        >>> from mrsimulator.models.kernel import set_kernel_cache_dir
+        >>> set_kernel_cache_dir("~/.mrsimulator/kernels") # doctest:+SKIP
+    """
+    global _kernel_cache_dir
+    _kernel_cache_dir = None if dirname is None else os.fspath(dirname)
+
+
+class LineshapeKernel:
+    r"""A library of lineshapes on a two-dimensional (magnitude, eta) grid.
+
+    The kernel holds the spectrum of a single-site spin system at every grid point,
+    for a given method and simulation config. The spectrum of a distribution of
+    tensors, such as the Czjzek or the extended Czjzek distribution, is then the
+    matrix-vector product of the kernel with the two-dimensional probability
+    histogram of the distribution over the same grid,
+
+    .. math::
+        S = \sum_{i, j} p(\eta_i, \zeta_j) K(\eta_i, \zeta_j).
+
+    Each lineshape is the spectrum of a spin system with an abundance of 100 %, so
+    that a histogram normalized to one gives the spectrum of one spin system.
+
+    When a cache directory is set with `set_kernel_cache_dir`, the kernels are cached
+    on disk and memory mapped when loaded, so that a kernel is simulated once for a
+    given method, config, and grid.
+
+    Args:
+        method: The Method object.
+        magnitude: A 1D array of the anisotropy grid. The quadrupolar coupling
+            constant, Cq, in Hz, or the shielding anisotropy, zeta, in ppm.
+        eta: A 1D array of the asymmetry grid.
+        str tensor: The tensor on the grid, `quadrupolar` or `shielding`. The default
+            is `quadrupolar`.
+        float isotropic_chemical_shift: The isotropic chemical shift in ppm of the
+            sites. The default is 0.
+        ConfigSimulator config: The simulation config. The `decompose_spectrum`
+            attribute is ignored. The default is `ConfigSimulator()`.
+        int n_threads: The number of threads used in simulating the kernel.
+
+    Example:
+        >>> from mrsimulator.models import CzjzekDistribution, LineshapeKernel
+        >>> kernel = LineshapeKernel(method, Cq, eta) # doctest:+SKIP
+        >>> _, _, amp = CzjzekDistribution(0.5e6).pdf(
+        ...     [kernel.magnitude, kernel.eta]
+        ... ) # doctest:+SKIP
+        >>> spectrum = kernel.spectrum(amp) # doctest:+SKIP
+    """
+
+    def __init__(
+        self,
+        method,
+        magnitude,
+        eta,
+        tensor: str = "quadrupolar",
+        isotropic_chemical_shift: float = 0.0,
+        config: ConfigSimulator = None,
+        n_threads: int = 1,
+    ):
+        if tensor not in ["quadrupolar", "shielding"]:
+            raise ValueError(
+                f"Expecting `quadrupolar` or `shielding` tensor, found `{tensor}`."
+            )
+        self.method = method
+        self.magnitude = np.asarray(magnitude, dtype=np.float64).ravel()
+        self.eta = np.asarray(eta, dtype=np.float64).ravel()
+        self.tensor = tensor
+        self.isotropic_chemical_shift = float(isotropic_chemical_shift)
+        self.config = ConfigSimulator() if config is None else config.copy()
+        self.shape = (self.eta.size, self.magnitude.size)
+
+        kwargs = self.config.get_int_dict()
+        kwargs.update(decompose_spectrum=1, isotropic_shift_convolution=False)
+        self.kernel = self._load(kwargs)
+        if self.kernel is None:
+            self.kernel = self._compute(kwargs, n_threads)
+
+    def _key(self, kwargs):
+        """A hash of the mrsimulator version, the method, the simulation config, and
+        the grid."""
+        method = self.method.json(units=False)
+        exclude = ["name", "label", "description", "simulation", "experiment"]
+        _ = [method.pop(k, None) for k in exclude]
+        _ = [dim.pop("origin_offset", None) for dim in method["spectral_dimensions"]]
+        item = {
+            "version": __version__,
+            "method": method,
+            "config": kwargs,
+            "tensor": self.tensor,
+            "isotropic_chemical_shift": self.isotropic_chemical_shift,
+            "magnitude": self.magnitude.tolist(),
+            "eta": self.eta.tolist(),
+        }
+        item = json.dumps(item, sort_keys=True, default=str).encode()
+        return hashlib.sha1(item).hexdigest()
+
+    def _filename(self, kwargs):
+        if _kernel_cache_dir is None:
+            return None
+        dirname = os.path.expanduser(_kernel_cache_dir)
+        return os.path.join(dirname, f"{self._key(kwargs)}.npy")
+
+    def _load(self, kwargs):
+        """Memory map the cached kernel, if one exists."""
+        filename = self._filename(kwargs)
+        if filename is None or not os.path.isfile(filename):
+            return None
+        return np.load(filename, mmap_mode="r")
+
+    def _compute(self, kwargs, n_threads):
+        """Simulate the kernel in chunks of lineshapes. With the cache enabled, the
+        chunks are written to a temporary file, which then replaces the kernel file,
+        so that the concurrent processes never read a partial kernel."""
+        compiled = CompiledMethod(self.method, number_of_threads=n_threads, **kwargs)
+        grid = np.meshgrid(self.magnitude, self.eta)
+        magnitude, eta = [item.ravel() for item in grid]
+        n_points = int(np.prod(self.method.shape()))
+
+        filename = self._filename(kwargs)
+        if filename is None:
+            kernel = np.empty((magnitude.size, n_points), dtype=np.complex128)
+        else:
+            os.makedirs(os.path.dirname(filename), exist_ok=True)
+            temp = f"{filename}.{os.getpid()}.tmp"
+            kernel = np.lib.format.open_memmap(
+                temp, mode="w+", dtype=np.complex128, shape=(magnitude.size, n_points)
+            )
+
+        tensor = {
+            "quadrupolar": ["quadrupolar_Cq", "quadrupolar_eta"],
+            "shielding": ["shielding_zeta", "shielding_eta"],
+        }[self.tensor]
+        for i in range(0, magnitude.size, _CHUNK):
+            args = {
+                tensor[0]: magnitude[i : i + _CHUNK],
+                tensor[1]: eta[i : i + _CHUNK],
+            }
+            iso = np.full(args[tensor[0]].size, self.isotropic_chemical_shift)
+            amp = compiled.simulate_sites(iso, **args)
+            kernel[i : i + iso.size] = np.asarray(amp).reshape(iso.size, n_points)
+
+        if filename is None:
+            return kernel
+
+        kernel.flush()
+        del kernel
+        os.replace(temp, filename)
+        return np.load(filename, mmap_mode="r")
+
+    def spectrum(self, amp):
+        """Return the spectrum of a distribution of tensors as the matrix-vector product
+        of the kernel with the probability histogram.
+
+        Args:
+            amp: A 2D array of shape (eta.size, magnitude.size) of the probability
+                histogram, such as the amplitude from the `pdf` method of the
+                distribution models evaluated at [magnitude, eta].
+
+        Returns:
+            A numpy array of the spectrum with the shape of the method.
+        """
+        amp = np.asarray(amp, dtype=np.float64)
+        if amp.shape != self.shape:
+            raise ValueError(
+                f"Expecting a histogram of shape {self.shape}, found {amp.shape}."
+            )
+        return (amp.ravel() @ self.kernel).reshape(self.method.shape())
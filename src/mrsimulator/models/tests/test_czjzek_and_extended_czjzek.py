@@ -60,6 +60,20 @@ def test_extended_czjzek_eta_distribution_3():
     np.testing.assert_almost_equal(hist1 / COUNT, data[3], decimal=2, err_msg=message)
 
 
+def test_extended_czjzek_pdf():
+    filename = path.join(MODULE_DIR, "test_data", "eps=0.2.npy")
+    with open(filename, "rb") as f:
+        data = np.load(f)
+
+    S0 = {"Cq": 1e6, "eta": 0.3}
+    Cq_range = np.arange(201) * 2e4 - 2e6
+    e_range = (np.arange(100) + 0.5) / 100
+    _, _, amp = ExtCzjzekDistribution(S0, eps=0.2).pdf([Cq_range, e_range], COUNT)
+
+    message = "failed to compare the eta projection of pdf with file eps=0.2.npy"
+    np.testing.assert_almost_equal(amp.sum(axis=1), data[1], decimal=2, err_msg=message)
+
+
 def test_czjzek_distribution():
     sigma = 0.5
 
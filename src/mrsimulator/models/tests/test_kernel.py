@@ -0,0 +1,79 @@
+import os
+
+import numpy as np
+import pytest
+from mrsimulator import Simulator
+from mrsimulator.method.lib import BlochDecayCTSpectrum
+from mrsimulator.models import CzjzekDistribution
+from mrsimulator.models import kernel as kernel_module
+from mrsimulator.models import LineshapeKernel
+from mrsimulator.models.kernel import set_kernel_cache_dir
+from mrsimulator.utils.collection import single_site_system_generator
+
+__author__ = "Deepansh J. Srivastava"
+__email__ = "srivastava.89@osu.edu"
+
+
+def test_lineshape_kernel(tmp_path):
+    method = BlochDecayCTSpectrum(
+        channels=["27Al"],
+        rotor_frequency=1e9,
+        spectral_dimensions=[{"count": 256, "spectral_width": 40000}],
+    )
+    Cq = np.arange(1, 9) * 0.5e6
+    eta = np.arange(5) / 4
+    _, _, amp = CzjzekDistribution(1e6).pdf([Cq, eta], size=20000)
+
+    # the cache directory of the other tests is restored afterwards.
+    previous_cache_dir = kernel_module._kernel_cache_dir
+    set_kernel_cache_dir(tmp_path)
+    try:
+        kernel = LineshapeKernel(method, Cq, eta)
+        assert len(os.listdir(tmp_path)) == 1
+        spectrum = kernel.spectrum(amp)
+
+        # the second kernel is memory mapped from the cache.
+        cached = LineshapeKernel(method, Cq, eta)
+        assert isinstance(cached.kernel, np.memmap)
+        np.testing.assert_almost_equal(cached.spectrum(amp), spectrum, decimal=12)
+    finally:
+        set_kernel_cache_dir(previous_cache_dir)
+
+    Cq_, eta_ = np.meshgrid(Cq, eta)
+    index = np.where(amp > 0)
+    spin_systems = single_site_system_generator(
+        isotope="27Al",
+        quadrupolar={"Cq": Cq_[index], "eta": eta_[index]},
+        abundance=amp[index],
+        rtol=0,
+    )
+    sim = Simulator(spin_systems=spin_systems, methods=[method])
+    sim.run(pack_as_csdm=False)
+    np.testing.assert_almost_equal(
+        spectrum / spectrum.real.max(),
+        sim.methods[0].simulation[0] / sim.methods[0].simulation[0].real.max(),
+        decimal=8,
+    )
+
+    error = r"Expecting a histogram of shape \(5, 8\), found \(8, 5\)."
+    with pytest.raises(ValueError, match=error):
+        kernel.spectrum(amp.T)
+
+
+def test_lineshape_kernel_cache_key(monkeypatch):
+    method = BlochDecayCTSpectrum(
+        channels=["27Al"],
+        rotor_frequency=1e9,
+        spectral_dimensions=[{"count": 64, "spectral_width": 40000}],
+    )
+
+    # the kernels are held in memory unless a cache directory is set.
+    assert kernel_module._kernel_cache_dir is None
+    kernel = LineshapeKernel(method, [1e6, 2e6], [0, 0.5])
+    assert not isinstance(kernel.kernel, np.memmap)
+
+    # the kernels of other mrsimulator versions are not reused.
+    kwargs = kernel.config.get_int_dict()
+    key = kernel._key(kwargs)
+    monkeypatch.setattr(kernel_module, "__version__", "0.0.0")
+    assert kernel._key(kwargs) != key
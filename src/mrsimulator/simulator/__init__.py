@@ -1,5 +1,7 @@
 """Base Simulator class."""
+import hashlib
 import json
+from collections import Counter
 from copy import deepcopy
 from typing import List
 
@@ -11,6 +13,7 @@ from joblib import delayed
 from joblib import Parallel
 from mrsimulator import Site
 from mrsimulator import SpinSystem
+from mrsimulator.base_model import CompiledMethod
 from mrsimulator.base_model import core_simulator
 from mrsimulator.method import Method
 from mrsimulator.spin_system.isotope import Isotope
@@ -18,6 +21,7 @@ from mrsimulator.utils import flatten_dict
 from mrsimulator.utils.abstract_list import AbstractList
 from mrsimulator.utils.importer import import_json
 from mrsimulator.utils.parseable import Parseable
+from pydantic import PrivateAttr
 
 from .config import ConfigSimulator
 
@@ -26,6 +30,21 @@ __email__ = "srivastava.89@osu.edu"
 
 __CPU_count__ = psutil.cpu_count()
 
+# The number of incremental updates of a cached spectrum before it is rebuilt from the
+# spectra of the individual spin systems, which bounds the accumulated round-off.
+_CACHE_REBUILD_INTERVAL = 64
+
+
+class _CompiledMethods(dict):
+    """The compiled methods of a simulator. The compiled methods hold the native
+    simulation plans, which are neither copied nor pickled with the simulator."""
+
+    def __deepcopy__(self, memo):
+        return _CompiledMethods()
+
+    def __reduce__(self):
+        return (_CompiledMethods, ())
+
 
 class Simulator(Parseable):
     """The simulator class.
@@ -132,6 +151,8 @@ class Simulator(Parseable):
     spin_systems: List[SpinSystem] = []
     methods: List[Method] = []
     config: ConfigSimulator = ConfigSimulator()
+    _spectrum_cache: dict = PrivateAttr(default_factory=dict)
+    _compiled_methods: dict = PrivateAttr(default_factory=_CompiledMethods)
     # indexes = []
 
     class Config:
@@ -324,6 +345,7 @@ class Simulator(Parseable):
         self,
         method_index: list = None,
         n_jobs: int = 1,
+        n_threads: int = 1,
         pack_as_csdm: bool = True,
         **kwargs,
     ):
@@ -334,6 +356,12 @@ class Simulator(Parseable):
                 simulations corresponding to the methods at the given index/indexes
                 will be computed. The default is None, `i.e.`, the simulation for
                 all method will be computed.
+            int n_jobs: The number of processes used in the simulation. The default
+                is 1.
+            int n_threads: The number of native threads used by each process to
+                simulate the spin systems. The threads share the process memory, which
+                avoids the process spawning and pickling overhead of ``n_jobs``. The
+                default is 1.
             bool pack_as_csdm: If true, the simulation results are stored as a
                 `CSDM <https://csdmpy.readthedocs.io/en/stable/api/CSDM.html>`_ object,
                 otherwise, as a `ndarray
@@ -353,30 +381,28 @@ class Simulator(Parseable):
             method_index = np.arange(len(self.methods))
         elif isinstance(method_index, int):
             method_index = [method_index]
+        incremental = (
+            self.config.cache_spin_system_spectra
+            and self.config.decompose_spectrum == "none"
+            and not self.config.isotropic_shift_convolution
+            and n_jobs == 1
+            and kwargs == {}
+        )
+        if not incremental:
+            self._spectrum_cache.clear()
+
         for index in method_index:
             method = self.methods[index]
-            spin_sys = get_chunks(self.spin_systems, n_jobs)
-            kwargs_dict = self.config.get_int_dict()
-            jobs = (
-                delayed(core_simulator)(
-                    method=method, spin_systems=sys, **kwargs_dict, **kwargs
+            if incremental:
+                amp = [self._run_incremental(index, method, n_threads)]
+            elif n_jobs == 1:
+                kwargs_dict = {**self.config.get_int_dict(), **kwargs}
+                compiled = self._compiled_method(
+                    index, method, number_of_threads=n_threads, **kwargs_dict
                 )
-                for sys in spin_sys
-            )
-            amp = Parallel(
-                n_jobs=n_jobs,
-                verbose=verbose,
-                backend="loky",
-                # **{
-                #     "backend": {
-                #         "threads": "threading",
-                #         "processes": "multithreading",
-                #         None: None,
-                #     }["threads"]
-                # },
-            )(jobs)
-
-            # self.indexes.append(indexes)
+                amp = [compiled.simulate(self.spin_systems)]
+            else:
+                amp = self._run_jobs(method, n_jobs, n_threads, verbose, **kwargs)
 
             gyromagnetic_ratio = method.channels[0].gyromagnetic_ratio
             B0 = method.spectral_dimensions[0].events[0].magnetic_flux_density
@@ -398,6 +424,104 @@ class Simulator(Parseable):
             )
             amp = None
 
+    def _run_jobs(self, method, n_jobs, n_threads, verbose, **kwargs):
+        """Simulate the spin systems in chunks over n_jobs processes."""
+        spin_sys = get_chunks(self.spin_systems, n_jobs)
+        kwargs_dict = self.config.get_int_dict()
+        jobs = (
+            delayed(core_simulator)(
+                method=method,
+                spin_systems=sys,
+                number_of_threads=n_threads,
+                **kwargs_dict,
+                **kwargs,
+            )
+            for sys in spin_sys
+        )
+        return Parallel(
+            n_jobs=n_jobs,
+            verbose=verbose,
+            backend="loky",
+            # **{
+            #     "backend": {
+            #         "threads": "threading",
+            #         "processes": "multithreading",
+            #         None: None,
+            #     }["threads"]
+            # },
+        )(jobs)
+
+    def _run_incremental(self, index, method, n_threads):
+        """Return the spectrum of the method at `index` from the cached spectra of the
+        individual spin systems. Only the spin systems missing from the cache are
+        simulated, and the total spectrum is updated by subtracting the spectra of the
+        stale spin systems and adding the spectra of the new ones. The total spectrum
+        is instead rebuilt from the cached spectra when the update touches as many
+        spectra as the rebuild, and after every `_CACHE_REBUILD_INTERVAL` updates."""
+        kwargs = self.config.get_int_dict()
+        kwargs.update(decompose_spectrum=1)
+        method_key = _hash_of(_method_parameters(method), kwargs)
+
+        cache = self._spectrum_cache.get(index, None)
+        if cache is None or cache["key"] != method_key:
+            cache = {
+                "key": method_key,
+                "spectra": {},
+                "counts": Counter(),
+                "total": np.zeros(method.shape(), dtype=np.complex128),
+                "updates": 0,
+            }
+            self._spectrum_cache[index] = cache
+
+        keys = [_hash_of(sys.json(units=False)) for sys in self.spin_systems]
+        spectra = cache["spectra"]
+        new = {k: sys for k, sys in zip(keys, self.spin_systems) if k not in spectra}
+        if new:
+            compiled = self._compiled_method(
+                index, method, number_of_threads=n_threads, **kwargs
+            )
+            amp = compiled.simulate(list(new.values()))
+            spectra.update(zip(new.keys(), amp))
+
+        counts = Counter(keys)
+        removed = cache["counts"] - counts
+        added = counts - cache["counts"]
+        total = cache["total"]
+        if removed or added:
+            cache["updates"] += 1
+        if (
+            len(removed) + len(added) >= len(counts)
+            or cache["updates"] >= _CACHE_REBUILD_INTERVAL
+        ):
+            total[...] = 0.0
+            for k, n in counts.items():
+                total += n * spectra[k]
+            cache["updates"] = 0
+        else:
+            for k, n in removed.items():
+                total -= n * spectra[k]
+            for k, n in added.items():
+                total += n * spectra[k]
+
+        cache["spectra"] = {k: spectra[k] for k in counts}
+        cache["counts"] = counts
+        return total.copy()
+
+    def _compiled_method(self, index, method, **kwargs):
+        """Return the method at `index` compiled with the simulation arguments
+        `kwargs`. The compiled methods are kept across the runs, and are recompiled
+        only when the method parameters or the config change."""
+        key = _hash_of(_method_parameters(method), self.config.get_int_dict())
+        entry = self._compiled_methods.get(index, None)
+        if entry is None or entry["key"] != key:
+            entry = {"key": key, "compiled": {}}
+            self._compiled_methods[index] = entry
+
+        args = _hash_of(kwargs)
+        if args not in entry["compiled"]:
+            entry["compiled"][args] = CompiledMethod(method, **kwargs)
+        return entry["compiled"][args]
+
     def save(self, filename: str, with_units: bool = True):
         """Serialize the simulator object to a JSON file.
 
@@ -578,6 +702,25 @@ class Sites(AbstractList):
         return pd.DataFrame(row)
 
 
+def _hash_of(*items):
+    """Return a hash of the JSON serialization of the items."""
+    item = json.dumps(items, sort_keys=True, default=str).encode()
+    return hashlib.sha1(item).hexdigest()
+
+
+def _method_parameters(method):
+    """Return the method attributes which determine the simulated spectrum, that is,
+    excluding the simulation, the experiment, and the origin offsets."""
+    dims = [item.json(units=False) for item in method.spectral_dimensions]
+    _ = [dim.pop("origin_offset", None) for dim in dims]
+    return {
+        "channels": [item.json() for item in method.channels],
+        "spectral_dimensions": dims,
+        "affine_matrix": method.affine_matrix,
+        **{k: getattr(method, k) for k in method.property_units},
+    }
+
+
 def get_chunks(items_list, n_jobs):
     """Return the chucks of into list into roughly n_jobs equal chunks
 
@@ -10,6 +10,7 @@ __email__ = "srivastava.89@osu.edu"
 # decompose spectrum
 __decompose_spectrum_enum__ = {"none": 0, "spin_system": 1}
 __isotropic_interpolation_enum__ = {"linear": 0, "gaussian": 1}
+__fftw_plan_rigor_enum__ = {"estimate": 0, "measure": 1, "patient": 2}
 
 # integration volume
 __integration_volume_enum__ = {"octant": 0, "hemisphere": 1}
@@ -65,6 +66,45 @@ class ConfigSimulator(Parseable):
         - ``linear`` (default): linear interpolation.
         - ``gaussian``:  Gaussian interpolation with `sigma=0.25*bin_width`.
 
+    fftw_plan_rigor: enum (optional).
+        The planning rigor of the fftw plans used in the sideband evaluation. The valid
+        literals are
+
+        - ``estimate`` (default): a heuristic plan with no planning cost.
+        - ``measure``: a plan selected from the timed candidate algorithms.
+        - ``patient``: a plan selected from a wider set of timed candidates.
+
+        The tuned plans are saved to the fftw wisdom file,
+        ``~/.mrsimulator/fftw_wisdom``, and re-used in the subsequent sessions without
+        re-planning. The rigor only affects the simulation speed, not the simulated
+        spectrum.
+
+    isotropic_shift_convolution: bool (optional).
+        If true, the single-site spin systems without couplings, which differ only in
+        the isotropic chemical shift, are simulated as a distribution. The lineshape is
+        evaluated once and convolved with the abundance weighted histogram of the
+        isotropic chemical shifts. The histogram splits every shift between the two
+        nearest spectral bins, which slightly broadens the spectrum. The option is
+        ignored when the spectrum is decomposed. The default value is False.
+
+    amplitude_threshold: float (optional).
+        The fraction of the largest amplitude of a transition pathway below which the
+        octants of a sideband order are skipped in the interpolation. Useful with a
+        large number of sidebands, where the high-order sidebands carry a small
+        amplitude. A non-zero threshold trades the accuracy of the weak features for
+        speed. The octants whose frequencies lie outside the spectral window are always
+        skipped. The default value is 0, that is, no amplitude is skipped.
+
+    cache_spin_system_spectra: bool (optional).
+        If true, the Simulator keeps the spectrum of every spin system from the last
+        run, keyed by the spin system parameters, and the subsequent runs only simulate
+        the new or modified spin systems. The total spectrum is updated by subtracting
+        the spectra of the stale spin systems and adding the spectra of the new ones.
+        Useful in least-squares fitting, where a few spin systems change per step. The
+        cache is used with the ``none`` decompose_spectrum and a single job, and
+        without the isotropic_shift_convolution, which simulates the spin systems
+        together. The default value is False.
+
     Example
     -------
 
@@ -82,6 +122,10 @@ class ConfigSimulator(Parseable):
     integration_density: int = Field(default=70, gt=0)
     decompose_spectrum: Literal["none", "spin_system"] = "none"
     isotropic_interpolation: Literal["linear", "gaussian"] = "linear"
+    fftw_plan_rigor: Literal["estimate", "measure", "patient"] = "estimate"
+    isotropic_shift_convolution: bool = False
+    amplitude_threshold: float = Field(default=0.0, ge=0.0, lt=1.0)
+    cache_spin_system_spectra: bool = False
 
     class Config:
         extra = "forbid"
@@ -89,7 +133,15 @@ class ConfigSimulator(Parseable):
         validate_assignment = True
 
     def get_int_dict(self):
-        py_dict = self.dict(exclude={"property_units", "name", "description", "label"})
+        py_dict = self.dict(
+            exclude={
+                "property_units",
+                "name",
+                "description",
+                "label",
+                "cache_spin_system_spectra",
+            }
+        )
         py_dict["integration_volume"] = __integration_volume_enum__[
             self.integration_volume
         ]
@@ -99,6 +151,7 @@ class ConfigSimulator(Parseable):
         py_dict["isotropic_interpolation"] = __isotropic_interpolation_enum__[
             self.isotropic_interpolation
         ]
+        py_dict["fftw_plan_rigor"] = __fftw_plan_rigor_enum__[self.fftw_plan_rigor]
         return py_dict
 
     # averaging scheme. This contains the c pointer used in frequency evaluation
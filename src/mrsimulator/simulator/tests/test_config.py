@@ -72,6 +72,34 @@ def test_config():
     with pytest.raises(ValueError, match=f".*{error}.*"):
         a.config.isotropic_interpolation = "haha"
 
+    # fftw plan rigor
+    assert a.config.fftw_plan_rigor == "estimate"
+    a.config.fftw_plan_rigor = "measure"
+    assert a.config.fftw_plan_rigor == "measure"
+
+    error = "unexpected value; permitted: 'estimate', 'measure', 'patient'"
+    with pytest.raises(ValueError, match=f".*{error}.*"):
+        a.config.fftw_plan_rigor = "exhaustive"
+
+    # isotropic shift convolution
+    assert a.config.isotropic_shift_convolution is False
+    a.config.isotropic_shift_convolution = True
+    assert a.config.isotropic_shift_convolution is True
+
+    # amplitude threshold
+    assert a.config.amplitude_threshold == 0.0
+    a.config.amplitude_threshold = 1e-4
+    assert a.config.amplitude_threshold == 1e-4
+
+    error = "ensure this value is less than 1"
+    with pytest.raises(ValueError, match=f".*{error}.*"):
+        a.config.amplitude_threshold = 1.0
+
+    # spin system spectrum cache
+    assert a.config.cache_spin_system_spectra is False
+    a.config.cache_spin_system_spectra = True
+    assert a.config.cache_spin_system_spectra is True
+
     # number of gamma angles
     assert a.config.number_of_gamma_angles == 1
     a.config.number_of_gamma_angles = 14
@@ -89,6 +117,10 @@ def test_config():
         "integration_volume": "hemisphere",
         "integration_density": 20,
         "isotropic_interpolation": "gaussian",
+        "fftw_plan_rigor": "measure",
+        "isotropic_shift_convolution": True,
+        "amplitude_threshold": 1e-4,
+        "cache_spin_system_spectra": True,
         "name": None,
         "description": None,
         "label": None,
@@ -101,6 +133,9 @@ def test_config():
         "integration_volume": 1,
         "integration_density": 20,
         "isotropic_interpolation": 1,
+        "fftw_plan_rigor": 1,
+        "isotropic_shift_convolution": True,
+        "amplitude_threshold": 1e-4,
     }
 
     assert b != a
@@ -6,12 +6,20 @@ import csdmpy as cp
 import numpy as np
 import pytest
 from mrsimulator import Coupling
+from mrsimulator import Method
 from mrsimulator import Simulator
 from mrsimulator import Site
 from mrsimulator import SpinSystem
+from mrsimulator.base_model import clear_cache
+from mrsimulator.base_model import CompiledMethod
+from mrsimulator.base_model import set_fftw_wisdom_file
+from mrsimulator.method import MixingEvent
+from mrsimulator.method import SpectralDimension
+from mrsimulator.method import SpectralEvent
 from mrsimulator.method.lib import BlochDecayCTSpectrum
 from mrsimulator.method.lib import BlochDecaySpectrum
 from mrsimulator.simulator import __CPU_count__
+from mrsimulator.simulator import _CACHE_REBUILD_INTERVAL
 from mrsimulator.simulator import get_chunks
 from mrsimulator.simulator import Sites
 from mrsimulator.spin_system.tests.test_spin_systems import generate_isotopes
@@ -392,3 +400,387 @@ def test_parallel_chunks():
         lst[i] += 1
     items_list = np.arange(85).tolist()
     check_chunks(items_list, -1, lst)
+
+
+def test_threaded_simulation():
+    iso = np.random.normal(0, 10, 50)
+    zeta = np.random.normal(20, 5, 50)
+    spin_systems = single_site_system_generator(
+        isotope="13C",
+        isotropic_chemical_shift=iso,
+        shielding_symmetric={"zeta": zeta, "eta": 0.3},
+    )
+    spin_systems += [SpinSystem(sites=[Site(isotope="1H")])]
+
+    method = BlochDecaySpectrum(
+        channels=["13C"],
+        rotor_frequency=1000,
+        spectral_dimensions=[{"count": 1024, "spectral_width": 25000}],
+    )
+
+    sim = Simulator(spin_systems=spin_systems, methods=[method])
+    for decompose in ["none", "spin_system"]:
+        sim.config.decompose_spectrum = decompose
+        sim.run(n_threads=1, pack_as_csdm=False)
+        serial = sim.methods[0].simulation.copy()
+
+        sim.run(n_threads=4, pack_as_csdm=False)
+        threaded = sim.methods[0].simulation
+        np.testing.assert_almost_equal(serial, threaded, decimal=10)
+
+
+def test_threaded_pathway_split():
+    # fewer spin systems than threads, each with many transition pathways.
+    spin_systems = [
+        SpinSystem(
+            sites=[
+                Site(
+                    isotope="13C",
+                    isotropic_chemical_shift=10,
+                    shielding_symmetric={"zeta": 40, "eta": 0.3},
+                ),
+                Site(
+                    isotope="13C",
+                    isotropic_chemical_shift=-30,
+                    shielding_symmetric={"zeta": -20, "eta": 0.6},
+                ),
+            ],
+            couplings=[Coupling(site_index=[0, 1], isotropic_j=60, dipolar={"D": 800})],
+        ),
+        SpinSystem(
+            sites=[
+                Site(isotope="13C", isotropic_chemical_shift=50),
+                Site(isotope="1H", isotropic_chemical_shift=2),
+            ],
+            couplings=[Coupling(site_index=[0, 1], isotropic_j=150)],
+        ),
+    ]
+    query = [{"ch1": {"P": [-1]}}]
+    method = Method(
+        channels=["13C"],
+        spectral_dimensions=[
+            SpectralDimension(
+                count=1024,
+                spectral_width=25000,
+                events=[
+                    SpectralEvent(fraction=0.5, transition_queries=query),
+                    MixingEvent(query={"ch1": {"angle": np.pi / 2}}),
+                    SpectralEvent(fraction=0.5, transition_queries=query),
+                ],
+            )
+        ],
+    )
+    assert all(len(method.get_transition_pathways(sys)) > 1 for sys in spin_systems)
+
+    sim = Simulator(spin_systems=spin_systems, methods=[method])
+    for decompose in ["none", "spin_system"]:
+        sim.config.decompose_spectrum = decompose
+        sim.run(n_threads=1, pack_as_csdm=False)
+        serial = sim.methods[0].simulation.copy()
+
+        sim.run(n_threads=4, pack_as_csdm=False)
+        threaded = sim.methods[0].simulation
+        np.testing.assert_almost_equal(serial, threaded, decimal=10)
+
+
+def test_cached_orientation_tables():
+    spin_systems = single_site_system_generator(
+        isotope="27Al",
+        isotropic_chemical_shift=[10, 40],
+        quadrupolar={"Cq": 3.1e6, "eta": 0.2},
+    )
+    method = BlochDecayCTSpectrum(
+        channels=["27Al"],
+        rotor_frequency=5000,
+        spectral_dimensions=[{"count": 512, "spectral_width": 50000}],
+    )
+
+    sim = Simulator(spin_systems=spin_systems, methods=[method])
+    sim.run(pack_as_csdm=False)
+    fresh = sim.methods[0].simulation.copy()
+
+    # second run re-uses the cached orientation tables and fftw plans.
+    sim.run(pack_as_csdm=False)
+    np.testing.assert_almost_equal(fresh, sim.methods[0].simulation, decimal=12)
+
+    # a different integration density must not pick up the cached tables.
+    sim.config.integration_density = 40
+    sim.run(pack_as_csdm=False)
+    assert not np.allclose(fresh, sim.methods[0].simulation, atol=1e-12)
+
+    clear_cache()
+    sim.config.integration_density = 70
+    sim.run(pack_as_csdm=False)
+    np.testing.assert_almost_equal(fresh, sim.methods[0].simulation, decimal=12)
+
+
+def test_compiled_method():
+    spin_systems = single_site_system_generator(
+        isotope=["13C", "1H", "13C"],
+        isotropic_chemical_shift=[10, 20, -15],
+        shielding_symmetric={"zeta": 50, "eta": 0.3},
+    )
+    method = BlochDecaySpectrum(
+        channels=["13C"],
+        rotor_frequency=2000,
+        spectral_dimensions=[{"count": 1024, "spectral_width": 25000}],
+    )
+    sim = Simulator(spin_systems=spin_systems, methods=[method])
+    compiled = CompiledMethod(method, **sim.config.get_int_dict())
+
+    for zeta in [50, -30, 80]:
+        for sys in spin_systems:
+            sys.sites[0].shielding_symmetric.zeta = zeta
+        sim.run(pack_as_csdm=False)
+        np.testing.assert_almost_equal(
+            compiled.simulate(spin_systems), sim.methods[0].simulation[0], decimal=10
+        )
+
+
+def test_compiled_method_simulate_sites():
+    n = 20
+    iso = np.random.normal(0, 10, n)
+    Cq = np.random.normal(3.0e6, 1.0e5, n)
+    eta = np.random.rand(n)
+    abundance = np.random.rand(n) * 50 + 50
+    spin_systems = single_site_system_generator(
+        isotope="27Al",
+        isotropic_chemical_shift=iso,
+        quadrupolar={"Cq": Cq, "eta": eta},
+        abundance=abundance,
+    )
+    method = BlochDecayCTSpectrum(
+        channels=["27Al"],
+        rotor_frequency=10000,
+        spectral_dimensions=[{"count": 512, "spectral_width": 50000}],
+    )
+    sim = Simulator(spin_systems=spin_systems, methods=[method])
+
+    for decompose in ["none", "spin_system"]:
+        sim.config.decompose_spectrum = decompose
+        compiled = CompiledMethod(method, **sim.config.get_int_dict())
+        from_objects = compiled.simulate(spin_systems)
+        from_arrays = compiled.simulate_sites(
+            iso,
+            quadrupolar_Cq=Cq,
+            quadrupolar_eta=eta,
+            abundance=[sys.abundance for sys in spin_systems],
+        )
+        np.testing.assert_almost_equal(from_objects, from_arrays, decimal=10)
+
+
+def test_simulator_compiled_methods():
+    sim = get_mas_simulator([10, -20])
+
+    def compiled_method():
+        kwargs = sim.config.get_int_dict()
+        return sim._compiled_method(0, sim.methods[0], number_of_threads=1, **kwargs)
+
+    def check_simulation():
+        expected = CompiledMethod(sim.methods[0], **sim.config.get_int_dict())
+        np.testing.assert_almost_equal(
+            sim.methods[0].simulation[0], expected.simulate(sim.spin_systems), 12
+        )
+
+    sim.run(pack_as_csdm=False)
+    compiled = compiled_method()
+
+    # the tensor parameters only re-evaluate the spin systems.
+    sim.spin_systems[0].sites[0].isotropic_chemical_shift = 5
+    sim.run(pack_as_csdm=False)
+    assert compiled_method() is compiled
+    check_simulation()
+
+    # the method and config parameters recompile the method.
+    sim.methods[0].spectral_dimensions[0].spectral_width = 25000
+    sim.run(pack_as_csdm=False)
+    assert compiled_method() is not compiled
+    check_simulation()
+
+    compiled = compiled_method()
+    sim.config.number_of_sidebands = 8
+    sim.run(pack_as_csdm=False)
+    assert compiled_method() is not compiled
+    check_simulation()
+
+    # the compiled methods are not copied with the simulator.
+    assert sim.copy(deep=True)._compiled_methods == {}
+
+
+
+def get_mas_simulator(
+    isotropic_chemical_shift,
+    zeta=60,
+    rotor_frequency=1500,
+    count=1024,
+    spectral_width=30000,
+    abundance=None,
+):
+    """A simulator of 13C sites with a Bloch decay method and 16 sidebands."""
+    spin_systems = single_site_system_generator(
+        isotope="13C",
+        isotropic_chemical_shift=isotropic_chemical_shift,
+        shielding_symmetric={"zeta": zeta, "eta": 0.4},
+        abundance=abundance,
+    )
+    method = BlochDecaySpectrum(
+        channels=["13C"],
+        rotor_frequency=rotor_frequency,
+        spectral_dimensions=[{"count": count, "spectral_width": spectral_width}],
+    )
+    sim = Simulator(spin_systems=spin_systems, methods=[method])
+    sim.config.number_of_sidebands = 16
+    return sim
+
+
+def test_fftw_plan_rigor(tmp_path):
+    sim = get_mas_simulator([10, -20])
+    sim.config.number_of_sidebands = 48
+    sim.run(pack_as_csdm=False)
+    estimate = sim.methods[0].simulation.copy()
+
+    wisdom = tmp_path / "fftw_wisdom"
+    set_fftw_wisdom_file(wisdom)
+    try:
+        sim.config.fftw_plan_rigor = "measure"
+        sim.run(pack_as_csdm=False)
+        np.testing.assert_almost_equal(estimate, sim.methods[0].simulation, decimal=10)
+        assert wisdom.is_file()
+    finally:
+        set_fftw_wisdom_file(None)
+
+
+def assert_within_one_bin(spectrum, reference, atol):
+    """Assert that every point of the spectrum lies within the range of the reference
+    over the point and its nearest neighbours, i.e., within one bin of broadening."""
+    padded = np.pad(reference, 1, mode="edge")
+    neighbours = [
+        padded[tuple(slice(i, i + n) for i, n in zip(index, reference.shape))]
+        for index in np.ndindex(*(3,) * reference.ndim)
+    ]
+    assert np.all(spectrum >= np.min(neighbours, axis=0) - atol)
+    assert np.all(spectrum <= np.max(neighbours, axis=0) + atol)
+
+
+def test_isotropic_shift_convolution():
+    # evenly spaced shifts with gaussian abundances, a smooth distribution
+    shifts = np.linspace(-15, 15, 301)
+    sim = get_mas_simulator(shifts, abundance=np.exp(-(shifts**2) / 50))
+    # a 2D correlation of the finite and the infinite speed MAS lineshapes
+    query = [{"ch1": {"P": [-1]}}]
+    sim.methods.append(
+        Method(
+            channels=["13C"],
+            rotor_frequency=1500,
+            spectral_dimensions=[
+                {
+                    "count": 128,
+                    "spectral_width": 30000,
+                    "events": [{"transition_queries": query}],
+                },
+                {
+                    "count": 128,
+                    "spectral_width": 10000,
+                    "events": [{"rotor_frequency": 1e12, "transition_queries": query}],
+                },
+            ],
+        )
+    )
+    sim.run(pack_as_csdm=False)
+    default = [method.simulation.real.copy() for method in sim.methods]
+
+    sim.config.isotropic_shift_convolution = True
+    sim.run(pack_as_csdm=False)
+
+    # the histogram conserves the intensity, and broadens the lineshape by a bin
+    for method, reference in zip(sim.methods, default):
+        convolved = method.simulation.real
+        np.testing.assert_almost_equal(convolved.sum() / reference.sum(), 1, decimal=8)
+        assert_within_one_bin(convolved, reference, atol=0.05 * reference.max())
+
+
+def test_amplitude_threshold():
+    sim = get_mas_simulator(
+        [-20, 0, 30], zeta=100, rotor_frequency=500, count=512, spectral_width=10000
+    )
+    sim.config.number_of_sidebands = 64
+    sim.run(pack_as_csdm=False)
+    default = sim.methods[0].simulation.copy()
+
+    sim.config.amplitude_threshold = 1e-8
+    sim.run(pack_as_csdm=False)
+    atol = 1e-6 * np.abs(default).max()
+    np.testing.assert_allclose(sim.methods[0].simulation, default, atol=atol)
+
+    # the skipped octants of the weak sidebands only remove intensity.
+    sim.config.amplitude_threshold = 1e-2
+    sim.run(pack_as_csdm=False)
+    ratio = sim.methods[0].simulation.real.sum() / default.real.sum()
+    assert 0.95 < ratio <= 1 + 1e-12
+
+
+def test_cache_spin_system_spectra():
+    sim = get_mas_simulator([10, -20, 30, 0])
+    sim.config.cache_spin_system_spectra = True
+
+    def compare():
+        sim.run(pack_as_csdm=False)
+        ref = get_mas_simulator(0)
+        ref.spin_systems = sim.spin_systems
+        ref.run(pack_as_csdm=False)
+        np.testing.assert_almost_equal(
+            sim.methods[0].simulation, ref.methods[0].simulation, decimal=10
+        )
+
+    compare()
+    spectra = dict(sim._spectrum_cache[0]["spectra"])
+
+    # only the modified spin system is simulated.
+    sim.spin_systems[1].sites[0].isotropic_chemical_shift = 5
+    compare()
+    updated = sim._spectrum_cache[0]["spectra"]
+    assert len(set(spectra) & set(updated)) == 3
+    assert all(updated[k] is spectra[k] for k in set(spectra) & set(updated))
+
+    # removed and duplicate spin systems
+    sim.spin_systems = sim.spin_systems[:2] + [sim.spin_systems[0].copy()]
+    compare()
+    assert len(sim._spectrum_cache[0]["spectra"]) == 2
+
+    # the cache is released when disabled.
+    sim.config.cache_spin_system_spectra = False
+    sim.run(pack_as_csdm=False)
+    assert sim._spectrum_cache == {}
+
+
+def test_cache_spin_system_spectra_isotropic_shift_convolution():
+    sim = get_mas_simulator([10, -20, 30, 0])
+    sim.config.isotropic_shift_convolution = True
+    sim.run(pack_as_csdm=False)
+    expected = sim.methods[0].simulation
+
+    # the convolved spectrum is not replaced by the cached spin system spectra.
+    sim.config.cache_spin_system_spectra = True
+    sim.run(pack_as_csdm=False)
+    assert sim._spectrum_cache == {}
+    np.testing.assert_almost_equal(sim.methods[0].simulation, expected, decimal=12)
+
+
+def test_cache_spin_system_spectra_repeated_updates():
+    sim = get_mas_simulator([10, -20, 30, 0])
+    sim.config.cache_spin_system_spectra = True
+
+    # many alternating updates of a single spin system do not accumulate round-off.
+    site = sim.spin_systems[1].sites[0]
+    for i in range(150):
+        site.isotropic_chemical_shift = -20 if i % 2 else 5
+        sim.run(pack_as_csdm=False)
+    assert sim._spectrum_cache[0]["updates"] < _CACHE_REBUILD_INTERVAL
+
+    ref = get_mas_simulator(0)
+    ref.spin_systems = sim.spin_systems
+    ref.run(pack_as_csdm=False)
+    expected = ref.methods[0].simulation
+    np.testing.assert_allclose(
+        sim.methods[0].simulation, expected, rtol=0, atol=1e-12 * np.abs(expected).max()
+    )
@@ -1,7 +1,10 @@
+from copy import deepcopy
+
 import mrsimulator.signal_processor as sp
 import numpy as np
 from lmfit import Parameters
 from mrsimulator import Simulator
+from mrsimulator.base_model import CompiledMethod
 
 __author__ = ["Maxwell C Venetos", "Deepansh Srivastava"]
 __email__ = ["maxvenetos@gmail.com", "srivastava.89@osu.edu"]
@@ -47,6 +50,9 @@ EXCLUDE = [
     "transition_pathways",
 ]
 
+# The relative forward-difference step of the Jacobian.
+FD_STEP = 1.0e-7
+
 POST_SIM_DICT = {
     "Gaussian": {"FWHM": "FWHM"},
     "Exponential": {"FWHM": "FWHM"},
@@ -329,6 +335,14 @@ def make_LMFIT_params(sim: Simulator, processors: list = None, include={}):
     return params
 
 
+def _set_object_value(obj, ids, value):
+    """Set the attribute, given as a decoded list of attributes and indexes, of the
+    object to value, without validation."""
+    for attr in ids[:-1]:
+        obj = obj[int(attr)] if attr.isnumeric() else obj.__dict__[attr]
+    obj.__dict__[ids[-1]] = value
+
+
 def _update_simulator_from_LMFIT_params(params, sim: Simulator):
     """Parse the string representing the Simulator object dictionary tree format, and
     set its value to the input.
@@ -344,10 +358,7 @@ def _update_simulator_from_LMFIT_params(params, sim: Simulator):
     """
 
     def set_sys_value(obj, key, value):
-        ids = _str_decode(key)
-        for attr in ids[:-1]:
-            obj = obj[int(attr)] if attr.isnumeric() else obj.__dict__[attr]
-        obj.__dict__[ids[-1]] = value
+        _set_object_value(obj, _str_decode(key), value)
 
     def set_mth_value(obj, key, value):
         index = int(key.split("_")[1])
@@ -430,7 +441,11 @@ def _check_for_experiment_data(methods_list: list):
 
 
 def LMFIT_min_function(
-    params: Parameters, sim: Simulator, processors: list = None, sigma: list = None
+    params: Parameters,
+    sim: Simulator,
+    processors: list = None,
+    sigma: list = None,
+    n_threads: int = 1,
 ):
     """The simulation routine to calculate the vector difference between simulation and
     experiment based on the parameters update.
@@ -442,6 +457,7 @@ def LMFIT_min_function(
             Simulator object.
         sigma: A list of standard deviations corresponding to the experiments in the
             Simulator.methods attribute
+        int n_threads: The number of threads used in simulating the spin systems.
     Returns:
         Array of the differences between the simulation and the experimental datasets.
     """
@@ -452,11 +468,24 @@ def LMFIT_min_function(
     _check_for_experiment_data(sim.methods)
     update_mrsim_obj_from_params(params, sim, processors)
 
-    sim.run()
+    sim.run(n_threads=n_threads)
+
+    datasets = [mth.simulation for mth in sim.methods]
+    return _residual_vector(sim, datasets, processors, sigma)
 
+
+def _residual_vector(sim: Simulator, datasets: list, processors: list, sigma: list):
+    """Return the vector difference between the experiments and the processed
+    simulations.
+
+    Args:
+        sim: Simulator object.
+        datasets: A list of the simulated CSDM objects, one per method.
+        processors: A list of SignalProcessor objects, one per method.
+        sigma: A list of the standard deviations of the experiments.
+    """
     processed_dataset = [
-        item.apply_operations(dataset=data.simulation)
-        for item, data in zip(processors, sim.methods)
+        item.apply_operations(dataset=data) for item, data in zip(processors, datasets)
     ]
 
     diff = np.asarray([])
@@ -470,6 +499,170 @@ def LMFIT_min_function(
     return diff
 
 
+class _Values:
+    """A stand-in for the Parameters object with the given parameter values."""
+
+    def __init__(self, values):
+        self.values = values
+
+    def valuesdict(self):
+        return self.values
+
+
+def _parameter_step(param):
+    """Forward-difference step of the parameter, reversed at the upper bound."""
+    step = FD_STEP * max(abs(param.value), 1.0)
+    return -step if param.value + step > param.max else step
+
+
+def LMFIT_jacobian(
+    params: Parameters,
+    sim: Simulator,
+    processors: list = None,
+    sigma: list = None,
+    n_threads: int = 1,
+):
+    """The forward-difference Jacobian of the `LMFIT_min_function` residuals with
+    respect to the varying parameters, for use as the `Dfun` argument of the LMFIT
+    `leastsq` minimization.
+
+    Each parameter from `make_simulator_params` belongs to a spin system, therefore,
+    a Jacobian column only re-simulates the spin systems whose parameters change with
+    the perturbed parameter, including the parameters constrained by expressions,
+    instead of all spin systems. The perturbed spin systems of all columns are
+    simulated together over `n_threads` threads. The SignalProcessor parameters only
+    re-process the spectrum, and the method parameters re-simulate all spin systems
+    with the perturbed method. With the `isotropic_shift_convolution` config, every
+    column re-simulates all spin systems, as the convolution applies to the summed
+    spectrum only.
+
+    Args:
+        params: Parameters object containing parameters for OLS minimization.
+        sim: Simulator object.
+        processors: A list of PostSimulator objects corresponding to the methods in the
+            Simulator object.
+        sigma: A list of standard deviations corresponding to the experiments in the
+            Simulator.methods attribute.
+        int n_threads: The number of threads used in simulating the spin systems.
+
+    Returns:
+        A 2D array of shape (residuals, varying parameters).
+
+    Example:
+        >>> minner = Minimizer(
+        ...     LMFIT_min_function, params, fcn_args=(sim, processors, sigma)
+        ... ) # doctest:+SKIP
+        >>> result = minner.minimize(
+        ...     method="leastsq", Dfun=LMFIT_jacobian
+        ... ) # doctest:+SKIP
+    """
+    processors = processors if isinstance(processors, list) else [processors]
+    sigma = [1.0 for _ in sim.methods] if sigma is None else sigma
+    sigma = sigma if isinstance(sigma, list) else [sigma]
+
+    _check_for_experiment_data(sim.methods)
+    update_mrsim_obj_from_params(params, sim, processors)
+    base = params.valuesdict()
+    names = [name for name, param in params.items() if param.vary]
+
+    # The parameters changed by every column, including the constrained parameters.
+    steps, changes = [], []
+    for name in names:
+        value = params[name].value
+        try:
+            params[name].value = value + _parameter_step(params[name])
+            steps.append(params[name].value - value)
+            params.update_constraints()
+            values = params.valuesdict()
+            changes.append({k: v for k, v in values.items() if v != base[k]})
+        finally:
+            params[name].value = value
+            params.update_constraints()
+
+    # The perturbed copies of the spin systems, simulated along with the originals.
+    systems = list(sim.spin_systems)
+    perturbed = []
+    for change in changes:
+        column = {}
+        for key, value in change.items():
+            if not key.startswith(START):
+                continue
+            ids = _str_decode(key)
+            index = int(ids[1])
+            if index not in column:
+                column[index] = len(systems)
+                systems.append(sim.spin_systems[index].copy(deep=True))
+            _set_object_value(systems[column[index]], ids[2:], value)
+        perturbed.append(column)
+
+    # The isotropic shift convolution only applies to the summed spectrum, therefore,
+    # the columns are then simulated in full, as in the `LMFIT_min_function`.
+    kwargs = sim.config.get_int_dict()
+    convolved = sim.config.isotropic_shift_convolution
+    convolved = convolved and sim.config.decompose_spectrum == "none"
+    if not convolved:
+        kwargs.update(decompose_spectrum=1)
+
+    def simulate(methods, spin_systems):
+        """The spectra of the spin systems, one per method, decomposed if not
+        convolved."""
+        amp = []
+        for i, (mth, mth_) in enumerate(zip(sim.methods, methods)):
+            compiled = (
+                sim._compiled_method(i, mth, number_of_threads=n_threads, **kwargs)
+                if mth_ is mth
+                else CompiledMethod(mth_, number_of_threads=n_threads, **kwargs)
+            )
+            amp.append(compiled.simulate(spin_systems))
+        return amp
+
+    n_sys = len(sim.spin_systems)
+    if convolved:
+        totals = simulate(sim.methods, sim.spin_systems)
+    else:
+        spectra = simulate(sim.methods, systems)
+        totals = [np.sum(amp[:n_sys], axis=0) for amp in spectra]
+
+    def as_csdm(amp):
+        return [sim._as_csdm_object([a], mth) for a, mth in zip(amp, sim.methods)]
+
+    jacobian = []
+    for change, column in zip(changes, perturbed):
+        procs = processors
+        if any(key.startswith("SP_") for key in change):
+            procs = deepcopy(processors)
+            _update_processors_from_LMFIT_params(_Values({**base, **change}), procs)
+
+        methods = sim.methods
+        if any(key.startswith("mth_") for key in change):
+            sim_ = sim.copy()
+            sim_.methods = [mth.copy(deep=True) for mth in sim.methods]
+            values = {k: v for k, v in change.items() if k.startswith("mth_")}
+            _update_simulator_from_LMFIT_params(_Values(values), sim_)
+            methods = sim_.methods
+
+        if convolved or methods is not sim.methods:
+            column_systems = list(sim.spin_systems)
+            for i, j in column.items():
+                column_systems[i] = systems[j]
+            amp = simulate(methods, column_systems)
+            amp = amp if convolved else [np.sum(a, axis=0) for a in amp]
+        else:
+            amp = [
+                total + sum(a[j] - a[i] for i, j in column.items())
+                for total, a in zip(totals, spectra)
+            ]
+        residual = _residual_vector(sim, as_csdm(amp), procs, sigma)
+        jacobian.append(residual)
+
+    # the spectra wrapped by the base datasets may be processed in place, hence last.
+    residual = _residual_vector(sim, as_csdm(totals), processors, sigma)
+    if names == []:
+        return np.zeros((residual.size, 0))
+    jacobian = (np.asarray(jacobian) - residual) / np.asarray(steps)[:, np.newaxis]
+    return jacobian.T
+
+
 def bestfit(sim: Simulator, processors: list = None):
     """Return a list of best fit spectrum ordered relative to the methods in the
     simulator object.
@@ -357,3 +357,112 @@ def test_7():
     # params = sf.make_LMFIT_params(sim, processor)
     # a = sf.LMFIT_min_function(params, sim, processor)
     # np.testing.assert_almost_equal(-a.sum(), dataset.sum().real, decimal=8)
+
+
+def setup_jacobian_simulator(spin_systems):
+    sim = Simulator(spin_systems=spin_systems)
+    sim.methods = [
+        BlochDecaySpectrum(
+            channels=["13C"],
+            rotor_frequency=2000,
+            spectral_dimensions=[{"count": 512, "spectral_width": 25000}],
+        )
+    ]
+    sim.config.number_of_sidebands = 16
+    sim.methods[0].experiment = cp.as_csdm(np.zeros(512))
+    processor = sp.SignalProcessor(
+        operations=[
+            sp.IFFT(dim_index=0),
+            sp.apodization.Exponential(FWHM="200 Hz", dim_index=0),
+            sp.FFT(dim_index=0),
+            sp.Scale(factor=2),
+        ]
+    )
+    return sim, processor
+
+
+def check_jacobian(params, sim, processor):
+    """Compare the Jacobian with the brute-force forward differences of the full
+    simulation."""
+    jacobian = sf.LMFIT_jacobian(params, sim, processor, n_threads=2)
+    names = [name for name, param in params.items() if param.vary]
+    assert jacobian.shape == (512, len(names))
+
+    residual = sf.LMFIT_min_function(params, sim, processor)
+    for j, name in enumerate(names):
+        value = params[name].value
+        params[name].value = value + sf._parameter_step(params[name])
+        params.update_constraints()
+        step = params[name].value - value
+        column = (sf.LMFIT_min_function(params, sim, processor) - residual) / step
+        params[name].value = value
+        params.update_constraints()
+        np.testing.assert_allclose(
+            jacobian[:, j], column, atol=1e-6 * np.abs(column).max(), err_msg=name
+        )
+
+
+def test_LMFIT_jacobian():
+    sys1 = SpinSystem(
+        sites=[Site(isotope="13C", isotropic_chemical_shift=10)], abundance=60
+    )
+    sys2 = SpinSystem(
+        sites=[
+            Site(
+                isotope="13C",
+                isotropic_chemical_shift=-20,
+                shielding_symmetric={"zeta": 40, "eta": 0.3},
+            )
+        ],
+        abundance=40,
+    )
+    sim, processor = setup_jacobian_simulator([sys1, sys2])
+    params = sf.make_LMFIT_params(sim, processor)
+    params["sys_1_site_0_shielding_symmetric_eta"].vary = False
+    check_jacobian(params, sim, processor)
+
+
+def test_LMFIT_jacobian_method_expression():
+    sys1 = SpinSystem(
+        sites=[Site(isotope="13C", isotropic_chemical_shift=10)], abundance=60
+    )
+    sys2 = SpinSystem(
+        sites=[
+            Site(
+                isotope="13C",
+                isotropic_chemical_shift=-20,
+                shielding_symmetric={"zeta": 40, "eta": 0.3},
+            )
+        ],
+        abundance=40,
+    )
+    sim, processor = setup_jacobian_simulator([sys1, sys2])
+    params = sf.make_LMFIT_params(sim, processor, include={"rotor_frequency"})
+
+    # a spin system parameter constrained by the method parameter.
+    params["sys_1_site_0_isotropic_chemical_shift"].expr = "-mth_0_rotor_frequency/100"
+    params.update_constraints()
+    varying = ["mth_0_rotor_frequency", "sys_0_site_0_isotropic_chemical_shift"]
+    for name in params:
+        params[name].vary = params[name].vary and name in varying
+    check_jacobian(params, sim, processor)
+
+
+def test_LMFIT_jacobian_isotropic_shift_convolution():
+    spin_systems = [
+        SpinSystem(
+            sites=[
+                Site(
+                    isotope="13C",
+                    isotropic_chemical_shift=iso,
+                    shielding_symmetric={"zeta": 40, "eta": 0.3},
+                )
+            ],
+            abundance=abundance,
+        )
+        for iso, abundance in zip([-20, 0, 15], [30, 50, 20])
+    ]
+    sim, processor = setup_jacobian_simulator(spin_systems)
+    sim.config.isotropic_shift_convolution = True
+    params = sf.make_LMFIT_params(sim, processor)
+    check_jacobian(params, sim, processor)
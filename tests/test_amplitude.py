@@ -1,4 +1,5 @@
 """Test amplitude for shift, reference offset, points, orientation averaging."""
+import mrsimulator.tests.tests as clib
 import numpy as np
 from mrsimulator import Simulator
 from mrsimulator import Site
@@ -105,3 +106,30 @@ def test_gamma_averaging():
 
     e = "Integral error from number_of_gamma_angles"
     np.testing.assert_almost_equal(y_static, y_static_2, decimal=8, err_msg=e)
+
+
+def test_direct_dft_sideband_amplitudes():
+    # orientation counts span multiple blocks of the kernel, odd and even sidebands.
+    for n, number_of_sidebands in [(1, 2), (70, 5), (300, 8), (1030, 15), (129, 16)]:
+        phase = 2 * np.pi * np.random.rand(number_of_sidebands, n)
+        factors = np.exp(1j * phase)
+        amp_c = clib.sideband_amplitudes_direct(factors)
+        amp_py = np.abs(np.fft.fft(factors, axis=0)) ** 2
+        np.testing.assert_almost_equal(amp_c, amp_py, decimal=8)
+
+
+def test_direct_dft_sideband_integral_amplitude():
+    # 16 sidebands use the direct DFT and 32 sidebands use the fftw plan.
+    sim = pre_setup()
+    sim.methods[0].spectral_dimensions[0].events[0].rotor_frequency = 5000  # in Hz
+    sim.config.number_of_sidebands = 16
+    sim.run()
+    y_direct = sim.methods[0].simulation.y[0].components[0]
+
+    sim.config.number_of_sidebands = 32
+    sim.run()
+    y_fft = sim.methods[0].simulation.y[0].components[0]
+
+    e = "Integral error from direct DFT sideband amplitudes."
+    np.testing.assert_almost_equal(y_direct.sum(), y_fft.sum(), decimal=8, err_msg=e)
+    np.testing.assert_allclose(y_direct, y_fft, atol=1e-5 * y_fft.max())
@@ -30,3 +30,28 @@ def test_phase_components_3():
     pre_phase_c = clib.pre_phase_components(number_of_sidebands, spin_frequency)
 
     assert np.allclose(pre_phase_c, 2 * pre_phase_py[:4, :])
+
+
+def sideband_phase_factors_setup(n, number_of_sidebands, rank_4):
+    w2 = np.random.rand(n, 3) - 0.5 + 1j * (np.random.rand(n, 3) - 0.5)
+    w4 = np.random.rand(n, 5) - 0.5 + 1j * (np.random.rand(n, 5) - 0.5)
+    pre_phase = clib.pre_phase_components(number_of_sidebands, 1e3)
+    pre_phase_2, pre_phase_4 = pre_phase[2:], pre_phase
+
+    phase = (pre_phase_2.T @ w2[:, :2].T).imag
+    if not rank_4:
+        return clib.sideband_phase_factors(w2, pre_phase_2), np.exp(1j * phase)
+
+    phase += (pre_phase_4.T @ w4[:, :4].T).imag
+    factors = clib.sideband_phase_factors(w2, pre_phase_2, w4, pre_phase_4)
+    return factors, np.exp(1j * phase)
+
+
+def test_sideband_phase_factors():
+    # sizes span multiple orientation blocks of the kernel.
+    for n, number_of_sidebands in [(1, 8), (300, 16), (1030, 64)]:
+        for rank_4 in [False, True]:
+            factors_c, factors_py = sideband_phase_factors_setup(
+                n, number_of_sidebands, rank_4
+            )
+            np.testing.assert_almost_equal(factors_c, factors_py, decimal=6)
@@ -4,9 +4,8 @@ import numpy as np
 from tests.python_test_for_c_code.angular_momentum import wigner_rotation
 
 
-def test__batch_wigner_rotation():
+def batch_wigner_rotation_setup(n_octants):
     n = 40
-    n_octants = 1
     alpha = np.random.rand(n) * np.pi / 2.0
     beta = np.random.rand(n) * np.pi / 2.0
 
@@ -35,7 +34,8 @@ def test__batch_wigner_rotation():
         n, n_octants, wigner_2j_matrices, R2, wigner_4j_matrices, R4, exp_im_alpha
     )
 
-    # assert np.allclose(exp_im_alpha_in, exp_im_alpha, atol=1e-15)
+    # the exp(-Im alpha) table is read-only.
+    assert np.allclose(exp_im_alpha_in, exp_im_alpha, atol=1e-15)
 
     alpha_octants = []
     for i in range(n_octants):
@@ -56,6 +56,14 @@ def test__batch_wigner_rotation():
     np.testing.assert_almost_equal(w4, w4_1, decimal=8)
 
 
+def test__batch_wigner_rotation():
+    batch_wigner_rotation_setup(n_octants=1)
+
+
+def test__batch_wigner_rotation_hemisphere():
+    batch_wigner_rotation_setup(n_octants=4)
+
+
 def test_single_2j_rotation_00():
     ang_momentum_l = 2
     R_in = np.asarray([0 + 0.5j, 0, 0 + 0.1j, 0, 0 - 0.5j], dtype=np.complex128)
@@ -212,3 +220,50 @@ def test_single_nj_rotation_to_wigner_rotation():
             np.testing.assert_almost_equal(
                 R_out[:n_], R_out_2, decimal=8, err_msg=f"Error l={ang_l}, index={_}"
             )
+
+
+def test_wigner_rotation_soa_kernel():
+    # the size spans multiple orientation blocks of the SoA kernel.
+    n = 1000
+    cos_beta = 2.0 * np.random.rand(n) - 1.0
+    cos_alpha = 2.0 * np.random.rand(n) - 1.0
+    for ang_l in [2, 4]:
+        R_in = np.random.rand(2 * ang_l + 1) + 1j * np.random.rand(2 * ang_l + 1)
+        wigner, wigner_soa, exp_im_alpha = clib.wigner_rotation_tables(
+            ang_l, cos_alpha, cos_beta
+        )
+        R_out_aos = np.zeros((ang_l + 1) * n, dtype=np.complex128)
+        R_out_soa = np.zeros((ang_l + 1) * n, dtype=np.complex128)
+        clib.wigner_rotation_kernel(
+            ang_l, wigner, exp_im_alpha, R_in, R_out_aos, soa=False
+        )
+        clib.wigner_rotation_kernel(ang_l, wigner_soa, exp_im_alpha, R_in, R_out_soa)
+        np.testing.assert_almost_equal(R_out_aos, R_out_soa, decimal=12)
+
+
+def test_wigner_rotation_gemm_kernel():
+    n, n_systems, n_octants = 300, 17, 4
+    cos_beta = 2.0 * np.random.rand(n) - 1.0
+    cos_alpha = 2.0 * np.random.rand(n) - 1.0
+    for ang_l in [2, 4]:
+        n1 = 2 * ang_l + 1
+        R_in = np.random.rand(n_systems, n1) + 1j * np.random.rand(n_systems, n1)
+        _, wigner_soa, exp_im_alpha = clib.wigner_rotation_tables(
+            ang_l, cos_alpha, cos_beta
+        )
+        matrix = clib.wigner_rotation_gemm_matrix(ang_l, wigner_soa, exp_im_alpha)
+        R_out = np.empty(n_octants * 2 * (ang_l + 1) * n * n_systems)
+        clib.wigner_rotation_gemm_kernel(ang_l, matrix, R_in, R_out, n_octants)
+        R_out = R_out.reshape(n_octants, 2, ang_l + 1, n, n_systems)
+        R_out = R_out[:, 0] + 1j * R_out[:, 1]
+
+        # the j^th octant is the rotation of R(m) (-i)^(mj) over the first octant.
+        m = np.arange(-ang_l, ang_l + 1)
+        for j in range(n_octants):
+            for s in range(n_systems):
+                R_j = np.asarray(R_in[s] * (-1j) ** (m * j), dtype=np.complex128)
+                R_ref = np.zeros((ang_l + 1) * n, dtype=np.complex128)
+                clib.wigner_rotation_kernel(ang_l, wigner_soa, exp_im_alpha, R_j, R_ref)
+                np.testing.assert_almost_equal(
+                    R_out[j, :, :, s], R_ref.reshape(n, ang_l + 1).T, decimal=12
+                )